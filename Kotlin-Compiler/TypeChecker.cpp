@@ -1,6 +1,11 @@
-#include "typechecker.h"
+#include "TypeChecker.h"
+#include "passes.h"
 #include <iostream>
 #include <stdexcept>
+#include <thread>
+#include <atomic>
+#include <cstdint>
+#include <memory>
 using namespace std;
 
 
@@ -29,101 +34,92 @@ Type* Program::accept(TypeVisitor* v) { return v->visit(this); }
 //   Constructor del TypeChecker
 // ===========================================================
 
-TypeChecker::TypeChecker() {
-    intType = new Type(Type::INT);
-    boolType = new Type(Type::BOOL);
-    voidType = new Type(Type::VOID);
-    stringType = new Type(Type::STRING); // Agregado
-    rangeType = new Type(Type::RANGE); // Agregado
-    currentVarCount = 0;
+TypeChecker::TypeChecker(TypeTable& tipos) : tipos(&tipos) {
+    intType = tipos.get(Type::INT);
+    boolType = tipos.get(Type::BOOL);
+    voidType = tipos.get(Type::VOID);
+    stringType = tipos.get(Type::STRING); // Agregado
+    rangeType = tipos.get(Type::RANGE); // Agregado
+
+    conversions = {
+        {"toByte", Type::BYTE},
+        {"toShort", Type::SHORT},
+        {"toInt", Type::INT},
+        {"toLong", Type::LONG},
+        {"toFloat", Type::FLOAT},
+        {"toDouble", Type::DOUBLE},
+        {"toUByte", Type::UBYTE},
+        {"toUShort", Type::USHORT},
+        {"toUInt", Type::UINT},
+        {"toULong", Type::ULONG}
+    };
 }
 
 // ===========================================================
 //   Registrar funciones globales
 // ===========================================================
 
-// Ayuda para inferir tipo de retorno a partir del cuerpo de la función
-Type* TypeChecker::inferReturnType(Stm* s) {
-    if (!s) return nullptr;
-
-    if (ReturnStm* ret = dynamic_cast<ReturnStm*>(s)) {
-        if (ret->e) {
-            return ret->e->accept(this);
-        } else {
-            return voidType;
-        }
+// Registra la firma. Si no declara tipo de retorno, queda pendiente: lo fija
+// el primer `return` que encuentre visit(FunDec*), sin recorrer el cuerpo aparte.
+void TypeChecker::add_function(FunDec* fd) {
+    if (functions.find(fd->nombre) != functions.end()) {
+        error(string("Error: función '") + fd->nombre + "' ya fue declarada.");
     }
 
-    if (Block* b = dynamic_cast<Block*>(s)) {
-        for (Stm* stmt : b->stmts) {
-            Type* t = inferReturnType(stmt);
-            if (t) return t;
+    for (size_t i = 0; i < fd->Pnombres.size(); ++i) {
+        // Se asume que los parámetros deben tener tipo explícito
+        if (fd->Ptipos[i].empty()) {
+            error(string("Error: parámetros deben tener tipo explícito en función '") + fd->nombre + "'.");
         }
-    }
-
-    if (IfStmt* ifStmt = dynamic_cast<IfStmt*>(s)) {
-        Type* t = inferReturnType(ifStmt->thenBlock);
-        if (t) return t;
-        if (ifStmt->elseBlock) {
-            return inferReturnType(ifStmt->elseBlock);
+        Type* pt = tipos->fromName(fd->Ptipos[i]);
+        if (!pt) {
+            error(string("Error: tipo de parámetro inválido en función '") + fd->nombre + "'.");
         }
+        fd->params[i]->tipo = pt;
     }
 
-    if (WhileStmt* whileStmt = dynamic_cast<WhileStmt*>(s)) {
-        return inferReturnType(whileStmt->block);
-    }
-
-    if (ForStmt* forStmt = dynamic_cast<ForStmt*>(s)) {
-        return inferReturnType(forStmt->block);
+    Type* returnType = nullptr;
+    if (!fd->tipo.empty()) {
+        returnType = tipos->fromName(fd->tipo);
+        if (!returnType) {
+            error(string("Error: tipo de retorno no válido en función '") + fd->nombre + "'.");
+        }
     }
 
-    return nullptr;
+    FunInfo& info = functions[fd->nombre];
+    info.dec = fd;
+    info.retorno = returnType;
+    info.indice = functions.size() - 1;
 }
 
-void TypeChecker::add_function(FunDec* fd) {
-    if (functions.find(fd->nombre) != functions.end()) {
-        cerr << "Error: función '" << fd->nombre << "' ya fue declarada." << endl;
-        exit(0);
-    }
-
-    Type* returnType = new Type();
-    if (fd->tipo.empty()) {
-        // Lógica de inferencia
-        // Agrega parámetros al entorno temporalmente para poder revisar tipos en el cuerpo
-        env.add_level();
-        for (size_t i = 0; i < fd->Pnombres.size(); ++i) {
-            Type* pt = new Type();
-             // Se asume que los parámetros deben tener tipo explícito
-             if (fd->Ptipos[i].empty()) {
-                 cerr << "Error: parámetros deben tener tipo explícito en función '" << fd->nombre << "'." << endl;
-                 exit(0);
-             }
-            if (!pt->set_basic_type(fd->Ptipos[i])) {
-                cerr << "Error: tipo de parámetro inválido en función '" << fd->nombre << "'." << endl;
-                exit(0);
-            }
-            env.add_var(fd->Pnombres[i], pt);
-        }
-
-        Type* inferred = inferReturnType(fd->cuerpo);
-        env.remove_level();
-
-        if (inferred) {
-            returnType = inferred;
-        } else {
-            returnType->ttype = Type::VOID;
-        }
-    } else if (!returnType->set_basic_type(fd->tipo)) {
-        cerr << "Error: tipo de retorno no válido en función '" << fd->nombre << "'." << endl;
-        exit(0);
-    }
+// Tipo de una expresión, calculado una sola vez y guardado en inferredType
+Type* TypeChecker::typeOf(Exp* e) {
+    if (e->inferredType) return e->inferredType;
+    return dispatch(e);
+}
 
-    functions[fd->nombre] = returnType;
+void TypeChecker::error(const string& msg) const {
+    throw TypeError(msg);
 }
 
-void TypeChecker::typecheck(Program* program) {
-    if (program) program->accept(this);
-    // cout << "Revisión exitosa" << endl; // Optional: Comment out to reduce noise
+bool TypeChecker::typecheck(Program* program) {
+    errores.clear();
+    reutilizadas = 0;
+    vector<unique_ptr<EntradaCacheTipos>> resultados;
+    if (cache && program) {
+        resultados.resize(program->fdlist.size());
+        nuevas = &resultados;
+    }
+    try {
+        if (program) visit(program);
+    } catch (const TypeError& e) {
+        errores.push_back(e.what());
+    }
+    if (nuevas) {
+        cache->actualizar(vector<FunDec*>(program->fdlist.begin(), program->fdlist.end()), resultados);
+        nuevas = nullptr;
+    }
+    return errores.empty();
 }
 
 // ===========================================================
@@ -135,20 +131,82 @@ Type* TypeChecker::visit(Program* p) {
     for (auto f : p->fdlist)
         add_function(f);
 
-    env.add_level();
+    if (nuevas) {
+        for (auto v : p->vdlist)
+            globales[v->name] = v->sym;
+    }
     for (auto v : p->vdlist)
-        v->accept(this);  
-    for (auto f : p->fdlist)
-        f->accept(this);  
-    env.remove_level();
+        dispatch(v);  
+
+    vector<FunDec*> funciones(p->fdlist.begin(), p->fdlist.end());
+    vector<string> porFuncion(funciones.size()); // Un buffer por función, en orden de fuente
+
+    // 1. Funciones sin tipo de retorno declarado, en secuencia: su inferencia
+    //    puede visitar otras bajo demanda (ver visit(FcallExp*)). El primer
+    //    error corta esta fase: las que llaman a la función fallida no tienen
+    //    un tipo de retorno con el cual seguir.
+    for (size_t i = 0; i < funciones.size(); ++i) {
+        if (functions[funciones[i]->nombre].retorno) continue;
+        try {
+            visit(funciones[i]);
+        } catch (const TypeError& e) {
+            porFuncion[i] = e.what();
+            break;
+        }
+    }
+    if (reportarErrores(porFuncion)) return voidType;
+
+    // 2. El resto solo lee firmas y el alcance global: en paralelo
+    vector<size_t> pendientes;
+    for (size_t i = 0; i < funciones.size(); ++i)
+        if (functions[funciones[i]->nombre].estado == SIN_VISITAR) pendientes.push_back(i);
+
+    atomic<size_t> siguiente(0);
+    auto trabajar = [&](TypeChecker& tc) {
+        for (size_t k; (k = siguiente++) < pendientes.size();) {
+            size_t i = pendientes[k];
+            try {
+                tc.visit(funciones[i]);
+            } catch (const TypeError& e) {
+                porFuncion[i] = e.what();
+            }
+        }
+    };
+
+    // Con pocas funciones no vale la pena crear hilos
+    int numHilos = min<int>(hilos, pendientes.size() / 32);
+    if (numHilos <= 1) {
+        trabajar(*this);
+    } else {
+        // Cada hilo tiene su copia de la tabla de funciones (solo cambia el
+        // estado de las que él visita) y su propio `actual`.
+        vector<TypeChecker> locales(numHilos, *this);
+        vector<thread> pool;
+        for (int h = 0; h < numHilos; ++h) {
+            locales[h].reutilizadas = 0;
+            pool.emplace_back(trabajar, ref(locales[h]));
+        }
+        for (auto& t : pool) t.join();
+        for (auto& tc : locales) reutilizadas += tc.reutilizadas;
+    }
+    reportarErrores(porFuncion);
     return voidType;
 }
 
+// Pasa a `errores` los de cada función, en orden de fuente. Devuelve true si hubo alguno
+bool TypeChecker::reportarErrores(const vector<string>& porFuncion) {
+    bool hubo = false;
+    for (auto& e : porFuncion) {
+        if (e.empty()) continue;
+        errores.push_back(e);
+        hubo = true;
+    }
+    return hubo;
+}
+
 Type* TypeChecker::visit(Block* b) {
-    env.add_level();
     for (auto s : b->stmts)
-        s->accept(this); 
-    env.remove_level();
+        dispatch(s); 
     return voidType;
 }
 
@@ -157,74 +215,116 @@ Type* TypeChecker::visit(Block* b) {
 // ===========================================================
 
 Type* TypeChecker::visit(VarDec* v) {
-    Type* t = new Type();
+    Type* t = nullptr;
     if (v->type.empty()) {
         // Inferencia desde el inicializador
         if (v->init) {
-             t = v->init->accept(this);
+             t = typeOf(v->init);
         } else {
-            cerr << "Error: variable '" << v->name << "' sin tipo ni inicializador." << endl;
-            exit(0);
+            error(string("Error: variable '") + v->name + "' sin tipo ni inicializador.");
         }
-    } else if (!t->set_basic_type(v->type)) {
-        cerr << "Error: tipo de variable no válido: '" << v->type << "'" << endl;
-        // Depuración: imprimir valores ascii
-        cerr << "Debug: ";
-        for (char c : v->type) cerr << (int)c << " ";
-        cerr << endl;
-        exit(0);
+    } else if (!(t = tipos->fromName(v->type))) {
+        error(string("Error: tipo de variable no válido: '") + v->type + "'");
     }
 
     if (!v->type.empty() && v->init) {
-        Type* initType = v->init->accept(this);
+        Type* initType = typeOf(v->init);
         if (!initType->canAssignTo(t)) {
-             cerr << "Error: tipo de inicializador incompatible con variable '" << v->name << "'." << endl;
-             exit(0);
+             error(string("Error: tipo de inicializador incompatible con variable '") + v->name + "'.");
         }
     }
 
-    if (env.check(v->name)) { // Changed from v->variables loop to v->name
-        cerr << "Error: variable '" << v->name << "' ya declarada." << endl;
-        exit(0);
-    }
-    env.add_var(v->name, t);
-
-    // Lógica de conteo de variables
-    if (!currentFunction.empty()) {
-        currentVarCount++;
-        functionVarCounts[currentFunction] = currentVarCount;
-    }
+    // Las redeclaraciones ya las reportó el Resolver
+    v->sym->tipo = t;
     return voidType;
 }
 
 Type* TypeChecker::visit(FunDec* f) {
-    currentFunction = f->nombre;
-    currentVarCount = 0;
-    functionVarCounts[currentFunction] = 0; // Inicializa
-
-    env.add_level();
-    for (size_t i = 0; i < f->Pnombres.size(); ++i) {
-        Type* pt = new Type();
-        if (!pt->set_basic_type(f->Ptipos[i])) { // Cambiado de Tparametros a Ptipos
-            cerr << "Error: tipo de parámetro inválido en función '" << f->nombre << "'." << endl;
-            exit(0);
-        }
-        env.add_var(f->Pnombres[i], pt); // Cambiado de Nparametros a Pnombres
-        
-        currentVarCount++;
+    FunInfo& info = functions[f->nombre];
+    if (info.estado != SIN_VISITAR) return voidType;
+    info.estado = VISITANDO;
+
+    // Puede llegar anidada desde una llamada: se guarda la función en curso
+    FunInfo* anterior = actual;
+    actual = &info;
+    if (nuevas && reutilizar(f, info)) {
+        ++reutilizadas;
+    } else {
+        revisarCuerpo(f, info);
     }
-    functionVarCounts[currentFunction] = currentVarCount;
-
-    functionVarCounts[currentFunction] = currentVarCount;
+    if (!info.retorno) info.retorno = voidType; // Sin return: Unit
+    info.estado = VISITADA;
+    actual = anterior;
+    return voidType;
+}
 
-    // Usa el tipo ya registrado en add_function
-    Type* returnType = functions[f->nombre];
-    retornodefuncion = returnType;
-    f->cuerpo->accept(this);
+// Con caché, además de revisar guarda el resultado y lo que el cuerpo
+// consultó afuera (ver retornoDe y anotarGlobal)
+void TypeChecker::revisarCuerpo(FunDec* f, FunInfo& info) {
+    if (!nuevas) {
+        dispatch(f->cuerpo);
+        return;
+    }
+    info.deps.clear();
+    auto entrada = make_unique<EntradaCacheTipos>();
+    entrada->huella = f->huella;
+    try {
+        dispatch(f->cuerpo);
+    } catch (const TypeError& e) {
+        entrada->error = e.what();
+        entrada->retorno = info.retorno ? info.retorno->ttype : -1;
+        entrada->deps = move(info.deps);
+        (*nuevas)[info.indice] = move(entrada);
+        throw;
+    }
+    entrada->retorno = info.retorno ? info.retorno->ttype : Type::VOID;
+    entrada->deps = move(info.deps);
+    entrada->anotaciones = grabarAnotaciones(f->cuerpo);
+    (*nuevas)[info.indice] = move(entrada);
+}
 
-    env.remove_level();
-    currentFunction = "";
-    return voidType;
+// Revisar un cuerpo solo depende de su texto (la huella) y de lo que
+// consultó afuera: tipos de globales y retornos de funciones, en ese orden.
+// Se repiten esas consultas en el mismo orden; si todas dan lo mismo que la
+// vez anterior, el resultado (tipos, retorno o error) también es el mismo.
+bool TypeChecker::reutilizar(FunDec* f, FunInfo& info) {
+    const EntradaCacheTipos* e = cache->buscar(f->nombre, f->huella);
+    if (!e) return false;
+
+    Type* declarado = info.retorno;
+    Type* guardado = e->retorno < 0 ? nullptr : tipos->get(static_cast<Type::TType>(e->retorno));
+    bool iguales = true;
+    for (auto& d : e->deps) {
+        int ahora = DependenciaTipos::SIN_DECLARAR;
+        if (d.clase == DependenciaTipos::GLOBAL) {
+            auto it = globales.find(d.nombre);
+            if (it == globales.end()) { iguales = false; break; }
+            ahora = it->second->tipo ? it->second->tipo->ttype : -1;
+        } else {
+            auto it = functions.find(d.nombre);
+            if (it != functions.end()) {
+                FunInfo& callee = it->second;
+                if (!callee.retorno) {
+                    // Llamada recursiva sin retorno conocido: el error lo
+                    // reporta la revisión completa
+                    if (callee.estado == VISITANDO) { iguales = false; break; }
+                    // Al llegar a esta llamada la función en revisión tenía
+                    // (o no) su tipo de retorno: la visita anidada lo ve igual
+                    if (!declarado) info.retorno = d.retornoPropio ? guardado : nullptr;
+                    visit(callee.dec);
+                }
+                ahora = callee.retorno->ttype;
+            }
+        }
+        if (ahora != d.tipo) { iguales = false; break; }
+    }
+    if (iguales && !e->error.empty()) error(e->error);
+    if (!iguales || !aplicarAnotaciones(f->cuerpo, e->anotaciones, *tipos)) {
+        info.retorno = declarado;
+        return false;
+    }
+    info.retorno = guardado;
+    return true;
 }
 
 // ===========================================================
@@ -232,93 +332,91 @@ Type* TypeChecker::visit(FunDec* f) {
 // ===========================================================
 
 Type* TypeChecker::visit(PrintStm* stm) {
-    Type* t = stm->e->accept(this);
+    Type* t = typeOf(stm->e);
     if (!(t->isNumeric() || t->match(boolType) || t->match(stringType))) { 
-        cerr << "Error: tipo invalido en print (solo tipos numericos, bool o string)." << endl;
-        exit(0);
+        error("Error: tipo invalido en print (solo tipos numericos, bool o string).");
     }
     return voidType;
 }
 
 Type* TypeChecker::visit(AssignExp* stm) { // Cambiado desde AssignStm
-    if (!env.check(stm->id)) {
-        cerr << "Error: variable '" << stm->id << "' no declarada." << endl;
-        exit(0);
-    }
-
-    Type* varType = env.lookup(stm->id);
-    Type* expType = stm->e->accept(this);
+    anotarGlobal(stm->sym);
+    Type* varType = stm->sym->tipo;
+    Type* expType = typeOf(stm->e);
 
     if (!expType->canAssignTo(varType)) {
-        cerr << "Error: tipos incompatibles en asignación a '" << stm->id << "'." << endl;
-        exit(0);
+        error(string("Error: tipos incompatibles en asignación a '") + stm->id + "'.");
     }
+    stm->inferredType = voidType;
     return voidType;
 }
 
 Type* TypeChecker::visit(ReturnStm* stm) {
+    Type* t = voidType;
     if (stm->e) {
-        Type* t = stm->e->accept(this);
+        t = typeOf(stm->e);
         if (!(t->match(intType) || t->match(boolType) || t->match(voidType) || t->match(stringType))) {
-            cerr << "Error: tipo inválido en return." << endl;
-            exit(0);
+            error("Error: tipo inválido en return.");
         }
-        // Nota: se podría comparar estrictamente con el tipo declarado de la función.
-        // Aquí se valida solo la compatibilidad general. El original revisaba contra 'retornodefuncion'.
-        if (!(t->canAssignTo(retornodefuncion))) {
-             cerr << "Error: retorno distinto al declarado en la función." << endl;
-             exit(0);
+    }
+    // Sin tipo declarado: el primer return fija el tipo de la función
+    if (!actual->retorno) {
+        actual->retorno = t;
+        return voidType;
+    }
+    if (stm->e) {
+        if (!(t->canAssignTo(actual->retorno))) {
+             error("Error: retorno distinto al declarado en la función.");
         }
     } else {
-        if (!retornodefuncion->match(voidType)) {
-            cerr << "Error: retorno vacío en función no void." << endl;
-            exit(0);
+        if (!actual->retorno->match(voidType)) {
+            error("Error: retorno vacío en función no void.");
         }
     }
     return voidType;
 }
 
 Type* TypeChecker::visit(WhileStmt* stm) {
-    Type* t = stm->condition->accept(this);
+    Type* t = typeOf(stm->condition);
     if (!t->match(boolType)) {
-        cerr << "Error: condición de while debe ser bool." << endl;
-        exit(0);
+        error("Error: condición de while debe ser bool.");
     }
-    stm->block->accept(this);
+    dispatch(stm->block);
     return voidType;
 }
 
 Type* TypeChecker::visit(IfStmt* stm) {
-    Type* t = stm->condition->accept(this);
+    Type* t = typeOf(stm->condition);
     if (!t->match(boolType)) {
-        cerr << "Error: condición de if debe ser bool." << endl;
-        exit(0);
+        error("Error: condición de if debe ser bool.");
     }
-    stm->thenBlock->accept(this);
+    dispatch(stm->thenBlock);
     if (stm->elseBlock) {
-        stm->elseBlock->accept(this);
+        dispatch(stm->elseBlock);
     }
     return voidType;
 }
 
 Type* TypeChecker::visit(ForStmt* stm) {
-    
-    env.add_level();
-    env.add_var(stm->varName, intType);
-    
-    // Count the loop variable
-    if (!currentFunction.empty()) {
-        currentVarCount++;
-        functionVarCounts[currentFunction] = currentVarCount;
-    }
-
-    Type* rangeT = stm->rangeExp->accept(this); // Visit range to check types there
+    Type* rangeT = typeOf(stm->rangeExp); // Visit range to check types there
     if (!rangeT->match(rangeType)) {
-        cerr << "Error: for loop range must be a range type." << endl;
-        exit(0);
+        error("Error: for loop range must be a range type.");
     }
-    stm->block->accept(this);
-    env.remove_level();
+    // Como IntRange / LongRange de Kotlin: el contador es Long si algún
+    // extremo lo es y si no Int. Límite y paso se guardan con el mismo tipo.
+    RangoFor r = rangoDe(stm);
+    Type* contador = intType;
+    if (r.rango) {
+        for (Exp* extremo : {r.inicio, r.limite}) {
+            Type* t = extremo->inferredType;
+            if (t && (t->ttype == Type::LONG || t->ttype == Type::ULONG))
+                contador = tipos->get(Type::LONG);
+        }
+    }
+    stm->varSym->tipo = contador;
+    stm->endSym->tipo = contador;
+    stm->stepSym->tipo = contador;
+    dispatch(stm->block);
     return voidType;
 }
 
@@ -327,8 +425,8 @@ Type* TypeChecker::visit(ForStmt* stm) {
 // ===========================================================
 
 Type* TypeChecker::visit(BinaryExp* e) {
-    Type* left = e->left->accept(this);
-    Type* right = e->right->accept(this);
+    Type* left = typeOf(e->left);
+    Type* right = typeOf(e->right);
     Type* resultType = nullptr;
 
     switch (e->op) {
@@ -340,16 +438,15 @@ Type* TypeChecker::visit(BinaryExp* e) {
         case MOD_OP: 
             // Permitir todos los tipos numéricos
             if (!((left->isNumeric()) && (right->isNumeric()))) {
-                cerr << "Error: operación aritmética requiere operandos numéricos." << endl;
-                exit(0);
+                error("Error: operación aritmética requiere operandos numéricos.");
             }
             
             // Type promotion logic
             if (left->ttype == Type::DOUBLE || right->ttype == Type::DOUBLE) {
-                 resultType = new Type(Type::DOUBLE);
+                 resultType = tipos->get(Type::DOUBLE);
             }
             else if (left->ttype == Type::FLOAT || right->ttype == Type::FLOAT) {
-                 resultType = new Type(Type::FLOAT);
+                 resultType = tipos->get(Type::FLOAT);
             }
             else {
                 auto rank = [](Type* t) {
@@ -366,7 +463,7 @@ Type* TypeChecker::visit(BinaryExp* e) {
                     }
                 };
                 Type* wider = (rank(left) >= rank(right)) ? left : right;
-                resultType = new Type(wider->ttype);
+                resultType = tipos->get(wider->ttype);
             }
             break;
 
@@ -384,8 +481,7 @@ Type* TypeChecker::visit(BinaryExp* e) {
                     // Relaxed check for numbers?
                     if (!((left->ttype >= Type::INT && left->ttype <= Type::ULONG) && 
                           (right->ttype >= Type::INT && right->ttype <= Type::ULONG))) {
-                        cerr << "Error: tipos incompatibles en comparación." << endl;
-                        exit(0);
+                        error("Error: tipos incompatibles en comparación.");
                     }
                  }
             }
@@ -395,8 +491,7 @@ Type* TypeChecker::visit(BinaryExp* e) {
         case AND_OP:
         case OR_OP:
             if (!(left->match(boolType) && right->match(boolType))) {
-                cerr << "Error: operación lógicas requiere operandos bool." << endl;
-                exit(0);
+                error("Error: operación lógicas requiere operandos bool.");
             }
             resultType = boolType;
             break;
@@ -404,23 +499,20 @@ Type* TypeChecker::visit(BinaryExp* e) {
         case RANGE_OP:
         case DOWNTO_OP:
              if (!(left->isNumeric() && right->isNumeric())) {
-                cerr << "Error: rango requiere operandos numéricos." << endl;
-                exit(0);
+                error("Error: rango requiere operandos numéricos.");
              }
              resultType = rangeType;
              break;
 
         case STEP_OP:
              if (!((left->match(rangeType) || left->isNumeric()) && right->isNumeric())) {
-                cerr << "Error: step requiere un rango (o número) y un paso numérico." << endl;
-                exit(0);
+                error("Error: step requiere un rango (o número) y un paso numérico.");
              }
              resultType = rangeType;
              break;
 
         default:
-            cerr << "Error: operador binario no soportado." << endl;
-            exit(0);
+            error("Error: operador binario no soportado.");
     }
     
     e->inferredType = resultType;
@@ -443,74 +535,92 @@ Type* TypeChecker::visit(StringExp* e) {
 } 
 
 Type* TypeChecker::visit(DoubleExp* e) {
-    Type* doubleType = new Type(Type::DOUBLE);
+    Type* doubleType = tipos->get(Type::DOUBLE);
     e->inferredType = doubleType;
     return doubleType;
 }
 
 Type* TypeChecker::visit(LongExp* e) {
-    Type* longType = new Type(Type::LONG);
+    Type* longType = tipos->get(Type::LONG);
     e->inferredType = longType;
     return longType;
 }
 
 Type* TypeChecker::visit(IdExp* e) {
-    if (!env.check(e->value)) {
-        cerr << "Error: variable '" << e->value << "' no declarada." << endl;
-        exit(0);
+    anotarGlobal(e->sym);
+    Type* t = e->sym->tipo;
+    if (!t) {
+        // Solo pasa al inferir un tipo de retorno antes de visitar la declaración
+        error(string("Error: variable '") + e->value + "' usada antes de conocer su tipo.");
     }
-    Type* t = env.lookup(e->value);
     e->inferredType = t;
     return t;
 }
 
 Type* TypeChecker::visit(FcallExp* e) {
     if (e->receiver) {
-        Type* recvType = e->receiver->accept(this);
+        Type* recvType = typeOf(e->receiver);
         for (auto arg : e->argumentos) {
-            arg->accept(this);
+            typeOf(arg);
         }
 
-        static unordered_map<string, Type::TType> conversions = {
-            {"toByte", Type::BYTE},
-            {"toShort", Type::SHORT},
-            {"toInt", Type::INT},
-            {"toLong", Type::LONG},
-            {"toFloat", Type::FLOAT},
-            {"toDouble", Type::DOUBLE},
-            {"toUByte", Type::UBYTE},
-            {"toUShort", Type::USHORT},
-            {"toUInt", Type::UINT},
-            {"toULong", Type::ULONG}
-        };
-
         auto itConv = conversions.find(e->nombre);
         if (itConv == conversions.end()) {
-            cerr << "Error: metodo '" << e->nombre << "' no soportado." << endl;
-            exit(0);
+            error(string("Error: metodo '") + e->nombre + "' no soportado.");
         }
 
         if (!recvType->isNumeric()) {
-            cerr << "Error: conversion '" << e->nombre << "' solo permitida desde tipos numericos." << endl;
-            exit(0);
+            error(string("Error: conversion '") + e->nombre + "' solo permitida desde tipos numericos.");
         }
 
-        Type* result = new Type(itConv->second);
+        Type* result = tipos->get(itConv->second);
         e->inferredType = result;
         return result;
     }
 
     for (auto arg : e->argumentos) {
-        arg->accept(this);
-    }
-
-    auto it = functions.find(e->nombre);
-    if (it == functions.end()) {
-        cerr << "Error: llamada a funcion no declarada '" << e->nombre << "'." << endl;
-        exit(0);
+        typeOf(arg);
     }
 
-    Type* t = it->second;
+    Type* t = retornoDe(e->nombre);
     e->inferredType = t;
     return t;
 }
+
+Type* TypeChecker::retornoDe(const string& nombre) {
+    auto it = functions.find(nombre);
+    FunInfo* callee = it == functions.end() ? nullptr : &it->second;
+
+    // Con caché se anota antes de visitar: si la visita falla queda FALLIDA
+    size_t dep = SIZE_MAX;
+    if (nuevas && actual && (!callee || callee->ultimoLlamador != actual)) {
+        if (callee) callee->ultimoLlamador = actual;
+        int tipo = callee ? DependenciaTipos::FALLIDA : DependenciaTipos::SIN_DECLARAR;
+        actual->deps.push_back({DependenciaTipos::FUNCION, nombre, tipo, actual->retorno != nullptr});
+        dep = actual->deps.size() - 1;
+    }
+
+    if (!callee) {
+        error(string("Error: llamada a funcion no declarada '") + nombre + "'.");
+    }
+    if (!callee->retorno) {
+        // Tipo de retorno aún no inferido: se visita la función ahora
+        if (callee->estado == VISITANDO) {
+            error(string("Error: no se puede inferir el tipo de retorno de '") + nombre +
+                  "' (llamada recursiva antes de su primer return).");
+        }
+        visit(callee->dec);
+    }
+    if (dep != SIZE_MAX) actual->deps[dep].tipo = callee->retorno->ttype;
+    return callee->retorno;
+}
+
+// Con caché, anota el tipo de un global la primera vez que un cuerpo lo usa
+void TypeChecker::anotarGlobal(Symbol* sym) {
+    if (!nuevas || !actual || !sym->global) return;
+    FunInfo*& ultimo = globalAnotado[sym];
+    if (ultimo == actual) return;
+    ultimo = actual;
+    int tipo = sym->tipo ? sym->tipo->ttype : -1;
+    actual->deps.push_back({DependenciaTipos::GLOBAL, sym->nombre, tipo, actual->retorno != nullptr});
+}
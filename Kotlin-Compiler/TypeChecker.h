@@ -3,9 +3,14 @@
 
 #include <unordered_map>
 #include <string>
+#include <vector>
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
 #include "ast.h"
-#include "environment.h"
 #include "semantic_types.h"
+#include "static_visitor.h"
+#include "typecache.h"
 
 using namespace std;
 
@@ -57,14 +62,41 @@ public:
 
 
 
+// Error de tipos: se lanza desde cualquier visita y se recoge por función
+class TypeError : public runtime_error {
+public:
+    explicit TypeError(const string& msg) : runtime_error(msg) {}
+};
+
 // ──────────────────────────────────────────────
 //   CLASE TYPECHECKER
 // ──────────────────────────────────────────────
 
-class TypeChecker : public TypeVisitor {
+class TypeChecker final : public TypeVisitor, public StaticVisitor<TypeChecker, Type*> {
 private:
-    Environment<Type*> env;                 // Entorno de variables y sus tipos
-    unordered_map<string, Type*> functions; // Entorno de funciones
+    // Las variables ya vienen resueltas a su Symbol (resolver.cpp)
+    // Entorno de funciones: firma y estado de la inferencia de retorno
+    enum EstadoFuncion { SIN_VISITAR, VISITANDO, VISITADA };
+    struct FunInfo {
+        FunDec* dec = nullptr;
+        Type* retorno = nullptr; // nullptr: sin tipo declarado y aún sin inferir
+        EstadoFuncion estado = SIN_VISITAR;
+        size_t indice = 0;       // Posición en fdlist
+        // Solo con caché: lo que su cuerpo consultó afuera, y quién llamó a
+        // esta función por última vez (para anotarla una vez por llamador)
+        vector<DependenciaTipos> deps;
+        FunInfo* ultimoLlamador = nullptr;
+    };
+    unordered_map<string, FunInfo> functions;
+    FunInfo* actual = nullptr; // Función cuyo cuerpo se está revisando
+
+    // Caché de la compilación anterior (ver typecache.h)
+    unordered_map<string, Symbol*> globales;            // Para validar dependencias GLOBAL
+    unordered_map<Symbol*, FunInfo*> globalAnotado;     // Último cuerpo que anotó cada global
+    vector<unique_ptr<EntradaCacheTipos>>* nuevas = nullptr; // Una por función (compartido entre hilos)
+
+    TypeTable* tipos; // Instancias canónicas de la compilación
+    unordered_map<string, Type::TType> conversions; // Métodos toInt(), toByte()...
 
     // Tipos básicos
     Type* intType;
@@ -72,24 +104,38 @@ private:
     Type* voidType;
     Type* stringType; // Agregado
     Type* rangeType; // Agregado
-    Type* retornodefuncion;
     // Registro de funciones
     void add_function(FunDec* fd);
-    
-    // Helper for return type inference
-    Type* inferReturnType(Stm* s);
 
-    // Variable counting
-    string currentFunction;
-    int currentVarCount;
+    // Tipo de una expresión, visitándola solo la primera vez
+    Type* typeOf(Exp* e);
+
+    // Tipo de retorno de una función llamada, visitándola si aún no se infirió
+    Type* retornoDe(const string& nombre);
+    void anotarGlobal(Symbol* sym);
+    // Reutiliza el resultado guardado si nada de lo que consultó cambió
+    bool reutilizar(FunDec* f, FunInfo& info);
+    void revisarCuerpo(FunDec* f, FunInfo& info);
+
+    [[noreturn]] void error(const string& msg) const;
+    bool reportarErrores(const vector<string>& porFuncion);
 
 public:
-    unordered_map<string, int> functionVarCounts; // Public to access from main
+    // Hilos para revisar cuerpos de función en paralelo (1 = secuencial)
+    int hilos = max(1u, thread::hardware_concurrency());
+
+    // Errores de la última revisión, en orden de fuente
+    vector<string> errores;
+
+    // Caché entre compilaciones (nullptr: se revisa todo). typecheck() la
+    // consulta y la deja actualizada con el programa revisado.
+    CacheTipos* cache = nullptr;
+    int reutilizadas = 0; // Funciones tomadas de la caché en la última revisión
 
-    TypeChecker();
+    explicit TypeChecker(TypeTable& tipos);
 
-    // Método principal de verificación
-    void typecheck(Program* program);
+    // Método principal de verificación. Devuelve false si hubo errores
+    bool typecheck(Program* program);
 
     // --- Visitas de alto nivel ---
     Type* visit(Program* p) override;
@@ -116,4 +162,4 @@ public:
     Type* visit(StringExp* e) override; // Agregado
 };
 
-#endif TYPECHECKER_H
+#endif // TYPECHECKER_H
@@ -27,93 +27,78 @@ string Exp::binopToChar(BinaryOp op) {
     }
 }
 
-BinaryExp::BinaryExp(Exp* l, Exp* r, BinaryOp op) : left(l), right(r), op(op) {
-    // Plegado de constantes
-    if (left && right && left->isnumber && right->isnumber) {
-        isnumber = true;
-        switch(op) {
-            case PLUS_OP:  valor = left->valor + right->valor; break;
-            case MINUS_OP: valor = left->valor - right->valor; break;
-            case MUL_OP:   valor = left->valor * right->valor; break;
-            case DIV_OP:   valor = (right->valor != 0) ? left->valor / right->valor : 0; break;
-            case MOD_OP:   valor = (right->valor != 0) ? left->valor % right->valor : 0; break;
-            case LE_OP:    valor = left->valor <= right->valor; break;
-            case LT_OP:    valor = left->valor <  right->valor; break;
-            case GT_OP:    valor = left->valor >  right->valor; break;
-            case GE_OP:    valor = left->valor >= right->valor; break;
-            case EQ_OP:    valor = left->valor == right->valor; break;
-            case NE_OP:    valor = left->valor != right->valor; break;
-            case AND_OP:   valor = (left->valor != 0) && (right->valor != 0); break;
-            case OR_OP:    valor = (left->valor != 0) || (right->valor != 0); break;
-            default:       valor = 0; break;
-        }
-    } else {
-        isnumber = false;
-        valor = 0;
-    }
-
-    // Peso Sethi-Ullman
-    int le = left ? left->etiqueta : 0;
-    int ri = right ? right->etiqueta : 0;
-    etiqueta = (le == ri) ? le + 1 : max(le, ri);
-}
+// El plegado de constantes y los pesos de Sethi-Ullman se calculan en
+// pases aparte (ver passes.cpp), según el nivel de optimización.
+BinaryExp::BinaryExp(Exp* l, Exp* r, BinaryOp op) : Exp(NODE_BINARY), left(l), right(r), op(op) {}
 BinaryExp::~BinaryExp() { delete left; delete right; }
 
-NumberExp::NumberExp(int v) : value(v) { isnumber = true; valor = v; etiqueta = 0; }
+NumberExp::NumberExp(int v) : Exp(NODE_NUMBER), value(v) { isnumber = true; valor = v; etiqueta = 0; }
 NumberExp::~NumberExp() {}
 
-DoubleExp::DoubleExp(double v) : value(v) { isnumber = true; value = v; etiqueta = 0;}
+DoubleExp::DoubleExp(double v) : Exp(NODE_DOUBLE), value(v) { isnumber = true; valorReal = v; etiqueta = 0;}
 DoubleExp::~DoubleExp() {}
 
-LongExp::LongExp(long long v) : valor(v) { 
+LongExp::LongExp(long long v) : Exp(NODE_LONG) { 
     isnumber = true; 
+    valor = v;
+    etiqueta = 0;
 }
 LongExp::~LongExp() {}
 
-BoolExp::BoolExp(bool v) : value(v) { isnumber = true; valor = v ? 1 : 0; etiqueta = 0; }
+BoolExp::BoolExp(bool v) : Exp(NODE_BOOL), value(v) { isnumber = true; valor = v ? 1 : 0; etiqueta = 0; }
 BoolExp::~BoolExp() {}
 
 // Implementación de StringExp
-StringExp::StringExp(string v) : value(v) { isnumber = false; valor = 0; etiqueta = 0; }
+StringExp::StringExp(string v) : Exp(NODE_STRING), value(v) { isnumber = false; valor = 0; etiqueta = 0; }
 StringExp::~StringExp() {}
 
-IdExp::IdExp(string v) : value(v) { isnumber = false; valor = 0; etiqueta = 0; }
+IdExp::IdExp(string v) : Exp(NODE_ID), value(v) { isnumber = false; valor = 0; etiqueta = 0; }
 IdExp::~IdExp() {}
 
 VarDec::VarDec(string name, string type, Exp* init, bool isConst) 
-    : name(name), type(type), init(init), isConst(isConst) {}
+    : Stm(NODE_VARDEC), name(name), type(type), init(init), isConst(isConst) {}
 VarDec::~VarDec() { if(init) delete init; }
 
-Block::Block() {}
+Block::Block() : Stm(NODE_BLOCK) {}
 Block::~Block() {
     for (Stm* s : stmts) delete s;
 }
 
 IfStmt::IfStmt(Exp* condition, Block* thenBlock, Block* elseBlock) 
-    : condition(condition), thenBlock(thenBlock), elseBlock(elseBlock) {}
+    : Stm(NODE_IF), condition(condition), thenBlock(thenBlock), elseBlock(elseBlock) {}
+IfStmt::~IfStmt() { delete condition; delete thenBlock; delete elseBlock; }
 
 WhileStmt::WhileStmt(Exp* condition, Block* block) 
-    : condition(condition), block(block) {}
+    : Stm(NODE_WHILE), condition(condition), block(block) {}
+WhileStmt::~WhileStmt() { delete condition; delete block; }
 
 ForStmt::ForStmt(string varName, Exp* rangeExp, Block* block)
-    : varName(varName), rangeExp(rangeExp), block(block) {}
+    : Stm(NODE_FOR), varName(varName), rangeExp(rangeExp), block(block) {}
+ForStmt::~ForStmt() { delete rangeExp; delete block; }
 
-AssignExp::AssignExp(string id, Exp* e) : id(id), e(e) {}
+AssignExp::AssignExp(string id, Exp* e) : Exp(NODE_ASSIGN), id(id), e(e) {}
 AssignExp::~AssignExp() { delete e; }
 
-PrintStm::PrintStm(Exp* e) : e(e) {}
+PrintStm::PrintStm(Exp* e) : Stm(NODE_PRINT), e(e) {}
 PrintStm::~PrintStm() { delete e; }
 
-ReturnStm::ReturnStm(Exp* e) : e(e) {}
+ReturnStm::ReturnStm(Exp* e) : Stm(NODE_RETURN), e(e) {}
+ReturnStm::~ReturnStm() { delete e; }
 
 FcallExp::FcallExp(string nombre, vector<Exp*> args, Exp* receiver) 
-    : nombre(nombre), argumentos(args), receiver(receiver) {}
+    : Exp(NODE_FCALL), nombre(nombre), argumentos(args), receiver(receiver) {}
+FcallExp::~FcallExp() {
+    for (Exp* a : argumentos) delete a;
+    delete receiver;
+}
 
 FunDec::FunDec(string nombre, string tipo, vector<string> Ptipos, vector<string> Pnombres, Block* cuerpo)
     : nombre(nombre), tipo(tipo), Ptipos(Ptipos), Pnombres(Pnombres), cuerpo(cuerpo) {}
+FunDec::~FunDec() { delete cuerpo; }
 
 Program::Program() {}
 Program::~Program() {
     for (VarDec* v : vdlist) delete v;
     for (FunDec* f : fdlist) delete f;
+    for (Symbol* s : simbolos) delete s;
 }
@@ -1,6 +1,7 @@
 #ifndef AST_H
 #define AST_H
 
+#include <cstdint>
 #include <string>
 #include <list>
 #include <ostream>
@@ -33,8 +34,41 @@ enum BinaryOp {
     STEP_OP
 };
 
+// Tipo concreto de cada nodo, para despachar con un switch (ver static_visitor.h)
+enum NodeKind {
+    NODE_BINARY,
+    NODE_NUMBER,
+    NODE_DOUBLE,
+    NODE_LONG,
+    NODE_BOOL,
+    NODE_STRING,
+    NODE_ID,
+    NODE_ASSIGN,
+    NODE_FCALL,
+    NODE_VARDEC,
+    NODE_BLOCK,
+    NODE_IF,
+    NODE_WHILE,
+    NODE_FOR,
+    NODE_PRINT,
+    NODE_RETURN
+};
+
+// Variable resuelta por el Resolver (resolver.cpp): cada uso de un nombre
+// apunta a su declaración, sin volver a buscarla por string.
+struct Symbol {
+    string nombre;
+    bool global;          // Global: etiqueta `nombre(%rip)`; local: celda del marco
+    int offset = 0;       // Local: desplazamiento respecto de %rbp (lo fija FrameLayout)
+    int reg = -1;         // Local: registro asignado (RegisterAllocator), -1 si vive en el marco
+    Type* tipo = nullptr; // Lo fija el TypeChecker al visitar la declaración
+    Symbol(string nombre, bool global) : nombre(nombre), global(global) {}
+};
+
 class Stm{
 public:
+    const NodeKind kind;
+    Stm(NodeKind kind) : kind(kind) {}
     virtual int accept(Visitor* visitor) = 0;
     virtual Type* accept(TypeVisitor* visitor) = 0; // Agregado
     virtual ~Stm() = 0;
@@ -43,6 +77,7 @@ public:
 // Clase abstracta Exp
 class Exp : public Stm { // Exp hereda de Stm
 public:
+    Exp(NodeKind kind) : Stm(kind) {}
     virtual int  accept(Visitor* visitor) = 0;
     virtual ~Exp() = 0;  // Destructor puro → clase abstracta
     static string binopToChar(BinaryOp op);  // Conversión operador → string
@@ -50,7 +85,8 @@ public:
     Type* inferredType = nullptr; // Para guardar el tipo inferido
     // Optimizaciones
     bool isnumber = false; // ¿Se resolvió en compilación?
-    int valor = 0;         // Valor constante plegado
+    long long valor = 0;   // Valor constante plegado (enteros y bool, ya ajustado al ancho del tipo)
+    double valorReal = 0;  // Valor constante plegado (Float/Double)
     int etiqueta = 0;      // Peso para Sethi-Ullman
 };
 
@@ -90,7 +126,7 @@ public:
 // Clase para literales de 64 bits (Long)
 class LongExp : public Exp {
 public:
-    long long valor; // Almacena el valor de 64 bits
+    // El valor de 64 bits se guarda en Exp::valor
     LongExp(long long v);
     
     // Métodos de aceptación (visitors)
@@ -123,6 +159,7 @@ public:
 class IdExp : public Exp {
 public:
     string value;
+    Symbol* sym = nullptr; // Declaración a la que se refiere
     int accept(Visitor* visitor);
     Type* accept(TypeVisitor* visitor); // nuevo
     IdExp(string v);
@@ -136,6 +173,7 @@ public:
     string name; 
     Exp* init;   
     bool isConst; 
+    Symbol* sym = nullptr; // Símbolo que introduce
     VarDec(string name, string type, Exp* init, bool isConst);
     int accept(Visitor* visitor);
     Type* accept(TypeVisitor* visitor); // Changed to Type*
@@ -160,7 +198,7 @@ public:
     IfStmt(Exp* condition, Block* thenBlock, Block* elseBlock);
     int accept(Visitor* visitor);
     Type* accept(TypeVisitor* visitor); // Changed to Type*
-    ~IfStmt(){};
+    ~IfStmt();
 };
 
 class WhileStmt: public Stm {
@@ -170,7 +208,7 @@ public:
     WhileStmt(Exp* condition, Block* block);
     int accept(Visitor* visitor);
     Type* accept(TypeVisitor* visitor); // Changed to Type*
-    ~WhileStmt(){};
+    ~WhileStmt();
 };
 
 class ForStmt: public Stm { 
@@ -178,16 +216,20 @@ public:
     string varName;
     Exp* rangeExp; // "in Exp"
     Block* block;
+    Symbol* varSym = nullptr;  // Variable del bucle
+    Symbol* endSym = nullptr;  // Límite evaluado una vez (oculto)
+    Symbol* stepSym = nullptr; // Paso evaluado una vez (oculto)
     ForStmt(string varName, Exp* rangeExp, Block* block);
     int accept(Visitor* visitor);
     Type* accept(TypeVisitor* visitor); // Changed to Type*
-    ~ForStmt(){};
+    ~ForStmt();
 };
 
 class AssignExp: public Exp { // Renombrada desde AssignStm y hereda de Exp
 public:
     string id;
     Exp* e;
+    Symbol* sym = nullptr; // Variable asignada
     AssignExp(string, Exp*);
     Type* accept(TypeVisitor* visitor); // nuevo
     ~AssignExp();
@@ -207,7 +249,7 @@ class ReturnStm: public Stm {
 public:
     Exp* e;
     ReturnStm(Exp* e);
-    ~ReturnStm(){};
+    ~ReturnStm();
     int accept(Visitor* visitor);
     Type* accept(TypeVisitor* visitor); // Changed to Type*
 };
@@ -220,7 +262,7 @@ public:
     int accept(Visitor* visitor);
     Type* accept(TypeVisitor* visitor); // nuevo
     FcallExp(string nombre, vector<Exp*> args, Exp* receiver = nullptr);
-    ~FcallExp(){}; 
+    ~FcallExp();
 };
 
 class FunDec{
@@ -230,16 +272,21 @@ public:
     Block* cuerpo;
     vector<string> Ptipos;
     vector<string> Pnombres;
+    vector<Symbol*> params; // Símbolos de los parámetros
+    int tamMarco = 0;       // Bytes de locales bajo %rbp, múltiplo de 16 (FrameLayout)
+    vector<int> salvados;   // Registros callee-saved que usa; se guardan en lo alto del marco
+    uint64_t huella = 0;    // Hash de sus tokens (Parser), clave de la caché de tipos
     int accept(Visitor* visitor);
     Type* accept(TypeVisitor* visitor); // Changed to Type*
     FunDec(string nombre, string tipo, vector<string> Ptipos, vector<string> Pnombres, Block* cuerpo);
-    ~FunDec(){};
+    ~FunDec();
 };
 
 class Program{
 public:
     list<VarDec*> vdlist;
     list<FunDec*> fdlist;
+    vector<Symbol*> simbolos; // Dueño de todos los Symbol del programa
     Program();
     ~Program();
     int accept(Visitor* visitor);
@@ -0,0 +1,75 @@
+import os
+import re
+import subprocess
+import sys
+import tempfile
+
+# Genera un programa sintético grande y mide las fases con -ftime-passes.
+# Uso: python3 bench_passes.py [compilador] [num_funciones] [repeticiones] [flags...]
+
+compilador = sys.argv[1] if len(sys.argv) > 1 else "./main.exe"
+num_funciones = int(sys.argv[2]) if len(sys.argv) > 2 else 2000
+repeticiones = int(sys.argv[3]) if len(sys.argv) > 3 else 5
+flags = sys.argv[4:] if len(sys.argv) > 4 else ["-O1"]
+
+
+def generar_programa(n):
+    partes = ["var base: Int = 3\n", "var escala: Long = 2L\n"]
+    for k in range(n):
+        llamada = f" + f{k - 1}(a, b)" if k > 0 else ""
+        partes.append(f"""
+fun f{k}(a: Int, b: Int): Int {{
+    var x = a + b * {k % 7 + 1} - base
+    var y = 0
+    var z: Long = escala * {k + 1}L
+    while (y < 10) {{
+        if (x % 2 == 0) {{
+            x = x / 2
+        }} else {{
+            x = x * 3 + 1
+        }}
+        y = y + 1
+    }}
+    for (i in 1..10) {{
+        x = x + i * (a - b) + (y * 2 + 1) * (x - 1)
+        z = z + x.toLong()
+    }}
+    val d = x.toDouble() * 1.5 + 0.25
+    println(d)
+    println(z)
+    return x{llamada}
+}}
+""")
+    partes.append(f"""
+fun main() {{
+    println(f{n - 1}(1, 2))
+}}
+""")
+    return "".join(partes)
+
+
+def medir(ruta):
+    fases = {}
+    for _ in range(repeticiones):
+        r = subprocess.run([compilador] + flags + ["-ftime-passes", ruta], capture_output=True, text=True)
+        if r.returncode != 0:
+            print("Error al compilar:\n", r.stdout[-2000:], r.stderr[-2000:])
+            sys.exit(1)
+        for linea in r.stderr.splitlines():
+            m = re.match(r"\s*([0-9.]+)\s+[0-9.]+\s+[0-9]*\s+(\S+)$", linea)
+            if m:
+                fases.setdefault(m.group(2), []).append(float(m.group(1)))
+    return fases
+
+
+with tempfile.TemporaryDirectory() as tmp:
+    ruta = os.path.join(tmp, "bench.txt")
+    with open(ruta, "w") as f:
+        f.write(generar_programa(num_funciones))
+    fases = medir(ruta)
+
+print(f"{num_funciones} funciones, {repeticiones} repeticiones, flags {' '.join(flags)}")
+print(f"{'Fase':<16}{'min (ms)':>12}{'mediana (ms)':>15}")
+for nombre, tiempos in fases.items():
+    tiempos.sort()
+    print(f"{nombre:<16}{tiempos[0]:>12.3f}{tiempos[len(tiempos) // 2]:>15.3f}")
@@ -0,0 +1,595 @@
+#include "bytecode.h"
+#include "passes.h"
+#include "semantic_types.h"
+#include "static_visitor.h"
+#include "visitor.h"
+#include <algorithm>
+#include <stdexcept>
+#include <unordered_map>
+
+using namespace std;
+
+static bool esSinSigno(Type* t) {
+    return t && (t->ttype == Type::UBYTE || t->ttype == Type::USHORT ||
+                 t->ttype == Type::UINT || t->ttype == Type::ULONG);
+}
+
+static bool esReal(Type* t) {
+    return t && (t->ttype == Type::DOUBLE || t->ttype == Type::FLOAT);
+}
+
+// Lo que hace extenderRax(tam, sinSigno) en el codegen
+static OpBC extension(int tam, bool sinSigno) {
+    if (tam == 8) return BC_MOV;
+    if (tam == 4) return sinSigno ? BC_ZX4 : BC_SX4;
+    if (tam == 2) return sinSigno ? BC_ZX2 : BC_SX2;
+    return sinSigno ? BC_ZX1 : BC_SX1;
+}
+
+// La extensión con que el codegen carga una variable del tipo (IdExp); una
+// variable se guarda ya así. UInt se extiende con signo, como en el codegen.
+static OpBC extensionDeCarga(Type* t) {
+    if (t && t->ttype == Type::FLOAT) return BC_ZX4;
+    int tam = getTypeSize(t);
+    return extension(tam, esSinSigno(t) && tam < 4);
+}
+
+// Imagen en %rax de `mov $v` con el ancho dado (sin parte alta previa)
+static uint64_t imagen(long long v, int tam) {
+    return tam == 8 ? static_cast<uint64_t>(v) : aplicarExtension(extension(tam, true), static_cast<uint64_t>(v));
+}
+
+// Como emitConstant: los bits plegados con el ancho del tipo
+static uint64_t imagenConstante(Exp* e) {
+    long long bits = 0;
+    constantBits(e, e->inferredType, bits);
+    int tam = getTypeSize(e->inferredType);
+    if (e->inferredType && e->inferredType->ttype == Type::BOOL) tam = 4;
+    return imagen(bits, tam);
+}
+
+// ¿Evaluar `e` puede cambiar una variable local?
+static bool asigna(Exp* e) {
+    switch (e->kind) {
+        case NODE_ASSIGN: return true;
+        case NODE_BINARY: {
+            BinaryExp* b = static_cast<BinaryExp*>(e);
+            return !b->isnumber && (asigna(b->left) || asigna(b->right));
+        }
+        case NODE_FCALL: {
+            FcallExp* f = static_cast<FcallExp*>(e);
+            if (f->receiver) return !f->isnumber && asigna(f->receiver);
+            for (auto a : f->argumentos)
+                if (asigna(a)) return true;
+            return false;
+        }
+        default: return false;
+    }
+}
+
+// ===========================================================
+//   Generador
+// ===========================================================
+//
+// Cada visit de una expresión devuelve el registro con su valor: uno nuevo
+// o, para una variable local, el de la variable. Los temporales se
+// reparten como una pila que se vacía al terminar cada sentencia.
+
+namespace {
+
+class GeneradorBytecode final : public StaticVisitor<GeneradorBytecode, int> {
+private:
+    ProgramaBytecode& p;
+    unordered_map<Symbol*, int> registroDe; // Locales de la función actual
+    unordered_map<Symbol*, int> globalDe;
+    unordered_map<string, int> funcionDe;
+    unordered_map<string, int> cadenaDe;
+    unordered_map<uint64_t, int> constanteDe;
+    int locales = 0; // Los temporales empiezan después de las locales
+    int tope = 0;
+    int maximo = 0;
+
+    int temporal() {
+        if (tope >= UINT16_MAX) throw runtime_error("bytecode: la función usa demasiados registros");
+        maximo = max(maximo, tope + 1);
+        return tope++;
+    }
+
+    void emit(OpBC op, int a = 0, int b = 0, int c = 0) {
+        InstrBC i;
+        i.op = op;
+        i.a = static_cast<uint16_t>(a);
+        i.b = static_cast<uint16_t>(b);
+        i.c = static_cast<uint16_t>(c);
+        p.codigo.push_back(i);
+    }
+
+    // Salto con destino por completar; devuelve su posición
+    size_t salto(OpBC op, int a = 0) {
+        emit(op, a);
+        return p.codigo.size() - 1;
+    }
+    void aqui(size_t salto) { p.codigo[salto].setBc(static_cast<uint32_t>(p.codigo.size())); }
+    void saltoA(size_t destino) { p.codigo[salto(BC_JMP)].setBc(static_cast<uint32_t>(destino)); }
+
+    uint32_t indiceConstante(uint64_t v) {
+        auto it = constanteDe.find(v);
+        if (it != constanteDe.end()) return static_cast<uint32_t>(it->second);
+        int k = static_cast<int>(p.constantes.size());
+        p.constantes.push_back(v);
+        constanteDe.emplace(v, k);
+        return static_cast<uint32_t>(k);
+    }
+
+    int constante(uint64_t v) {
+        int t = temporal();
+        emit(BC_MOVK, t);
+        p.codigo.back().setBc(indiceConstante(v));
+        return t;
+    }
+
+    // `op` de v a un temporal; MOV no necesita instrucción
+    int aplicar(OpBC op, int v) {
+        if (op == BC_MOV) return v;
+        int t = temporal();
+        emit(op, t, v);
+        return t;
+    }
+
+    // convertValueTo del codegen
+    int convertir(int v, Type* src, Type* dst) {
+        if (!src || !dst || src->ttype == dst->ttype) return v;
+        if (dst->ttype == Type::FLOAT || dst->ttype == Type::DOUBLE) {
+            bool aDouble = dst->ttype == Type::DOUBLE;
+            if (esReal(src)) return aplicar(aDouble ? BC_F2D : BC_D2F, v);
+            return enteroAReal(v, src, aDouble);
+        }
+        if (esReal(src)) {
+            int t = temporal();
+            emit(src->ttype == Type::DOUBLE ? BC_D2I8 : BC_F2I8, t, v);
+            OpBC ext = extension(getTypeSize(dst), false);
+            if (ext != BC_MOV) emit(ext, t, t);
+            return t;
+        }
+        return enteroAEntero(v, src, dst);
+    }
+
+    // enteroADouble del codegen (un ULong a Float pasa por double)
+    int enteroAReal(int v, Type* src, bool aDouble) {
+        int t = temporal();
+        if (src->ttype == Type::ULONG) {
+            emit(BC_U2D, t, v);
+            if (!aDouble) emit(BC_D2F, t, t);
+            return t;
+        }
+        emit(extension(getTypeSize(src), esSinSigno(src)), t, v);
+        emit(aDouble ? BC_I2D : BC_I2F, t, t);
+        return t;
+    }
+
+    // enteroAEntero del codegen: al ensanchar manda el signo de la fuente
+    int enteroAEntero(int v, Type* src, Type* dst) {
+        int tamFuente = getTypeSize(src), tamDestino = getTypeSize(dst);
+        if (tamDestino <= tamFuente) return aplicar(extension(tamDestino, esSinSigno(dst)), v);
+        return aplicar(extension(tamFuente, esSinSigno(src)), v);
+    }
+
+    // La variable queda con el valor extendido como lo cargaría IdExp
+    void guardar(Symbol* sym, int v) {
+        OpBC ext = extensionDeCarga(sym->tipo);
+        auto g = globalDe.find(sym);
+        if (g != globalDe.end()) {
+            emit(BC_GSTORE, v, g->second, ext);
+            return;
+        }
+        int r = registroDe.at(sym);
+        if (ext != BC_MOV || r != v) emit(ext, r, v);
+    }
+
+    void registrar(Symbol* sym) {
+        if (sym && !registroDe.count(sym)) registroDe.emplace(sym, static_cast<int>(registroDe.size()));
+    }
+
+    // Un registro por cada local del cuerpo (los parámetros ya tienen los primeros)
+    void registrarLocales(Stm* s) {
+        if (!s) return;
+        switch (s->kind) {
+            case NODE_VARDEC: registrar(static_cast<VarDec*>(s)->sym); break;
+            case NODE_BLOCK:
+                for (auto st : static_cast<Block*>(s)->stmts) registrarLocales(st);
+                break;
+            case NODE_IF:
+                registrarLocales(static_cast<IfStmt*>(s)->thenBlock);
+                registrarLocales(static_cast<IfStmt*>(s)->elseBlock);
+                break;
+            case NODE_WHILE: registrarLocales(static_cast<WhileStmt*>(s)->block); break;
+            case NODE_FOR: {
+                ForStmt* f = static_cast<ForStmt*>(s);
+                registrar(f->varSym);
+                registrar(f->endSym);
+                registrar(f->stepSym);
+                registrarLocales(f->block);
+                break;
+            }
+            default: break;
+        }
+    }
+
+    bool esLocal(int r) const { return r < locales; }
+
+    void sentencia(Stm* s) {
+        dispatch(s);
+        tope = locales;
+    }
+
+public:
+    explicit GeneradorBytecode(ProgramaBytecode& p) : p(p) {}
+
+    void run(Program* programa) {
+        for (auto dec : programa->vdlist) {
+            long long bits = 0;
+            if (!dec->init || !constantBits(dec->init, dec->sym->tipo, bits)) bits = 0;
+            globalDe.emplace(dec->sym, static_cast<int>(p.globales.size()));
+            // El .quad del codegen, leído con la extensión de su tipo
+            p.globales.push_back(aplicarExtension(extensionDeCarga(dec->sym->tipo), static_cast<uint64_t>(bits)));
+        }
+        for (auto f : programa->fdlist) {
+            funcionDe.emplace(f->nombre, static_cast<int>(p.funciones.size()));
+            FuncionBC fn;
+            fn.nombre = f->nombre;
+            fn.parametros = static_cast<uint16_t>(f->params.size());
+            p.funciones.push_back(fn);
+            if (f->nombre == "main") p.principal = static_cast<int>(p.funciones.size()) - 1;
+        }
+        for (auto f : programa->fdlist) visit(f);
+    }
+
+    int visit(FunDec* f) {
+        FuncionBC& fn = p.funciones[funcionDe.at(f->nombre)];
+        fn.entrada = static_cast<uint32_t>(p.codigo.size());
+        registroDe.clear();
+        for (auto s : f->params) registrar(s);
+        registrarLocales(f->cuerpo);
+        if (registroDe.size() >= UINT16_MAX) throw runtime_error("bytecode: demasiadas variables en " + f->nombre);
+        locales = tope = maximo = static_cast<int>(registroDe.size());
+
+        // El callee guarda cada argumento con el ancho de su parámetro
+        for (size_t i = 0; i < f->params.size(); ++i) {
+            OpBC ext = extensionDeCarga(f->params[i]->tipo);
+            if (ext != BC_MOV) emit(ext, static_cast<int>(i), static_cast<int>(i));
+        }
+        sentencia(f->cuerpo);
+        // Sin return, %rax queda con cualquier cosa: aquí con 0
+        emit(BC_RET, constante(0));
+        tope = locales;
+        p.funciones[funcionDe.at(f->nombre)].registros = static_cast<uint16_t>(max(maximo, 1));
+        return -1;
+    }
+
+    int visit(Block* b) {
+        for (auto s : b->stmts) sentencia(s);
+        return -1;
+    }
+
+    int visit(VarDec* stm) {
+        if (!stm->init) return -1;
+        int v = dispatch(stm->init);
+        guardar(stm->sym, convertir(v, stm->init->inferredType, stm->sym->tipo));
+        return -1;
+    }
+
+    int visit(AssignExp* stm) {
+        int v = dispatch(stm->e);
+        int c = convertir(v, stm->e->inferredType, stm->sym->tipo);
+        guardar(stm->sym, c);
+        return c;
+    }
+
+    int visit(PrintStm* stm) {
+        int v = dispatch(stm->e);
+        Type* t = stm->e->inferredType;
+        if (stm->e->kind == NODE_STRING) {
+            emit(BC_PRINTS, v);
+        } else if (esReal(t)) {
+            emit(BC_PRINTD, t->ttype == Type::FLOAT ? aplicar(BC_F2D, v) : v);
+        } else {
+            emit(BC_PRINTI, aplicar(extension(getTypeSize(t), esSinSigno(t)), v));
+        }
+        return -1;
+    }
+
+    int visit(IfStmt* stm) {
+        size_t aElse = salto(BC_JF, dispatch(stm->condition));
+        tope = locales;
+        sentencia(stm->thenBlock);
+        if (stm->elseBlock) {
+            size_t aFin = salto(BC_JMP);
+            aqui(aElse);
+            sentencia(stm->elseBlock);
+            aqui(aFin);
+        } else {
+            aqui(aElse);
+        }
+        return -1;
+    }
+
+    int visit(WhileStmt* stm) {
+        size_t inicio = p.codigo.size();
+        size_t aFin = salto(BC_JF, dispatch(stm->condition));
+        tope = locales;
+        sentencia(stm->block);
+        saltoA(inicio);
+        aqui(aFin);
+        return -1;
+    }
+
+    int visit(ForStmt* stm) {
+        Exp* range = stm->rangeExp;
+        Exp* step = nullptr;
+        bool isDownTo = false;
+        BinaryExp* stepExp = range->kind == NODE_BINARY ? static_cast<BinaryExp*>(range) : nullptr;
+        if (stepExp && stepExp->op == STEP_OP) {
+            step = stepExp->right;
+            range = stepExp->left;
+        }
+        BinaryExp* rangeBin = range->kind == NODE_BINARY ? static_cast<BinaryExp*>(range) : nullptr;
+        if (!rangeBin || (rangeBin->op != RANGE_OP && rangeBin->op != DOWNTO_OP))
+            throw runtime_error("bytecode: for sin rango");
+        isDownTo = rangeBin->op == DOWNTO_OP;
+
+        Type* tipo = stm->varSym->tipo;
+        int tam = getTypeSize(tipo);
+        guardar(stm->varSym, convertir(dispatch(rangeBin->left), rangeBin->left->inferredType, tipo));
+        tope = locales;
+        guardar(stm->endSym, convertir(dispatch(rangeBin->right), rangeBin->right->inferredType, tipo));
+        tope = locales;
+        int paso = step ? convertir(dispatch(step), step->inferredType, tipo) : constante(imagen(1, tam));
+        guardar(stm->stepSym, paso);
+        tope = locales;
+
+        int var = registroDe.at(stm->varSym);
+        size_t inicio = p.codigo.size();
+        int sigue = temporal();
+        emit(conAncho(isDownTo ? BC_GE_1 : BC_LE_1, tam), sigue, var, registroDe.at(stm->endSym));
+        size_t aFin = salto(BC_JF, sigue);
+        tope = locales;
+        sentencia(stm->block);
+        emit(conAncho(isDownTo ? BC_SUB_1 : BC_ADD_1, tam), var, var, registroDe.at(stm->stepSym));
+        guardar(stm->varSym, var);
+        saltoA(inicio);
+        aqui(aFin);
+        return -1;
+    }
+
+    int visit(ReturnStm* stm) {
+        emit(BC_RET, stm->e ? dispatch(stm->e) : constante(0));
+        return -1;
+    }
+
+    int visit(NumberExp* exp) { return constante(imagen(exp->value, getTypeSize(exp->inferredType))); }
+    int visit(DoubleExp* exp) { return constante(imagenConstante(exp)); }
+    int visit(LongExp* exp) { return constante(imagenConstante(exp)); }
+    int visit(BoolExp* exp) { return constante(exp->value ? 1 : 0); }
+
+    int visit(StringExp* exp) {
+        auto it = cadenaDe.find(exp->value);
+        int k;
+        if (it != cadenaDe.end()) {
+            k = it->second;
+        } else {
+            k = static_cast<int>(p.cadenas.size());
+            p.cadenas.push_back(exp->value);
+            cadenaDe.emplace(exp->value, k);
+        }
+        int t = temporal();
+        emit(BC_MOVS, t);
+        p.codigo.back().setBc(static_cast<uint32_t>(k));
+        return t;
+    }
+
+    int visit(IdExp* exp) {
+        auto g = globalDe.find(exp->sym);
+        if (g == globalDe.end()) return registroDe.at(exp->sym);
+        int t = temporal();
+        emit(BC_GLOAD, t);
+        p.codigo.back().setBc(static_cast<uint32_t>(g->second));
+        return t;
+    }
+
+    // Operando de un BinaryExp, como bits de double si `aDouble`
+    // cargarOperando del codegen: a double, o extendido a `ancho` si es más angosto
+    int operando(Exp* e, bool aDouble, int ancho) {
+        int v = dispatch(e);
+        if (!aDouble) {
+            int tam = getTypeSize(e->inferredType);
+            return tam < ancho ? aplicar(extension(tam, esSinSigno(e->inferredType)), v) : v;
+        }
+        static Type tipoDouble(Type::DOUBLE);
+        return convertir(v, e->inferredType, &tipoDouble);
+    }
+
+    int visit(BinaryExp* exp) {
+        if (exp->isnumber) return constante(imagenConstante(exp));
+
+        // Cortocircuito como en el codegen: el resultado queda en 0 o 1
+        if ((exp->op == AND_OP || exp->op == OR_OP) && !(esOmitible(exp->left) && esOmitible(exp->right))) {
+            OpBC decide = exp->op == AND_OP ? BC_JF : BC_JT;
+            int d = temporal();
+            int marca = tope;
+            size_t aCorto = salto(decide, dispatch(exp->left));
+            tope = marca;
+            size_t aCorto2 = salto(decide, dispatch(exp->right));
+            tope = marca;
+            emit(BC_MOVK, d);
+            p.codigo.back().setBc(indiceConstante(exp->op == AND_OP ? 1 : 0));
+            size_t aFin = salto(BC_JMP);
+            aqui(aCorto);
+            aqui(aCorto2);
+            emit(BC_MOVK, d);
+            p.codigo.back().setBc(indiceConstante(exp->op == AND_OP ? 0 : 1));
+            aqui(aFin);
+            return d;
+        }
+
+        bool aDouble = esReal(exp->left->inferredType) || esReal(exp->right->inferredType);
+        bool izquierdo = izquierdaPrimero(exp);
+        Exp* primero = izquierdo ? exp->left : exp->right;
+        Exp* segundo = izquierdo ? exp->right : exp->left;
+
+        bool comparacion = exp->op >= LE_OP && exp->op <= NE_OP;
+        int ancho = comparacion ? max(getTypeSize(exp->left->inferredType), getTypeSize(exp->right->inferredType))
+                                : getTypeSize(exp->inferredType);
+
+        int marca = tope;
+        int r1 = operando(primero, aDouble, ancho);
+        // El codegen ya copió la variable a un registro: que no la cambie el segundo
+        if (esLocal(r1) && asigna(segundo)) {
+            int t = temporal();
+            emit(BC_MOV, t, r1);
+            r1 = t;
+        }
+        int r2 = operando(segundo, aDouble, ancho);
+        int izq = izquierdo ? r1 : r2;
+        int der = izquierdo ? r2 : r1;
+        int alto = tope; // Por encima de los operandos
+        tope = marca;
+        int d = temporal();
+
+        if (aDouble) {
+            switch (exp->op) {
+                case PLUS_OP: emit(BC_FADD, d, izq, der); break;
+                case MINUS_OP: emit(BC_FSUB, d, izq, der); break;
+                case MUL_OP: emit(BC_FMUL, d, izq, der); break;
+                case DIV_OP: emit(BC_FDIV, d, izq, der); break;
+                case POW_OP:
+                    switch (exponenteRealSimple(exp)) {
+                        case 0: emit(BC_MOVK, d); p.codigo.back().setBc(indiceConstante(0x3FF0000000000000ull)); break;
+                        case 1: emit(BC_MOV, d, izq); break;
+                        case 2: emit(BC_FMUL, d, izq, izq); break;
+                        default: emit(BC_FPOW, d, izq, der); break;
+                    }
+                    break;
+                case LE_OP: emit(BC_FLE, d, izq, der); return d;
+                case LT_OP: emit(BC_FLT, d, izq, der); return d;
+                case GT_OP: emit(BC_FGT, d, izq, der); return d;
+                case GE_OP: emit(BC_FGE, d, izq, der); return d;
+                case EQ_OP: emit(BC_FEQ, d, izq, der); return d;
+                case NE_OP: emit(BC_FNE, d, izq, der); return d;
+                default: emit(BC_MOV, d, izq); break; // Sin código: queda el izquierdo
+            }
+            if (exp->inferredType && exp->inferredType->ttype == Type::FLOAT) emit(BC_D2F, d, d);
+            return d;
+        }
+
+        int tam = ancho;
+        bool sinSignoCmp = comparacion && comparacionSinSigno(exp);
+        OpBC familia;
+        switch (exp->op) {
+            case PLUS_OP: familia = BC_ADD_1; break;
+            case MINUS_OP: familia = BC_SUB_1; break;
+            case MUL_OP: familia = BC_MUL_1; break;
+            case DIV_OP: familia = esSinSigno(exp->inferredType) ? BC_UDIV_1 : BC_DIV_1; break;
+            case MOD_OP: familia = esSinSigno(exp->inferredType) ? BC_UMOD_1 : BC_MOD_1; break;
+            case LE_OP: familia = sinSignoCmp ? BC_ULE_1 : BC_LE_1; break;
+            case LT_OP: familia = sinSignoCmp ? BC_ULT_1 : BC_LT_1; break;
+            case GT_OP: familia = sinSignoCmp ? BC_UGT_1 : BC_GT_1; break;
+            case GE_OP: familia = sinSignoCmp ? BC_UGE_1 : BC_GE_1; break;
+            case EQ_OP: familia = BC_EQ_1; break;
+            case NE_OP: familia = BC_NE_1; break;
+            case AND_OP: familia = BC_AND_1; break;
+            case OR_OP: familia = BC_OR_1; break;
+            case POW_OP: {
+                // Base con el ancho del resultado (los productos solo miran
+                // esos bytes) y exponente con su signo; el resultado, extendido.
+                // Ambos van por encima de los operandos, que d puede pisar
+                bool sinSigno = esSinSigno(exp->inferredType);
+                tope = max(tope, alto);
+                int base = temporal(), n = temporal();
+                emit(extension(tam, false), base, izq);
+                emit(extension(tam, sinSigno), n, der);
+                emit(sinSigno ? BC_UPOW : BC_IPOW, d, base, n);
+                tope = d + 1;
+                OpBC ext = extension(tam, sinSigno);
+                if (ext != BC_MOV) emit(ext, d, d);
+                return d;
+            }
+            default:
+                emit(BC_MOV, d, izq); // Los rangos no emiten código
+                return d;
+        }
+        emit(conAncho(familia, tam), d, izq, der);
+        // Con un operando constante el codegen usa desplazamientos o un
+        // inverso y deja el resultado extendido según su tipo
+        long long k;
+        if (operandoReducible(exp, k)) {
+            OpBC ext = extension(tam, esSinSigno(exp->inferredType));
+            if (ext != BC_MOV) emit(ext, d, d);
+        }
+        return d;
+    }
+
+    int visit(FcallExp* exp) {
+        if (exp->receiver) {
+            if (exp->isnumber) return constante(imagenConstante(exp));
+            int v = dispatch(exp->receiver);
+            Type* destino = exp->inferredType;
+            Type* fuente = exp->receiver->inferredType;
+            int tamDestino = getTypeSize(destino);
+            int tamFuente = getTypeSize(fuente);
+
+            if (esReal(destino)) {
+                bool aDouble = destino->ttype == Type::DOUBLE;
+                if (esReal(fuente)) {
+                    if (fuente->ttype == destino->ttype) return v;
+                    return aplicar(aDouble ? BC_F2D : BC_D2F, v);
+                }
+                return enteroAReal(v, fuente, aDouble);
+            }
+            if (esReal(fuente)) {
+                int t = temporal();
+                bool deDouble = fuente->ttype == Type::DOUBLE;
+                emit(deDouble ? BC_D2I8 : BC_F2I8, t, v);
+                OpBC ext = extension(tamDestino, false);
+                if (ext != BC_MOV) emit(ext, t, t);
+                return t;
+            }
+            return enteroAEntero(v, fuente, destino);
+        }
+
+        auto f = funcionDe.find(exp->nombre);
+        if (f == funcionDe.end()) throw runtime_error("bytecode: función desconocida " + exp->nombre);
+        int n = static_cast<int>(exp->argumentos.size());
+        int base = tope;
+        for (int i = 0; i < n; ++i) temporal();
+
+        // El mismo orden que el codegen: primero los de la pila, del último hacia atrás
+        auto argumento = [&](int i) {
+            int v = dispatch(exp->argumentos[i]);
+            if (v != base + i) emit(BC_MOV, base + i, v);
+            tope = base + n;
+        };
+        for (int i = n - 1; i >= 6; --i) argumento(i);
+        int enRegistros = min(n, 6);
+        bool porPila = false;
+        for (int i = 1; i < enRegistros; ++i)
+            if (usaTemporales(exp->argumentos[i])) porPila = true;
+        for (int i = 0; i < enRegistros; ++i) {
+            argumento(i);
+            // `mov %eax, %edi` limpia la parte alta; por la pila viaja el registro entero
+            if (!porPila && getTypeSize(exp->argumentos[i]->inferredType) == 4)
+                emit(BC_ZX4, base + i, base + i);
+        }
+
+        emit(BC_CALL, base, f->second, n);
+        tope = base + 1;
+        return base;
+    }
+};
+
+} // namespace
+
+ProgramaBytecode generarBytecode(Program* programa) {
+    ProgramaBytecode p;
+    GeneradorBytecode(p).run(programa);
+    return p;
+}
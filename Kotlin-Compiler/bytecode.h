@@ -0,0 +1,132 @@
+#ifndef BYTECODE_H
+#define BYTECODE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+#include "ast.h"
+
+using namespace std;
+
+// ===========================================================
+//  Bytecode de registros e intérprete (--interp)
+// ===========================================================
+//
+// Para corridas cortas, compilar a x86 cuesta más que el programa. Este
+// camino baja el AST tipado (después de los pases) a un bytecode de
+// registros compacto y lo ejecuta con un intérprete de despacho por
+// `goto` calculado, sin codegen, ni ensamblador, ni memoria ejecutable.
+//
+// Cada registro guarda la imagen de 64 bits que el backend nativo deja en
+// %rax para ese valor, y cada operación reproduce lo que hace su
+// instrucción x86 con el ancho del tipo: las de 1 y 2 bytes solo cambian
+// los bytes bajos, las de 4 limpian la parte alta, las cargas extienden
+// con o sin signo, la división falla como idiv y los Float/Double se
+// convierten como cvt*. Así la salida coincide con la del binario nativo.
+//
+// Las variables locales y los temporales son registros del marco; una
+// variable guarda su valor ya extendido como lo dejaría su carga, así
+// leerla no cuesta una instrucción.
+
+// Operaciones. Las familias con sufijo de ancho van en el orden 1, 2, 4, 8.
+#define BC_ANCHOS(X, op) X(op##_1) X(op##_2) X(op##_4) X(op##_8)
+#define BC_OPS(X)                                                              \
+    X(MOV)    /* a = b */                                                      \
+    X(MOVK)   /* a = constantes[bc] */                                         \
+    X(MOVS)   /* a = dirección de cadenas[bc] */                               \
+    X(SX1) X(SX2) X(SX4) X(ZX1) X(ZX2) X(ZX4) /* a = extensión de b */         \
+    X(GLOAD)  /* a = globales[bc] */                                           \
+    X(GSTORE) /* globales[b] = a, extendido según la operación c (MOV..ZX4) */ \
+    BC_ANCHOS(X, ADD) BC_ANCHOS(X, SUB) BC_ANCHOS(X, MUL)                      \
+    BC_ANCHOS(X, AND) BC_ANCHOS(X, OR)                                         \
+    BC_ANCHOS(X, DIV) BC_ANCHOS(X, MOD)                                        \
+    BC_ANCHOS(X, UDIV) BC_ANCHOS(X, UMOD)     /* div sin signo */              \
+    BC_ANCHOS(X, LT) BC_ANCHOS(X, LE) BC_ANCHOS(X, GT) BC_ANCHOS(X, GE)        \
+    BC_ANCHOS(X, EQ) BC_ANCHOS(X, NE)                                          \
+    BC_ANCHOS(X, ULT) BC_ANCHOS(X, ULE) BC_ANCHOS(X, UGT) BC_ANCHOS(X, UGE) /* sin signo */ \
+    X(IPOW) X(UPOW) /* a = b ** c en 64 bits (c con o sin signo, como constfold) */ \
+    X(FADD) X(FSUB) X(FMUL) X(FDIV) X(FPOW)   /* sobre bits de double */       \
+    X(FLT) X(FLE) X(FGT) X(FGE) X(FEQ) X(FNE) /* como ucomisd + setcc */       \
+    X(I2D) X(I2F) X(F2D) X(D2F)               /* cvtsi2sd, cvtsi2ss, ... */    \
+    X(U2D)    /* ULong a double, como enteroADouble */                         \
+    X(D2I8) X(F2I8)                           /* cvttsd2siq / cvttss2siq */    \
+    X(JMP)    /* pc = bc */                                                    \
+    X(JF)     /* si a == 0: pc = bc */                                         \
+    X(JT)     /* si a != 0: pc = bc */                                         \
+    X(CALL)   /* a = funciones[b](a, a+1, ... a+c-1) */                        \
+    X(RET)    /* devuelve a */                                                 \
+    X(PRINTI) X(PRINTD) X(PRINTS)             /* printf de a con el formato */
+
+enum OpBC : uint8_t {
+#define BC_ENUM(n) BC_##n,
+    BC_OPS(BC_ENUM)
+#undef BC_ENUM
+    NUM_OPS_BC
+};
+
+// La variante de `familia` (su versión _1) para el ancho `tam`
+inline OpBC conAncho(OpBC familia, int tam) {
+    return static_cast<OpBC>(familia + (tam == 1 ? 0 : tam == 2 ? 1 : tam == 4 ? 2 : 3));
+}
+
+// MOV o una de SX1..ZX4 aplicada a `v`
+inline uint64_t aplicarExtension(OpBC ext, uint64_t v) {
+    switch (ext) {
+        case BC_SX1: return static_cast<uint64_t>(static_cast<int64_t>(static_cast<int8_t>(v)));
+        case BC_SX2: return static_cast<uint64_t>(static_cast<int64_t>(static_cast<int16_t>(v)));
+        case BC_SX4: return static_cast<uint64_t>(static_cast<int64_t>(static_cast<int32_t>(v)));
+        case BC_ZX1: return static_cast<uint8_t>(v);
+        case BC_ZX2: return static_cast<uint16_t>(v);
+        case BC_ZX4: return static_cast<uint32_t>(v);
+        default: return v;
+    }
+}
+
+// 8 bytes: operación y tres registros; los saltos y las constantes usan
+// `b` y `c` juntos como índice de 32 bits
+struct InstrBC {
+    OpBC op;
+    uint8_t relleno = 0;
+    uint16_t a = 0, b = 0, c = 0;
+
+    uint32_t bc() const { return b | (static_cast<uint32_t>(c) << 16); }
+    void setBc(uint32_t v) {
+        b = static_cast<uint16_t>(v);
+        c = static_cast<uint16_t>(v >> 16);
+    }
+};
+static_assert(sizeof(InstrBC) == 8, "InstrBC debe seguir siendo compacta");
+
+struct FuncionBC {
+    string nombre;
+    uint32_t entrada = 0;    // Índice de su primera instrucción
+    uint16_t parametros = 0; // Llegan en los registros 0..parametros-1
+    uint16_t registros = 0;  // Tamaño del marco
+};
+
+struct ProgramaBytecode {
+    vector<InstrBC> codigo;
+    vector<uint64_t> constantes;
+    vector<string> cadenas;
+    vector<uint64_t> globales; // Valor inicial de cada global
+    vector<FuncionBC> funciones;
+    int principal = -1;        // Índice de `main` (-1: no hay)
+};
+
+// Lanza runtime_error ante una construcción que no sabe bajar
+ProgramaBytecode generarBytecode(Program* programa);
+
+using SalidaInterprete = function<void(const char* texto, size_t n)>;
+
+struct ResultadoInterprete {
+    bool ok = false;
+    uint64_t retorno = 0; // Lo que devolvió `main`
+    string error;         // División por cero, pila agotada...
+};
+
+// Ejecuta `main`; la salida de los print llega a `salida`
+ResultadoInterprete interpretar(const ProgramaBytecode& programa, const SalidaInterprete& salida);
+
+#endif // BYTECODE_H
@@ -0,0 +1,180 @@
+#include "passes.h"
+#include <algorithm>
+
+using namespace std;
+
+// ===========================================================
+//   Grafo de llamadas
+// ===========================================================
+
+static FormaArgumento formaDe(Exp* arg) {
+    if (arg->isnumber) return ARG_CONSTANTE;
+    if (arg->kind == NODE_ID) return ARG_VARIABLE;
+    return ARG_EXPRESION;
+}
+
+// ¿El cuerpo imprime? println se traduce a `call printf`
+static bool imprime(Stm* s) {
+    if (!s) return false;
+    switch (s->kind) {
+        case NODE_PRINT: return true;
+        case NODE_BLOCK:
+            for (auto st : static_cast<Block*>(s)->stmts)
+                if (imprime(st)) return true;
+            return false;
+        case NODE_IF: {
+            IfStmt* i = static_cast<IfStmt*>(s);
+            return imprime(i->thenBlock) || imprime(i->elseBlock);
+        }
+        case NODE_WHILE: return imprime(static_cast<WhileStmt*>(s)->block);
+        case NODE_FOR:   return imprime(static_cast<ForStmt*>(s)->block);
+        default:         return false;
+    }
+}
+
+// ¿Algún `**` real se traduce a `call pow`? (ver llamaPow)
+static bool llamaAPow(Stm* s) {
+    bool llama = false;
+    forEachExp(s, [&](Exp* e) {
+        if (e->kind == NODE_BINARY && llamaPow(static_cast<BinaryExp*>(e))) llama = true;
+    });
+    return llama;
+}
+
+const NodoLlamadas* CallGraphAnalysis::nodo(const string& nombre) const {
+    auto it = indice.find(nombre);
+    return it == indice.end() ? nullptr : &funciones[it->second];
+}
+
+bool CallGraphAnalysis::alcanzable(const string& nombre) const {
+    const NodoLlamadas* n = nodo(nombre);
+    return n && n->alcanzable;
+}
+
+void CallGraphAnalysis::agregarSitios(Stm* s, int llamador) {
+    forEachExp(s, [&](Exp* e) {
+        if (e->kind != NODE_FCALL) return;
+        FcallExp* c = static_cast<FcallExp*>(e);
+        if (c->receiver) return; // Conversión: se emite en línea
+        auto it = indice.find(c->nombre);
+        if (it == indice.end()) return;
+
+        SitioLlamada sitio{c, llamador, it->second, {}};
+        for (auto arg : c->argumentos) sitio.formas.push_back(formaDe(arg));
+        int k = static_cast<int>(sitios.size());
+        sitios.push_back(move(sitio));
+        if (llamador >= 0) funciones[llamador].salientes.push_back(k);
+        funciones[it->second].entrantes.push_back(k);
+    });
+}
+
+void CallGraphAnalysis::run(Program* p, PassManager& pm) {
+    funciones.clear();
+    sitios.clear();
+    componentes.clear();
+    indice.clear();
+
+    for (auto dec : p->fdlist) {
+        indice.emplace(dec->nombre, static_cast<int>(funciones.size()));
+        NodoLlamadas n;
+        n.dec = dec;
+        funciones.push_back(n);
+    }
+
+    for (auto v : p->vdlist) agregarSitios(v, -1);
+    for (size_t i = 0; i < funciones.size(); ++i)
+        agregarSitios(funciones[i].dec->cuerpo, static_cast<int>(i));
+
+    for (auto& n : funciones)
+        n.hoja = n.salientes.empty() && !imprime(n.dec->cuerpo) && !llamaAPow(n.dec->cuerpo);
+
+    calcularComponentes();
+
+    auto main = indice.find("main");
+    if (main == indice.end()) {
+        // Sin main definido: no eliminamos nada por seguridad
+        for (auto& n : funciones) n.alcanzable = true;
+        return;
+    }
+    marcarAlcanzables(main->second);
+    // Los inicializadores de globales también son raíces
+    for (auto& sitio : sitios)
+        if (sitio.llamador < 0) marcarAlcanzables(sitio.destino);
+}
+
+// Tarjan iterativo: un programa generado puede encadenar miles de llamadas
+void CallGraphAnalysis::calcularComponentes() {
+    int n = static_cast<int>(funciones.size());
+    vector<int> orden(n, -1), bajo(n, 0), pila;
+    vector<bool> enPila(n, false);
+    vector<pair<int, size_t>> recorrido; // (función, siguiente sitio saliente)
+    int contador = 0;
+
+    for (int raiz = 0; raiz < n; ++raiz) {
+        if (orden[raiz] >= 0) continue;
+        recorrido.push_back({raiz, 0});
+        orden[raiz] = bajo[raiz] = contador++;
+        pila.push_back(raiz);
+        enPila[raiz] = true;
+
+        while (!recorrido.empty()) {
+            int v = recorrido.back().first;
+            size_t& siguiente = recorrido.back().second;
+            if (siguiente < funciones[v].salientes.size()) {
+                int w = sitios[funciones[v].salientes[siguiente++]].destino;
+                if (orden[w] < 0) {
+                    orden[w] = bajo[w] = contador++;
+                    pila.push_back(w);
+                    enPila[w] = true;
+                    recorrido.push_back({w, 0});
+                } else if (enPila[w]) {
+                    bajo[v] = min(bajo[v], orden[w]);
+                }
+                continue;
+            }
+
+            recorrido.pop_back();
+            if (!recorrido.empty()) {
+                int padre = recorrido.back().first;
+                bajo[padre] = min(bajo[padre], bajo[v]);
+            }
+            if (bajo[v] != orden[v]) continue;
+
+            // v es la raíz de una componente
+            int c = static_cast<int>(componentes.size());
+            componentes.emplace_back();
+            int w;
+            do {
+                w = pila.back();
+                pila.pop_back();
+                enPila[w] = false;
+                funciones[w].componente = c;
+                componentes[c].push_back(w);
+            } while (w != v);
+        }
+    }
+
+    for (auto& comp : componentes) {
+        if (comp.size() > 1) {
+            for (int f : comp) funciones[f].recursiva = true;
+            continue;
+        }
+        NodoLlamadas& f = funciones[comp[0]];
+        for (int k : f.salientes)
+            if (sitios[k].destino == comp[0]) f.recursiva = true;
+    }
+}
+
+void CallGraphAnalysis::marcarAlcanzables(int raiz) {
+    vector<int> pendientes = {raiz};
+    while (!pendientes.empty()) {
+        int f = pendientes.back();
+        pendientes.pop_back();
+        if (funciones[f].alcanzable) continue;
+        funciones[f].alcanzable = true;
+        for (int k : funciones[f].salientes) {
+            int destino = sitios[k].destino;
+            if (!funciones[destino].alcanzable) pendientes.push_back(destino);
+        }
+    }
+}
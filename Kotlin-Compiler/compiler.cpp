@@ -0,0 +1,131 @@
+#include "compiler.h"
+#include "scanner.h"
+#include "parser.h"
+#include "resolver.h"
+#include "TypeChecker.h"
+#include "framelayout.h"
+#include "regalloc.h"
+#include "visitor.h"
+#include "peephole.h"
+#include <sstream>
+#include <stdexcept>
+
+using namespace std;
+
+CompilerContext::CompilerContext(const OpcionesCompilacion& opciones)
+    : opciones(opciones), passes(opciones.optLevel, opciones.timePasses) {
+    passes.registerPass(new ScalarEvolutionPass(&tipos));
+    passes.registerPass(new LoopUnrollPass(&tipos, opciones.desenrollado));
+}
+
+CompilerContext::~CompilerContext() {
+    delete programa;
+}
+
+void CompilerContext::reportar(Diagnostico::Fase fase, const string& mensaje) {
+    diagnosticos.push_back({fase, mensaje});
+}
+
+void CompilerContext::reportar(Diagnostico::Fase fase, const vector<string>& mensajes) {
+    for (auto& m : mensajes) reportar(fase, m);
+}
+
+// Cada fase se detiene en cuanto la anterior reporta errores
+static bool ejecutar(CompilerContext& ctx, const string& fuente, ResultadoCompilacion& r) {
+    // 1. Scanner + parser: los errores llegan como excepción
+    try {
+        Scanner scanner(fuente.c_str());
+        Parser parser(&scanner);
+        ctx.passes.time("parser", [&]() { ctx.programa = parser.parseProgram(); });
+    } catch (const exception& e) {
+        ctx.reportar(Diagnostico::PARSER, e.what());
+        return false;
+    }
+
+    // 2. Resolución de nombres
+    Resolver resolver;
+    bool ok = false;
+    ctx.passes.time("resolver", [&]() { ok = resolver.resolve(ctx.programa); });
+    if (!ok) {
+        ctx.reportar(Diagnostico::RESOLVER, resolver.errores);
+        return false;
+    }
+
+    // 3. Tipos
+    TypeChecker typeChecker(ctx.tipos);
+    if (ctx.opciones.hilos > 0) typeChecker.hilos = ctx.opciones.hilos;
+    typeChecker.cache = ctx.opciones.cacheTipos;
+    ctx.passes.time("typechecker", [&]() { ok = typeChecker.typecheck(ctx.programa); });
+    ctx.funcionesReutilizadas = typeChecker.reutilizadas;
+    ctx.funcionesRevisadas = static_cast<int>(ctx.programa->fdlist.size());
+    if (!ok) {
+        ctx.reportar(Diagnostico::TIPOS, typeChecker.errores);
+        return false;
+    }
+
+    // 4. Pases de optimización según -O, registros y marco de cada función, codegen
+    ctx.passes.run(ctx.programa);
+    // El intérprete parte del AST ya optimizado, antes de asignar registros
+    if (ctx.opciones.bytecode)
+        ctx.passes.time("bytecode", [&]() { r.bytecode = generarBytecode(ctx.programa); });
+    if (ctx.opciones.optLevel >= 1) {
+        RegisterAllocator registros;
+        ctx.passes.time("regalloc", [&]() { registros.run(ctx.programa); });
+    }
+    FrameLayout marco;
+    ctx.passes.time("frame-layout", [&]() { marco.run(ctx.programa); });
+    CodigoX86 codigo;
+    GenCodeVisitor generador(codigo);
+    ctx.passes.time("codegen", [&]() { generador.generar(ctx.programa); });
+
+    // 5. Peephole sobre la lista de instrucciones y escritura del texto
+    if (ctx.opciones.optLevel >= 1) {
+        Peephole peephole;
+        ctx.passes.time("peephole", [&]() { peephole.run(codigo.instrs); });
+        if (ctx.opciones.estadisticasPeephole) {
+            ostringstream reporte;
+            peephole.reporte(reporte);
+            ctx.reportePeephole = reporte.str();
+        }
+    }
+    ctx.passes.time("asm-writer", [&]() { r.ensamblador = escribirEnsamblador(codigo); });
+
+    // 6. Código máquina: el .o (o el JIT) sale de las mismas instrucciones, sin pasar por `as`
+    if (ctx.opciones.objeto || ctx.opciones.maquina) {
+        ctx.passes.time("encoder", [&]() { r.maquina = codificar(codigo); });
+        if (ctx.opciones.objeto)
+            ctx.passes.time("elf-writer", [&]() { r.objeto = escribirObjetoElf(r.maquina); });
+        if (!ctx.opciones.maquina) r.maquina = CodigoMaquina();
+    }
+    return true;
+}
+
+ResultadoCompilacion compilar(const string& fuente, const OpcionesCompilacion& opciones) {
+    ResultadoCompilacion r;
+    CompilerContext ctx(opciones);
+    try {
+        r.ok = ejecutar(ctx, fuente, r);
+    } catch (const exception& e) {
+        // Errores internos (p. ej. logic_error de Environment): no tumban el proceso
+        ctx.reportar(Diagnostico::INTERNO, e.what());
+        r.ok = false;
+    }
+    if (!r.ok) {
+        r.ensamblador.clear();
+        r.objeto.clear();
+        r.maquina = CodigoMaquina();
+        r.bytecode = ProgramaBytecode();
+    }
+    r.diagnosticos = ctx.diagnosticos;
+    r.funcionesReutilizadas = ctx.funcionesReutilizadas;
+    r.reportePeephole = ctx.reportePeephole;
+    if (opciones.timePasses) {
+        ostringstream reporte;
+        ctx.passes.printTimeReport(reporte);
+        if (opciones.cacheTipos && ctx.funcionesRevisadas > 0)
+            reporte << "cache de tipos: " << ctx.funcionesReutilizadas << " de "
+                    << ctx.funcionesRevisadas << " funciones reutilizadas\n";
+        r.reporteTiempos = reporte.str();
+    }
+    return r;
+}
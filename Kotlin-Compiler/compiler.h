@@ -0,0 +1,77 @@
+#ifndef COMPILER_H
+#define COMPILER_H
+
+#include <string>
+#include <vector>
+#include "ast.h"
+#include "semantic_types.h"
+#include "passes.h"
+#include "typecache.h"
+#include "encoder.h"
+#include "bytecode.h"
+
+using namespace std;
+
+// ===========================================================
+//  Compilación como biblioteca
+// ===========================================================
+//
+// `compilar` recorre todo el pipeline (parser, resolver, typechecker, pases,
+// codegen, peephole) sobre un string y devuelve el resultado; nunca termina
+// el proceso. Todo el estado vive en un CompilerContext por compilación,
+// así que se pueden compilar muchos programas en el mismo proceso (y en hilos distintos).
+
+struct Diagnostico {
+    enum Fase { PARSER, RESOLVER, TIPOS, INTERNO };
+    Fase fase;
+    string mensaje;
+};
+
+struct OpcionesCompilacion {
+    int optLevel = 1;         // -O0 / -O1 / -O2
+    bool timePasses = false;  // -ftime-passes
+    int hilos = 0;            // Hilos del typechecker (0: uno por núcleo)
+    CacheTipos* cacheTipos = nullptr; // Se reutiliza y actualiza (nullptr: sin caché)
+    bool estadisticasPeephole = false; // -fpeephole-stats
+    bool objeto = false;      // -c: además del texto, el .o codificado en memoria
+    bool maquina = false;     // --jit: deja el código máquina en el resultado
+    bool bytecode = false;    // --interp: baja además el programa a bytecode
+    int desenrollado = 4;     // -funroll=N: copias del cuerpo por vuelta (1: no desenrolla)
+};
+
+struct ResultadoCompilacion {
+    bool ok = false;
+    string ensamblador;               // Vacío si hubo errores
+    vector<Diagnostico> diagnosticos; // En orden de aparición
+    string reporteTiempos;            // Solo con timePasses
+    int funcionesReutilizadas = 0;    // Tomadas de la caché de tipos
+    string reportePeephole;           // Solo con estadisticasPeephole (y -O1/-O2)
+    string objeto;                    // ELF reubicable; solo con opciones.objeto
+    CodigoMaquina maquina;            // Solo con opciones.maquina
+    ProgramaBytecode bytecode;        // Solo con opciones.bytecode
+};
+
+// Estado de una compilación. Libera el AST y los tipos al destruirse.
+class CompilerContext {
+public:
+    OpcionesCompilacion opciones;
+    TypeTable tipos;            // Instancias canónicas de Type
+    PassManager passes;
+    Program* programa = nullptr;
+    vector<Diagnostico> diagnosticos;
+    int funcionesReutilizadas = 0; // De la caché de tipos, sobre
+    int funcionesRevisadas = 0;    // todas las del programa
+    string reportePeephole;
+
+    explicit CompilerContext(const OpcionesCompilacion& opciones);
+    ~CompilerContext();
+    CompilerContext(const CompilerContext&) = delete;
+    CompilerContext& operator=(const CompilerContext&) = delete;
+
+    void reportar(Diagnostico::Fase fase, const string& mensaje);
+    void reportar(Diagnostico::Fase fase, const vector<string>& mensajes);
+};
+
+ResultadoCompilacion compilar(const string& fuente, const OpcionesCompilacion& opciones = OpcionesCompilacion());
+
+#endif // COMPILER_H
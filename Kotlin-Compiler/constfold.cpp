@@ -0,0 +1,349 @@
+#include "passes.h"
+#include "semantic_types.h"
+#include <cmath>
+#include <cstring>
+#include <cstdint>
+
+using namespace std;
+
+// ===========================================================
+//   Plegado de constantes con la semántica de cada Type::TType
+// ===========================================================
+//
+// Los enteros se guardan en Exp::valor ya ajustados al ancho de su tipo
+// (extensión de signo o de ceros a 64 bits); Float/Double en Exp::valorReal.
+// Las operaciones que en ejecución atrapan (división por cero, MIN / -1)
+// o cuyo resultado no está definido en x86 no se pliegan.
+
+static bool isReal(Type::TType tt) {
+    return tt == Type::FLOAT || tt == Type::DOUBLE;
+}
+
+static bool isUnsignedType(Type::TType tt) {
+    return tt == Type::UBYTE || tt == Type::USHORT || tt == Type::UINT || tt == Type::ULONG;
+}
+
+static bool isFoldable(Type* t) {
+    return t && (t->isNumeric() || t->ttype == Type::BOOL);
+}
+
+// Rango de promoción entero (igual que TypeChecker::visit(BinaryExp*))
+static int intRank(Type::TType tt) {
+    switch (tt) {
+        case Type::BYTE:
+        case Type::UBYTE: return 1;
+        case Type::SHORT:
+        case Type::USHORT: return 2;
+        case Type::INT:
+        case Type::UINT: return 3;
+        case Type::LONG:
+        case Type::ULONG: return 4;
+        default: return 0;
+    }
+}
+
+// Tipo en que se comparan dos enteros: el de mayor rango; a igual rango, el izquierdo
+static Type::TType tipoComparacion(Type::TType a, Type::TType b) {
+    return intRank(a) >= intRank(b) ? a : b;
+}
+
+// Ajusta v al ancho y signo de tt
+static long long wrapTo(Type::TType tt, unsigned long long v) {
+    switch (tt) {
+        case Type::BYTE:   return (int8_t)v;
+        case Type::UBYTE:  return (uint8_t)v;
+        case Type::SHORT:  return (int16_t)v;
+        case Type::USHORT: return (uint16_t)v;
+        case Type::INT:    return (int32_t)v;
+        case Type::UINT:   return (uint32_t)v;
+        case Type::BOOL:   return v != 0;
+        default:           return (long long)v; // LONG / ULONG
+    }
+}
+
+// Constante leída de un nodo plegado
+struct Constante {
+    Type::TType tipo;
+    long long i;
+    double d;
+};
+
+static bool readConst(Exp* e, Constante& c) {
+    if (!e || !e->isnumber || !isFoldable(e->inferredType)) return false;
+    c.tipo = e->inferredType->ttype;
+    c.i = e->valor;
+    c.d = e->valorReal;
+    return true;
+}
+
+// Convierte c al tipo destino. Devuelve false si el resultado no está
+// definido en la conversión que haría el código generado.
+static bool convert(const Constante& c, Type::TType dst, Constante& out) {
+    out.tipo = dst;
+    out.i = 0;
+    out.d = 0;
+    if (isReal(dst)) {
+        double d;
+        if (isReal(c.tipo)) d = c.d;
+        else if (c.tipo == Type::ULONG) d = (double)(unsigned long long)c.i; // El codegen pasa por double
+        else if (dst == Type::FLOAT) d = (float)c.i; // Conversión directa con cvtsi2ss: un solo redondeo
+        else d = (double)c.i;
+        out.d = dst == Type::FLOAT ? (double)(float)d : d;
+        return true;
+    }
+    if (isReal(c.tipo)) {
+        // cvttsd2si: truncamiento hacia cero, indefinido fuera del rango de 64 bits
+        if (std::isnan(c.d) || c.d >= 9223372036854775808.0 || c.d < -9223372036854775808.0) return false;
+        out.i = wrapTo(dst, (unsigned long long)(long long)c.d);
+        return true;
+    }
+    out.i = wrapTo(dst, (unsigned long long)c.i);
+    return true;
+}
+
+// Potencia entera por cuadrados, con desborde modular
+static unsigned long long powWrap(unsigned long long base, unsigned long long exp) {
+    unsigned long long result = 1;
+    while (exp) {
+        if (exp & 1) result *= base;
+        base *= base;
+        exp >>= 1;
+    }
+    return result;
+}
+
+static long long minOf(Type::TType tt) {
+    switch (tt) {
+        case Type::BYTE:  return INT8_MIN;
+        case Type::SHORT: return INT16_MIN;
+        case Type::INT:   return INT32_MIN;
+        default:          return INT64_MIN;
+    }
+}
+
+// Aritmética en el tipo resultado r
+static bool foldArith(BinaryOp op, const Constante& a, const Constante& b, Type::TType r, Constante& out) {
+    out.tipo = r;
+    out.i = 0;
+    out.d = 0;
+    if (isReal(r)) {
+        double x = a.d, y = b.d, z;
+        switch (op) {
+            case PLUS_OP:  z = x + y; break;
+            case MINUS_OP: z = x - y; break;
+            case MUL_OP:   z = x * y; break;
+            case DIV_OP:   z = x / y; break;
+            // Los exponentes 0, 1 y 2 como en el codegen (ver exponenteRealSimple)
+            case POW_OP:   z = y == 0 ? 1 : y == 1 ? x : y == 2 ? x * x : pow(x, y); break;
+            default: return false; // MOD sobre flotantes no tiene codegen
+        }
+        // Con Float se calcula en double y se redondea una vez (igual que cvtsd2ss)
+        out.d = r == Type::FLOAT ? (double)(float)z : z;
+        return true;
+    }
+
+    bool sinSigno = isUnsignedType(r);
+    unsigned long long x = (unsigned long long)a.i, y = (unsigned long long)b.i, z;
+    switch (op) {
+        case PLUS_OP:  z = x + y; break;
+        case MINUS_OP: z = x - y; break;
+        case MUL_OP:   z = x * y; break;
+        case DIV_OP:
+        case MOD_OP:
+            if (y == 0) return false;
+            if (sinSigno) {
+                z = op == DIV_OP ? x / y : x % y;
+            } else {
+                if (a.i == minOf(r) && b.i == -1) return false; // idiv atrapa
+                z = (unsigned long long)(op == DIV_OP ? a.i / b.i : a.i % b.i);
+            }
+            break;
+        case POW_OP:
+            if (!sinSigno && b.i < 0) {
+                // Exponente negativo: solo 1 y -1 dan un resultado entero distinto de 0
+                if (a.i == 1) z = 1;
+                else if (a.i == -1) z = (b.i & 1) ? (unsigned long long)-1LL : 1;
+                else z = 0;
+            } else {
+                z = powWrap(x, y);
+            }
+            break;
+        default: return false;
+    }
+    out.i = wrapTo(r, z);
+    return true;
+}
+
+// Comparación en el tipo común de ambos operandos
+static bool foldCompare(BinaryOp op, const Constante& a, const Constante& b, Constante& out) {
+    int cmp;
+    if (isReal(a.tipo) || isReal(b.tipo)) {
+        Constante x, y;
+        convert(a, Type::DOUBLE, x);
+        convert(b, Type::DOUBLE, y);
+        // Con NaN solo != es verdadero
+        if (std::isnan(x.d) || std::isnan(y.d)) {
+            out.tipo = Type::BOOL;
+            out.i = op == NE_OP;
+            out.d = 0;
+            return true;
+        }
+        cmp = x.d < y.d ? -1 : (x.d > y.d ? 1 : 0);
+    } else {
+        Type::TType comun = tipoComparacion(a.tipo, b.tipo);
+        Constante x, y;
+        convert(a, comun, x);
+        convert(b, comun, y);
+        if (isUnsignedType(comun)) {
+            unsigned long long ux = x.i, uy = y.i;
+            cmp = ux < uy ? -1 : (ux > uy ? 1 : 0);
+        } else {
+            cmp = x.i < y.i ? -1 : (x.i > y.i ? 1 : 0);
+        }
+    }
+    bool r;
+    switch (op) {
+        case LE_OP: r = cmp <= 0; break;
+        case LT_OP: r = cmp < 0; break;
+        case GT_OP: r = cmp > 0; break;
+        case GE_OP: r = cmp >= 0; break;
+        case EQ_OP: r = cmp == 0; break;
+        case NE_OP: r = cmp != 0; break;
+        default: return false;
+    }
+    out.tipo = Type::BOOL;
+    out.i = r;
+    out.d = 0;
+    return true;
+}
+
+static bool foldBinary(BinaryExp* b, Constante& out) {
+    Constante l, r;
+    // Cortocircuito: con `false && x` y `true || x` el derecho no se evalúa
+    if ((b->op == AND_OP || b->op == OR_OP) && readConst(b->left, l) && (l.i != 0) == (b->op == OR_OP)) {
+        out.tipo = Type::BOOL;
+        out.i = l.i != 0;
+        out.d = 0;
+        return true;
+    }
+    if (!readConst(b->left, l) || !readConst(b->right, r) || !isFoldable(b->inferredType)) return false;
+    Type::TType res = b->inferredType->ttype;
+
+    switch (b->op) {
+        case PLUS_OP:
+        case MINUS_OP:
+        case MUL_OP:
+        case DIV_OP:
+        case MOD_OP:
+        case POW_OP: {
+            // Con resultado real el codegen lleva ambos operandos a double
+            // (ver cargarOperando); un Float se redondea solo al final
+            Type::TType operandos = isReal(res) ? Type::DOUBLE : res;
+            Constante x, y;
+            if (!convert(l, operandos, x) || !convert(r, operandos, y)) return false;
+            return foldArith(b->op, x, y, res, out);
+        }
+        case LE_OP:
+        case LT_OP:
+        case GT_OP:
+        case GE_OP:
+        case EQ_OP:
+        case NE_OP:
+            return foldCompare(b->op, l, r, out);
+        case AND_OP:
+        case OR_OP:
+            out.tipo = Type::BOOL;
+            out.i = b->op == AND_OP ? (l.i != 0 && r.i != 0) : (l.i != 0 || r.i != 0);
+            out.d = 0;
+            return true;
+        default:
+            return false; // Rangos y step no son valores escalares
+    }
+}
+
+static void store(Exp* e, const Constante& c) {
+    e->isnumber = true;
+    e->valor = c.i;
+    e->valorReal = c.d;
+}
+
+bool ConstantFoldPass::run(Program* p, PassManager& pm) {
+    bool changed = false;
+    forEachExp(p, [&](Exp* e) {
+        if (e->isnumber) return;
+        Constante c = {};
+        if (e->kind == NODE_BINARY) {
+            if (!foldBinary(static_cast<BinaryExp*>(e), c)) return;
+        } else if (e->kind == NODE_FCALL) {
+            FcallExp* f = static_cast<FcallExp*>(e);
+            // Conversiones con receptor constante: 100.toByte(), 2.5.toInt()...
+            Constante recv;
+            if (!f->receiver || !readConst(f->receiver, recv) || !isFoldable(f->inferredType)) return;
+            if (!convert(recv, f->inferredType->ttype, c)) return;
+        } else {
+            return;
+        }
+        store(e, c);
+        changed = true;
+    });
+    return changed;
+}
+
+int exponenteRealSimple(BinaryExp* e) {
+    Constante c, d;
+    if (e->op != POW_OP || !readConst(e->right, c) || !convert(c, Type::DOUBLE, d)) return -1;
+    if (d.d == 0) return 0;
+    if (d.d == 1) return 1;
+    if (d.d == 2) return 2;
+    return -1;
+}
+
+bool llamaPow(BinaryExp* e) {
+    return e->op == POW_OP && !e->isnumber && e->inferredType && isReal(e->inferredType->ttype) &&
+           exponenteRealSimple(e) < 0;
+}
+
+bool comparacionSinSigno(BinaryExp* e) {
+    Type* l = e->left->inferredType;
+    Type* r = e->right->inferredType;
+    if (!l || !r || isReal(l->ttype) || isReal(r->ttype)) return false;
+    return isUnsignedType(tipoComparacion(l->ttype, r->ttype));
+}
+
+Exp* operandoReducible(BinaryExp* e, long long& k) {
+    if (e->op != MUL_OP && e->op != DIV_OP && e->op != MOD_OP) return nullptr;
+    Type* t = e->inferredType;
+    if (e->isnumber || !t || !t->isNumeric() || isReal(t->ttype)) return nullptr;
+    if (e->op == MUL_OP) {
+        if (constantBits(e->right, t, k)) return e->right;
+        return constantBits(e->left, t, k) ? e->left : nullptr;
+    }
+    if (!constantBits(e->right, t, k) || k == 0) return nullptr;
+    if (!isUnsignedType(t->ttype)) return k == -1 ? nullptr : e->right;
+    // Sin signo de 64 bits: arriba de 2^63 el inverso no cabe en 65 bits
+    return static_cast<unsigned long long>(k) <= (1ull << 63) ? e->right : nullptr;
+}
+
+Exp* constanteDe(long long v, Type* t) {
+    Exp* e = new LongExp(wrapTo(t->ttype, static_cast<unsigned long long>(v)));
+    e->inferredType = t;
+    return e;
+}
+
+bool constantBits(Exp* e, Type* target, long long& bits) {
+    Constante c, out;
+    if (!readConst(e, c)) return false;
+    Type::TType dst = isFoldable(target) ? target->ttype : c.tipo;
+    if (!convert(c, dst, out)) return false;
+    if (dst == Type::DOUBLE) {
+        memcpy(&bits, &out.d, sizeof(bits));
+    } else if (dst == Type::FLOAT) {
+        float f = (float)out.d;
+        uint32_t b32;
+        memcpy(&b32, &f, sizeof(b32));
+        bits = b32;
+    } else {
+        bits = out.i;
+    }
+    return true;
+}
@@ -0,0 +1,564 @@
+#include "encoder.h"
+#include <cctype>
+#include <cstdint>
+#include <stdexcept>
+#include <unordered_map>
+
+using namespace std;
+
+// Número de codificación (0-15); XMM0/XMM1 y AH usan los bajos
+static int numero(uint8_t reg) {
+    if (reg == XMM0) return 0;
+    if (reg == XMM1) return 1;
+    if (reg == AH) return 4;
+    return reg;
+}
+
+static bool esXmm(const Operando& o) {
+    return o.tipo == Operando::REG && (o.reg == XMM0 || o.reg == XMM1);
+}
+
+// spl, bpl, sil y dil solo existen con prefijo REX (sin él son ah, ch, dh, bh)
+static bool necesitaRex(const Operando& o) {
+    return o.tipo == Operando::REG && o.tam == 1 && o.reg >= RSP && o.reg <= RDI;
+}
+
+static bool cabe8(int64_t v) { return v >= INT8_MIN && v <= INT8_MAX; }
+static bool cabe32(int64_t v) { return v >= INT32_MIN && v <= INT32_MAX; }
+
+// Extensión de ModRM (/n) de las operaciones aritméticas con inmediato, que
+// además da su opcode base (n*8)
+static int extensionAlu(Op op) {
+    switch (op) {
+        case ADD: return 0;
+        case OR: return 1;
+        case AND: return 4;
+        case SUB: return 5;
+        case XOR: return 6;
+        default: return 7; // CMP
+    }
+}
+
+// ===========================================================
+//   Codificador
+// ===========================================================
+
+namespace {
+
+class Codificador {
+private:
+    const CodigoX86& codigo;
+    CodigoMaquina m;
+    vector<uint8_t>* sec = nullptr; // Sección actual (nullptr: una que no se guarda)
+    unordered_map<int, int> simboloDe; // Índice en codigo.simbolos -> en m.simbolos
+
+    // Etiquetas de .text por (símbolo, número) y saltos a completar
+    unordered_map<int64_t, uint64_t> etiquetas;
+    struct Salto {
+        uint64_t pos; // De los 4 bytes del desplazamiento
+        Operando destino;
+        bool llamada;
+    };
+    vector<Salto> saltos;
+
+    static int64_t clave(const Operando& e) {
+        return (static_cast<int64_t>(e.simbolo) << 32) | static_cast<uint32_t>(e.valor);
+    }
+
+    string nombre(const Operando& e) const {
+        string n = codigo.simbolos[e.simbolo];
+        if (e.valor >= 0) n += to_string(e.valor);
+        return n;
+    }
+
+    [[noreturn]] void noSoportada(const Instr& i) const {
+        throw runtime_error("codificador: forma de instrucción no soportada (op " + to_string(i.op) + ")");
+    }
+
+    int simboloMaquina(int indice) {
+        auto it = simboloDe.find(indice);
+        if (it != simboloDe.end()) return it->second;
+        CodigoMaquina::Simbolo s;
+        s.nombre = codigo.simbolos[indice];
+        size_t plt = s.nombre.find("@PLT");
+        if (plt != string::npos) s.nombre.resize(plt);
+        int i = static_cast<int>(m.simbolos.size());
+        m.simbolos.push_back(s);
+        simboloDe.emplace(indice, i);
+        return i;
+    }
+
+    void definir(int indice, CodigoMaquina::Seccion seccion) {
+        auto& s = m.simbolos[simboloMaquina(indice)];
+        s.seccion = seccion;
+        s.offset = sec->size();
+    }
+
+    void b(uint8_t x) { sec->push_back(x); }
+    void le(uint64_t v, int n) {
+        for (int k = 0; k < n; ++k) b(static_cast<uint8_t>(v >> (8 * k)));
+    }
+
+    // [prefijo] [REX] opcode ModRM [SIB] [desplazamiento]; el inmediato (de
+    // `bytesInm` bytes) lo escribe quien llama. `reg` es el campo reg de
+    // ModRM: un registro o la extensión /n del opcode.
+    void modrm(uint8_t prefijo, bool w, initializer_list<uint8_t> opcode, int reg, bool regRex,
+               const Operando& rm, int bytesInm = 0) {
+        uint8_t rex = 0x40 | (w ? 8 : 0) | ((reg & 8) ? 4 : 0);
+        bool forzar = regRex;
+        if (rm.tipo == Operando::REG) {
+            if (numero(rm.reg) & 8) rex |= 1;
+            forzar = forzar || necesitaRex(rm);
+        } else if (rm.tipo == Operando::MEM && rm.reg != RIP) {
+            if (rm.reg & 8) rex |= 1;
+        } else if (rm.tipo != Operando::MEM) {
+            throw runtime_error("codificador: operando r/m inválido");
+        }
+        bool conRex = rex != 0x40 || forzar;
+        if (conRex && ((rm.tipo == Operando::REG && rm.reg == AH)))
+            throw runtime_error("codificador: %ah no se puede usar con prefijo REX");
+
+        if (prefijo) b(prefijo);
+        if (conRex) b(rex);
+        for (uint8_t o : opcode) b(o);
+
+        int r = (reg & 7) << 3;
+        if (rm.tipo == Operando::REG) {
+            b(static_cast<uint8_t>(0xC0 | r | (numero(rm.reg) & 7)));
+        } else if (rm.reg == RIP) {
+            b(static_cast<uint8_t>(0x05 | r));
+            // El procesador suma el desplazamiento al final de la instrucción
+            m.reubicaciones.push_back({sec->size(), simboloMaquina(rm.simbolo), false, -4 - bytesInm});
+            le(0, 4);
+        } else {
+            int base = rm.reg & 7;
+            int64_t d = rm.valor;
+            // [rbp] y [r13] sin desplazamiento significan otra cosa: van con disp8 = 0
+            int mod = (d == 0 && base != 5) ? 0 : cabe8(d) ? 1 : 2;
+            b(static_cast<uint8_t>((mod << 6) | r | base));
+            if (base == 4) b(0x24); // SIB de [rsp]/[r12]
+            if (mod == 1) le(static_cast<uint64_t>(d), 1);
+            else if (mod == 2) le(static_cast<uint64_t>(d), 4);
+        }
+    }
+
+    // Con un registro en el campo reg
+    void modrm(uint8_t prefijo, bool w, initializer_list<uint8_t> opcode, const Operando& reg,
+               const Operando& rm, int bytesInm = 0) {
+        modrm(prefijo, w, opcode, numero(reg.reg), necesitaRex(reg), rm, bytesInm);
+    }
+
+    static uint8_t p66(int tam) { return tam == 2 ? 0x66 : 0; }
+
+    void salto(initializer_list<uint8_t> opcode, const Operando& destino, bool llamada) {
+        for (uint8_t o : opcode) b(o);
+        saltos.push_back({sec->size(), destino, llamada});
+        le(0, 4);
+    }
+
+    // Grupo F6/F7 de un operando (neg, mul, imul, div, idiv): /n
+    void unario(const Operando& a, int n) {
+        modrm(p66(a.tam), a.tam == 8, {static_cast<uint8_t>(a.tam == 1 ? 0xF6 : 0xF7)}, n, false, a);
+    }
+
+    void mov(const Instr& i) {
+        const Operando& a = i.a;
+        const Operando& d = i.b;
+        if (esXmm(d)) { modrm(0x66, a.tam == 8, {0x0F, 0x6E}, d, a); return; }
+        if (esXmm(a)) { modrm(0x66, d.tam == 8, {0x0F, 0x7E}, a, d); return; }
+        int t = d.tam;
+        if (a.tipo == Operando::INM) {
+            int64_t v = a.valor;
+            if (d.tipo == Operando::REG && !(t == 8 && cabe32(v))) {
+                // mov $v, %r (B8+r); con 8 bytes es movabs
+                int n = numero(d.reg);
+                if (t == 2) b(0x66);
+                uint8_t rex = 0x40 | (t == 8 ? 8 : 0) | ((n & 8) ? 1 : 0);
+                if (rex != 0x40 || necesitaRex(d)) b(rex);
+                b(static_cast<uint8_t>((t == 1 ? 0xB0 : 0xB8) + (n & 7)));
+                le(static_cast<uint64_t>(v), t);
+                return;
+            }
+            if (t == 8 && !cabe32(v)) noSoportada(i);
+            int n = t == 8 ? 4 : t;
+            modrm(p66(t), t == 8, {static_cast<uint8_t>(t == 1 ? 0xC6 : 0xC7)}, 0, false, d, n);
+            le(static_cast<uint64_t>(v), n);
+            return;
+        }
+        if (a.tipo == Operando::REG) {
+            modrm(p66(a.tam), a.tam == 8, {static_cast<uint8_t>(a.tam == 1 ? 0x88 : 0x89)}, a, d);
+        } else if (a.tipo == Operando::MEM && d.tipo == Operando::REG) {
+            modrm(p66(t), t == 8, {static_cast<uint8_t>(t == 1 ? 0x8A : 0x8B)}, d, a);
+        } else {
+            noSoportada(i);
+        }
+    }
+
+    void alu(const Instr& i) {
+        int n = extensionAlu(i.op);
+        const Operando& a = i.a;
+        const Operando& d = i.b;
+        if (a.tipo == Operando::INM) {
+            int t = d.tam;
+            int64_t v = a.valor;
+            if (d.esReg(RAX) && (t == 1 || !cabe8(v))) {
+                // Forma corta con %al/%ax/%eax/%rax, sin ModRM (la que elige `as`)
+                if (t != 1 && !cabe32(v)) noSoportada(i);
+                int bytes = t == 1 ? 1 : t == 2 ? 2 : 4;
+                if (t == 2) b(0x66);
+                if (t == 8) b(0x48);
+                b(static_cast<uint8_t>(n * 8 + (t == 1 ? 4 : 5)));
+                le(static_cast<uint64_t>(v), bytes);
+            } else if (t == 1) {
+                modrm(0, false, {0x80}, n, false, d, 1);
+                le(static_cast<uint64_t>(v), 1);
+            } else if (cabe8(v)) {
+                modrm(p66(t), t == 8, {0x83}, n, false, d, 1);
+                le(static_cast<uint64_t>(v), 1);
+            } else {
+                if (!cabe32(v)) noSoportada(i);
+                int bytes = t == 2 ? 2 : 4;
+                modrm(p66(t), t == 8, {0x81}, n, false, d, bytes);
+                le(static_cast<uint64_t>(v), bytes);
+            }
+        } else if (a.tipo == Operando::REG) {
+            modrm(p66(a.tam), a.tam == 8, {static_cast<uint8_t>(n * 8 + (a.tam == 1 ? 0 : 1))}, a, d);
+        } else if (a.tipo == Operando::MEM && d.tipo == Operando::REG) {
+            modrm(p66(d.tam), d.tam == 8, {static_cast<uint8_t>(n * 8 + (d.tam == 1 ? 2 : 3))}, d, a);
+        } else {
+            noSoportada(i);
+        }
+    }
+
+    // Decodifica los escapes que `as` interpreta dentro de .string
+    void cadena(const string& texto) {
+        for (size_t k = 0; k < texto.size(); ++k) {
+            char ch = texto[k];
+            if (ch != '\\' || k + 1 == texto.size()) { b(static_cast<uint8_t>(ch)); continue; }
+            char e = texto[++k];
+            switch (e) {
+                case 'n': b('\n'); break;
+                case 't': b('\t'); break;
+                case 'r': b('\r'); break;
+                case 'b': b('\b'); break;
+                case 'f': b('\f'); break;
+                case 'x': {
+                    int v = 0;
+                    while (k + 1 < texto.size() && isxdigit(static_cast<unsigned char>(texto[k + 1]))) {
+                        char h = texto[++k];
+                        v = v * 16 + (isdigit(static_cast<unsigned char>(h)) ? h - '0' : (tolower(h) - 'a' + 10));
+                    }
+                    b(static_cast<uint8_t>(v));
+                    break;
+                }
+                default:
+                    if (e >= '0' && e <= '7') {
+                        int v = e - '0';
+                        for (int d = 0; d < 2 && k + 1 < texto.size() && texto[k + 1] >= '0' && texto[k + 1] <= '7'; ++d)
+                            v = v * 8 + (texto[++k] - '0');
+                        b(static_cast<uint8_t>(v));
+                    } else {
+                        b(static_cast<uint8_t>(e)); // \\, \" y cualquier otro: el carácter
+                    }
+            }
+        }
+        b(0);
+    }
+
+    void instr(const Instr& i) {
+        if (i.op == SECCION) {
+            const string& s = codigo.simbolos[i.a.simbolo];
+            sec = s == ".text" ? &m.texto : s == ".data" ? &m.datos : nullptr;
+            return;
+        }
+        if (i.op == DIRECTIVA) return; // Comentarios
+        if (i.op == GLOBL) { m.simbolos[simboloMaquina(i.a.simbolo)].global = true; return; }
+        if (!sec) throw runtime_error("codificador: contenido fuera de .text/.data");
+
+        const Operando& a = i.a;
+        const Operando& d = i.b;
+        switch (i.op) {
+            case ETIQUETA:
+                if (sec != &m.texto) noSoportada(i);
+                etiquetas[clave(a)] = sec->size();
+                if (a.valor < 0) definir(a.simbolo, CodigoMaquina::TEXTO);
+                break;
+            case QUAD:
+                while (sec->size() % 8) b(0);
+                definir(a.simbolo, sec == &m.texto ? CodigoMaquina::TEXTO : CodigoMaquina::DATOS);
+                le(static_cast<uint64_t>(d.valor), 8);
+                break;
+            case ASCIZ:
+                definir(a.simbolo, sec == &m.texto ? CodigoMaquina::TEXTO : CodigoMaquina::DATOS);
+                cadena(codigo.simbolos[d.simbolo]);
+                break;
+            case MOV: mov(i); break;
+            case MOVSX:
+                if (a.tam == 4) modrm(0, d.tam == 8, {0x63}, d, a);
+                else modrm(p66(d.tam), d.tam == 8, {0x0F, static_cast<uint8_t>(a.tam == 1 ? 0xBE : 0xBF)}, d, a);
+                break;
+            case MOVZX:
+                modrm(p66(d.tam), d.tam == 8, {0x0F, static_cast<uint8_t>(a.tam == 1 ? 0xB6 : 0xB7)}, d, a);
+                break;
+            case LEA: modrm(0, true, {0x8D}, d, a); break;
+            case ADD: case SUB: case AND: case OR: case XOR: case CMP: alu(i); break;
+            case TEST:
+                if (a.tipo == Operando::INM) {
+                    int n = d.tam == 1 ? 1 : d.tam == 2 ? 2 : 4;
+                    modrm(p66(d.tam), d.tam == 8, {static_cast<uint8_t>(d.tam == 1 ? 0xF6 : 0xF7)}, 0, false, d, n);
+                    le(static_cast<uint64_t>(a.valor), n);
+                } else {
+                    modrm(p66(a.tam), a.tam == 8, {static_cast<uint8_t>(a.tam == 1 ? 0x84 : 0x85)}, a, d);
+                }
+                break;
+            case SHL:
+            case SHR:
+            case SAR: {
+                int n = i.op == SHL ? 4 : i.op == SHR ? 5 : 7;
+                // Por 1 tiene su propio opcode (el que elige `as`)
+                if (a.valor == 1) {
+                    modrm(p66(d.tam), d.tam == 8, {static_cast<uint8_t>(d.tam == 1 ? 0xD0 : 0xD1)}, n, false, d);
+                } else {
+                    modrm(p66(d.tam), d.tam == 8, {static_cast<uint8_t>(d.tam == 1 ? 0xC0 : 0xC1)}, n, false, d, 1);
+                    le(static_cast<uint64_t>(a.valor), 1);
+                }
+                break;
+            }
+            case IMUL:
+                if (d.tipo == Operando::NADA) { unario(a, 5); break; }
+                if (d.tam == 1 || d.tipo != Operando::REG) noSoportada(i);
+                if (a.tipo == Operando::INM) {
+                    // imul $v, %r: la forma de tres operandos con r como fuente y destino
+                    if (!cabe32(a.valor)) noSoportada(i);
+                    int bytes = cabe8(a.valor) ? 1 : d.tam == 2 ? 2 : 4;
+                    modrm(p66(d.tam), d.tam == 8, {static_cast<uint8_t>(bytes == 1 ? 0x6B : 0x69)}, d, d, bytes);
+                    le(static_cast<uint64_t>(a.valor), bytes);
+                    break;
+                }
+                modrm(p66(d.tam), d.tam == 8, {0x0F, 0xAF}, d, a);
+                break;
+            case NEG: unario(a, 3); break;
+            case MUL: unario(a, 4); break;
+            case DIV: unario(a, 6); break;
+            case IDIV: unario(a, 7); break;
+            case EXTSIGNO:
+                if (a.tam == 1) { b(0x66); b(0x98); }      // cbw
+                else if (a.tam == 2) { b(0x66); b(0x99); } // cwd
+                else if (a.tam == 4) b(0x99);              // cdq
+                else { b(0x48); b(0x99); }                 // cqo
+                break;
+            case PUSH:
+            case POP: {
+                if (a.tipo != Operando::REG) noSoportada(i);
+                int n = numero(a.reg);
+                if (n & 8) b(0x41);
+                b(static_cast<uint8_t>((i.op == PUSH ? 0x50 : 0x58) + (n & 7)));
+                break;
+            }
+            case XCHG: modrm(p66(a.tam), a.tam == 8, {static_cast<uint8_t>(a.tam == 1 ? 0x86 : 0x87)}, a, d); break;
+            case SETCC: modrm(0, false, {0x0F, static_cast<uint8_t>(0x90 + i.cc)}, 0, false, a); break;
+            case JCC: salto({0x0F, static_cast<uint8_t>(0x80 + i.cc)}, a, false); break;
+            case JMP: salto({0xE9}, a, false); break;
+            case CALL: salto({0xE8}, a, true); break;
+            case LEAVE: b(0xC9); break;
+            case RET: b(0xC3); break;
+            case CVTSI2SD: modrm(0xF2, a.tam == 8, {0x0F, 0x2A}, d, a); break;
+            case CVTSI2SS: modrm(0xF3, a.tam == 8, {0x0F, 0x2A}, d, a); break;
+            case CVTTSD2SI: modrm(0xF2, d.tam == 8, {0x0F, 0x2C}, d, a); break;
+            case CVTTSS2SI: modrm(0xF3, d.tam == 8, {0x0F, 0x2C}, d, a); break;
+            case CVTSS2SD: modrm(0xF3, false, {0x0F, 0x5A}, d, a); break;
+            case CVTSD2SS: modrm(0xF2, false, {0x0F, 0x5A}, d, a); break;
+            case ADDSD: modrm(0xF2, false, {0x0F, 0x58}, d, a); break;
+            case MULSD: modrm(0xF2, false, {0x0F, 0x59}, d, a); break;
+            case SUBSD: modrm(0xF2, false, {0x0F, 0x5C}, d, a); break;
+            case DIVSD: modrm(0xF2, false, {0x0F, 0x5E}, d, a); break;
+            case UCOMISD: modrm(0x66, false, {0x0F, 0x2E}, d, a); break;
+            default: noSoportada(i);
+        }
+    }
+
+    // Los saltos siempre llevan rel32: así el tamaño de cada instrucción se
+    // conoce al emitirla y basta una pasada
+    void resolverSaltos() {
+        for (auto& s : saltos) {
+            auto it = etiquetas.find(clave(s.destino));
+            int64_t rel;
+            if (it != etiquetas.end()) {
+                rel = static_cast<int64_t>(it->second) - static_cast<int64_t>(s.pos + 4);
+            } else if (s.llamada && s.destino.valor < 0) {
+                // Función de otra biblioteca (printf): la resuelve el enlazador
+                m.reubicaciones.push_back({s.pos, simboloMaquina(s.destino.simbolo), true, -4});
+                rel = 0;
+            } else {
+                throw runtime_error("codificador: etiqueta no definida: " + nombre(s.destino));
+            }
+            for (int k = 0; k < 4; ++k) m.texto[s.pos + k] = static_cast<uint8_t>(static_cast<uint64_t>(rel) >> (8 * k));
+        }
+    }
+
+public:
+    explicit Codificador(const CodigoX86& codigo) : codigo(codigo) {
+        // Unos 5 bytes por instrucción en promedio
+        m.texto.reserve(codigo.instrs.size() * 5);
+    }
+
+    CodigoMaquina run() {
+        for (auto& i : codigo.instrs) instr(i);
+        resolverSaltos();
+        return std::move(m);
+    }
+};
+
+} // namespace
+
+CodigoMaquina codificar(const CodigoX86& codigo) {
+    return Codificador(codigo).run();
+}
+
+// ===========================================================
+//   Objeto ELF64
+// ===========================================================
+
+namespace {
+
+// Constantes del formato (las de <elf.h>, que no existe fuera de Linux)
+enum : uint32_t {
+    SHT_PROGBITS = 1, SHT_SYMTAB = 2, SHT_STRTAB = 3, SHT_RELA = 4,
+    SHF_WRITE = 1, SHF_ALLOC = 2, SHF_EXECINSTR = 4, SHF_INFO_LINK = 0x40,
+    STB_LOCAL = 0, STB_GLOBAL = 1,
+    STT_NOTYPE = 0, STT_OBJECT = 1, STT_FUNC = 2,
+    R_X86_64_PC32 = 2, R_X86_64_PLT32 = 4,
+};
+
+// Índices de sección en el orden en que se escriben
+enum : uint16_t { SEC_TEXT = 1, SEC_DATA, SEC_RELA, SEC_SYMTAB, SEC_STRTAB, SEC_SHSTRTAB, SEC_NOTA, NUM_SECCIONES };
+
+struct Bytes {
+    string s;
+    void u8(uint64_t v) { s.push_back(static_cast<char>(v)); }
+    void u16(uint64_t v) { for (int k = 0; k < 2; ++k) u8(v >> (8 * k)); }
+    void u32(uint64_t v) { for (int k = 0; k < 4; ++k) u8(v >> (8 * k)); }
+    void u64(uint64_t v) { for (int k = 0; k < 8; ++k) u8(v >> (8 * k)); }
+    void alinear(size_t n) { while (s.size() % n) u8(0); }
+    void agregar(const vector<uint8_t>& v) { s.append(v.begin(), v.end()); }
+};
+
+struct Encabezado {
+    uint32_t nombre, tipo;
+    uint64_t flags, offset, tam;
+    uint32_t link, info;
+    uint64_t alineacion, tamEntrada;
+};
+
+} // namespace
+
+string escribirObjetoElf(const CodigoMaquina& m) {
+    // Tabla de símbolos: los locales antes que los globales
+    vector<int> orden;
+    for (int pasada = 0; pasada < 2; ++pasada)
+        for (size_t i = 0; i < m.simbolos.size(); ++i) {
+            const auto& s = m.simbolos[i];
+            bool global = s.global || s.seccion == CodigoMaquina::EXTERNO;
+            if (global == (pasada == 1)) orden.push_back(static_cast<int>(i));
+        }
+    vector<uint32_t> indiceElf(m.simbolos.size());
+    uint32_t primerGlobal = 1;
+    Bytes strtab, symtab;
+    strtab.u8(0);
+    symtab.s.append(24, '\0'); // Símbolo nulo
+    for (size_t k = 0; k < orden.size(); ++k) {
+        const auto& s = m.simbolos[orden[k]];
+        bool global = s.global || s.seccion == CodigoMaquina::EXTERNO;
+        indiceElf[orden[k]] = static_cast<uint32_t>(k + 1);
+        if (!global) primerGlobal = static_cast<uint32_t>(k + 2);
+        symtab.u32(strtab.s.size());
+        strtab.s += s.nombre;
+        strtab.u8(0);
+        uint32_t tipo = s.seccion == CodigoMaquina::TEXTO ? STT_FUNC
+                      : s.seccion == CodigoMaquina::DATOS ? STT_OBJECT : STT_NOTYPE;
+        if (s.seccion == CodigoMaquina::TEXTO && !s.global) tipo = STT_NOTYPE; // Etiquetas internas
+        symtab.u8(((global ? STB_GLOBAL : STB_LOCAL) << 4) | tipo);
+        symtab.u8(0);
+        symtab.u16(s.seccion == CodigoMaquina::TEXTO ? SEC_TEXT : s.seccion == CodigoMaquina::DATOS ? SEC_DATA : 0);
+        symtab.u64(s.offset);
+        symtab.u64(0);
+    }
+
+    Bytes rela;
+    for (auto& r : m.reubicaciones) {
+        rela.u64(r.offset);
+        rela.u64((static_cast<uint64_t>(indiceElf[r.simbolo]) << 32) | (r.llamada ? R_X86_64_PLT32 : R_X86_64_PC32));
+        rela.u64(static_cast<uint64_t>(r.sumando));
+    }
+
+    const char* nombres[NUM_SECCIONES] = {"", ".text", ".data", ".rela.text", ".symtab", ".strtab", ".shstrtab", ".note.GNU-stack"};
+    Bytes shstrtab;
+    uint32_t nombreSec[NUM_SECCIONES];
+    for (int k = 0; k < NUM_SECCIONES; ++k) {
+        nombreSec[k] = static_cast<uint32_t>(shstrtab.s.size());
+        shstrtab.s += nombres[k];
+        shstrtab.u8(0);
+    }
+
+    // Contenido de las secciones a continuación del encabezado de 64 bytes
+    Bytes elf;
+    elf.s.reserve(64 + m.texto.size() + m.datos.size() + rela.s.size() + symtab.s.size() + strtab.s.size() + 1024);
+    elf.s.append(64, '\0');
+    Encabezado sh[NUM_SECCIONES] = {};
+    auto poner = [&](int k, uint32_t tipo, uint64_t flags, size_t alineacion, const string& datos) {
+        elf.alinear(alineacion);
+        sh[k] = {nombreSec[k], tipo, flags, elf.s.size(), datos.size(), 0, 0, alineacion, 0};
+        elf.s += datos;
+    };
+    poner(SEC_TEXT, SHT_PROGBITS, SHF_ALLOC | SHF_EXECINSTR, 16, string(m.texto.begin(), m.texto.end()));
+    poner(SEC_DATA, SHT_PROGBITS, SHF_WRITE | SHF_ALLOC, 8, string(m.datos.begin(), m.datos.end()));
+    poner(SEC_RELA, SHT_RELA, SHF_INFO_LINK, 8, rela.s);
+    sh[SEC_RELA].link = SEC_SYMTAB;
+    sh[SEC_RELA].info = SEC_TEXT;
+    sh[SEC_RELA].tamEntrada = 24;
+    poner(SEC_SYMTAB, SHT_SYMTAB, 0, 8, symtab.s);
+    sh[SEC_SYMTAB].link = SEC_STRTAB;
+    sh[SEC_SYMTAB].info = primerGlobal;
+    sh[SEC_SYMTAB].tamEntrada = 24;
+    poner(SEC_STRTAB, SHT_STRTAB, 0, 1, strtab.s);
+    poner(SEC_SHSTRTAB, SHT_STRTAB, 0, 1, shstrtab.s);
+    poner(SEC_NOTA, SHT_PROGBITS, 0, 1, string()); // Pila no ejecutable
+
+    elf.alinear(8);
+    uint64_t inicioSecciones = elf.s.size();
+    for (auto& h : sh) {
+        elf.u32(h.nombre);
+        elf.u32(h.tipo);
+        elf.u64(h.flags);
+        elf.u64(0); // Dirección: se asigna al enlazar
+        elf.u64(h.offset);
+        elf.u64(h.tam);
+        elf.u32(h.link);
+        elf.u32(h.info);
+        elf.u64(h.alineacion);
+        elf.u64(h.tamEntrada);
+    }
+
+    // Encabezado ELF: 64 bits, little endian, reubicable, x86-64
+    Bytes e;
+    e.s = "\x7f" "ELF";
+    e.u8(2);
+    e.u8(1);
+    e.u8(1);
+    e.s.append(9, '\0');
+    e.u16(1);  // ET_REL
+    e.u16(62); // EM_X86_64
+    e.u32(1);
+    e.u64(0);  // Sin punto de entrada
+    e.u64(0);  // Sin encabezados de programa
+    e.u64(inicioSecciones);
+    e.u32(0);
+    e.u16(64);
+    e.u16(0);
+    e.u16(0);
+    e.u16(64);
+    e.u16(NUM_SECCIONES);
+    e.u16(SEC_SHSTRTAB);
+    elf.s.replace(0, 64, e.s);
+    return std::move(elf.s);
+}
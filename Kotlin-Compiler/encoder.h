@@ -0,0 +1,52 @@
+#ifndef ENCODER_H
+#define ENCODER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "x86.h"
+
+using namespace std;
+
+// ===========================================================
+//  Código máquina x86-64 y objetos ELF
+// ===========================================================
+//
+// Codifica la lista de instrucciones del codegen directamente en bytes, sin
+// pasar por el texto ni por `as`. Los saltos y las llamadas a funciones del
+// propio programa se resuelven aquí; lo que depende de dónde termine cada
+// sección (accesos RIP a .data, llamadas a printf) queda como reubicación.
+// escribirObjetoElf lo empaqueta en un .o reubicable que gcc enlaza igual
+// que el que saldría de ensamblar el .s.
+
+struct CodigoMaquina {
+    enum Seccion : uint8_t { TEXTO, DATOS, EXTERNO };
+
+    struct Simbolo {
+        string nombre;
+        Seccion seccion = EXTERNO; // EXTERNO: no definido en el programa
+        uint64_t offset = 0;       // Dentro de su sección
+        bool global = false;       // .globl
+    };
+
+    struct Reubicacion {
+        uint64_t offset;  // Posición de los 4 bytes dentro de .text
+        int simbolo;      // Índice en `simbolos`
+        bool llamada;     // R_X86_64_PLT32; si no, R_X86_64_PC32
+        int64_t sumando;  // destino = simbolo + sumando - posición
+    };
+
+    vector<uint8_t> texto;
+    vector<uint8_t> datos;
+    vector<Simbolo> simbolos;
+    vector<Reubicacion> reubicaciones;
+};
+
+// Lanza runtime_error ante una instrucción o forma de operandos que no sabe
+// codificar, o un salto a una etiqueta que no existe
+CodigoMaquina codificar(const CodigoX86& codigo);
+
+// Objeto ELF64 reubicable (.text, .data, .rela.text, tabla de símbolos)
+string escribirObjetoElf(const CodigoMaquina& maquina);
+
+#endif // ENCODER_H
@@ -1,99 +1,176 @@
 #ifndef ENVIRONMENT_H
 #define ENVIRONMENT_H
 
-#include <unordered_map>
+#include <stdexcept>
+#include <functional>
 #include <vector>
 #include <string>
 #include <iostream>
 
 using namespace std;
 
-// AUN NO IMPLEMENTADO
+// ===========================================================
+//  Tabla de símbolos con alcances (plana)
+// ===========================================================
+//
+// Cada nombre se interna una sola vez en una tabla hash de direccionamiento
+// abierto y recibe un slot fijo. `head[slot]` apunta a su ligadura vigente;
+// las ligaduras viven en un único vector en orden de declaración y cada una
+// recuerda a la que oculta (`prev`). Ese vector es también el registro de
+// deshacer: cerrar un alcance es recortarlo hasta la marca del nivel,
+// restaurando `head` de cada ligadura quitada.
+//
+// Buscar cuesta un hash + O(1) sin importar la profundidad, y abrir o
+// cerrar un alcance no reserva memoria una vez que los vectores crecieron.
 template <typename T>
 class Environment {
 private:
-    vector<unordered_map<string, T>> ribs;
+    struct Binding {
+        T value;
+        int slot;   // Símbolo al que pertenece
+        int level;  // Nivel donde se declaró
+        int prev;   // Ligadura que oculta (-1 si ninguna)
+    };
 
-    int search_rib(const string& var) const {
-        for (int idx = static_cast<int>(ribs.size()) - 1; idx >= 0; --idx) {
-            auto it = ribs[idx].find(var);
-            if (it != ribs[idx].end())  // encontrado
-                return idx;
+    vector<string> names;      // slot -> nombre
+    vector<size_t> hashes;     // slot -> hash (para rehash sin recalcular)
+    vector<int> head;          // slot -> ligadura vigente (-1 si no hay)
+    vector<int> table;         // direccionamiento abierto: posición -> slot (-1 vacío)
+    vector<Binding> bindings;  // ligaduras vivas, en orden de declaración
+    vector<int> marks;         // tamaño de `bindings` al abrir cada nivel
+
+    int find_slot(const string& var, size_t h) const {
+        if (table.empty()) return -1;
+        size_t mask = table.size() - 1;
+        for (size_t i = h & mask;; i = (i + 1) & mask) {
+            int s = table[i];
+            if (s < 0) return -1;
+            if (hashes[s] == h && names[s] == var) return s;
+        }
+    }
+
+    void grow() {
+        size_t cap = table.empty() ? 64 : table.size() * 2;
+        table.assign(cap, -1);
+        size_t mask = cap - 1;
+        for (int s = 0; s < static_cast<int>(names.size()); ++s) {
+            size_t i = hashes[s] & mask;
+            while (table[i] >= 0) i = (i + 1) & mask;
+            table[i] = s;
         }
-        return -1; // no encontrado
+    }
+
+    // Slot del nombre, creándolo si no existe
+    int intern(const string& var) {
+        size_t h = hash<string>()(var);
+        int s = find_slot(var, h);
+        if (s >= 0) return s;
+        if ((names.size() + 1) * 2 > table.size()) grow(); // factor de carga <= 1/2
+        s = static_cast<int>(names.size());
+        names.push_back(var);
+        hashes.push_back(h);
+        head.push_back(-1);
+        size_t mask = table.size() - 1;
+        size_t i = h & mask;
+        while (table[i] >= 0) i = (i + 1) & mask;
+        table[i] = s;
+        return s;
+    }
+
+    // Ligadura vigente del nombre (-1 si no está en ningún nivel)
+    int search(const string& var) const {
+        int s = find_slot(var, hash<string>()(var));
+        return s < 0 ? -1 : head[s];
     }
 
 public:
     Environment() = default;
 
-    // Limpia completamente el entorno
+    // Limpia completamente el entorno (los nombres internados se conservan)
     void clear() {
-        ribs.clear();
+        bindings.clear();
+        marks.clear();
+        for (auto& h : head) h = -1;
     }
 
     // Agrega un nuevo nivel (scope)
     void add_level() {
-        ribs.emplace_back();
+        marks.push_back(static_cast<int>(bindings.size()));
     }
 
     // Agrega una variable con un valor inicial
     void add_var(const string& var, const T& value) {
-        if (ribs.empty()) {
-            cerr << "[Error] Environment sin niveles: no se pueden agregar variables.\n";
-            exit(EXIT_FAILURE);
+        if (marks.empty())
+            throw logic_error("Environment sin niveles: no se pueden agregar variables.");
+        int s = intern(var);
+        int level = static_cast<int>(marks.size()) - 1;
+        int top = head[s];
+        if (top >= 0 && bindings[top].level == level) {
+            bindings[top].value = value; // Redeclaración en el mismo nivel
+            return;
         }
-        ribs.back()[var] = value;
+        bindings.push_back({value, s, level, top});
+        head[s] = static_cast<int>(bindings.size()) - 1;
     }
 
     // Agrega una variable con valor por defecto (solo si T es numérico o tiene constructor por defecto)
     void add_var(const string& var) {
-        if (ribs.empty()) {
-            cerr << "[Error] Environment sin niveles: no se pueden agregar variables.\n";
-            exit(EXIT_FAILURE);
-        }
-        ribs.back()[var] = T(); // inicializa con valor por defecto
+        add_var(var, T());
     }
 
     // Elimina el nivel más interno
     bool remove_level() {
-        if (!ribs.empty()) {
-            ribs.pop_back();
-            return true;
+        if (marks.empty()) return false;
+        int mark = marks.back();
+        marks.pop_back();
+        while (static_cast<int>(bindings.size()) > mark) {
+            const Binding& b = bindings.back();
+            head[b.slot] = b.prev;
+            bindings.pop_back();
         }
-        return false;
+        return true;
     }
 
     // Actualiza el valor de una variable existente
     bool update(const string& x, const T& v) {
-        int idx = search_rib(x);
+        int idx = search(x);
         if (idx < 0) return false;
-        ribs[idx][x] = v;
+        bindings[idx].value = v;
         return true;
     }
 
     // Verifica si una variable existe
     bool check(const string& x) const {
-        return (search_rib(x) >= 0);
+        return search(x) >= 0;
     }
 
     // Busca y devuelve el valor de una variable
     // Si no existe, devuelve un valor por defecto de T
     T lookup(const string& x) const {
-        int idx = search_rib(x);
+        int idx = search(x);
         if (idx < 0) {
             cerr << "[Advertencia] Variable no encontrada: " << x << endl;
             return T(); // valor por defecto
         }
-        return ribs[idx].at(x);
+        return bindings[idx].value;
     }
 
     // Busca y devuelve el valor en una referencia. Devuelve true si existe.
     bool lookup(const string& x, T& v) const {
-        int idx = search_rib(x);
+        int idx = search(x);
         if (idx < 0) return false;
-        v = ribs[idx].at(x);
+        v = bindings[idx].value;
         return true;
     }
+
+    // Acceso por slot: quien resuelve el nombre una vez puede guardar el
+    // slot y consultar sin volver a calcular el hash.
+    int slot(const string& x) { return intern(x); }
+    bool check_slot(int s) const { return head[s] >= 0; }
+    T& lookup_slot(int s) { return bindings[head[s]].value; }
+
+    // Nivel actual (0 = el más externo, -1 sin niveles)
+    int depth() const { return static_cast<int>(marks.size()) - 1; }
 };
 
 #endif // ENVIRONMENT_H
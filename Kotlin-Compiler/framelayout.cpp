@@ -0,0 +1,61 @@
+#include "framelayout.h"
+#include "semantic_types.h"
+#include <algorithm>
+
+using namespace std;
+
+void FrameLayout::reservar(Symbol* s) {
+    if (s->reg >= 0) return; // Vive en un registro (RegisterAllocator)
+    int tam = getTypeSize(s->tipo);
+    tope = (tope + tam - 1) / tam * tam + tam; // Alinear y ocupar
+    maximo = max(maximo, tope);
+    s->offset = -tope;
+}
+
+void FrameLayout::reservar(vector<Symbol*> simbolos) {
+    // De mayor a menor no quedan huecos de alineación entre ellos
+    stable_sort(simbolos.begin(), simbolos.end(), [](Symbol* a, Symbol* b) {
+        return getTypeSize(a->tipo) > getTypeSize(b->tipo);
+    });
+    for (auto s : simbolos) reservar(s);
+}
+
+void FrameLayout::run(Program* p) {
+    for (auto f : p->fdlist)
+        visit(f);
+}
+
+void FrameLayout::visit(FunDec* f) {
+    tope = 8 * static_cast<int>(f->salvados.size()); // Copia de los callee-saved
+    maximo = tope;
+    reservar(f->params);
+    dispatch(f->cuerpo);
+    f->tamMarco = (maximo + 15) / 16 * 16;
+}
+
+void FrameLayout::visit(Block* b) {
+    int guardado = tope;
+    vector<Symbol*> locales;
+    for (auto s : b->stmts)
+        if (s->kind == NODE_VARDEC) locales.push_back(static_cast<VarDec*>(s)->sym);
+    reservar(locales);
+    for (auto s : b->stmts)
+        dispatch(s);
+    tope = guardado;
+}
+
+void FrameLayout::visit(IfStmt* s) {
+    dispatch(s->thenBlock);
+    if (s->elseBlock) dispatch(s->elseBlock);
+}
+
+void FrameLayout::visit(WhileStmt* s) {
+    dispatch(s->block);
+}
+
+void FrameLayout::visit(ForStmt* s) {
+    int guardado = tope;
+    reservar({s->varSym, s->endSym, s->stepSym});
+    dispatch(s->block);
+    tope = guardado;
+}
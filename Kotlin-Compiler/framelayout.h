@@ -0,0 +1,54 @@
+#ifndef FRAMELAYOUT_H
+#define FRAMELAYOUT_H
+
+#include <vector>
+#include "ast.h"
+#include "static_visitor.h"
+
+using namespace std;
+
+// ===========================================================
+//  Disposición del marco de cada función
+// ===========================================================
+//
+// Corre después de los pases y antes del codegen, cuando ya se conocen los
+// tipos. Cada local (parámetro, variable, contador, límite y paso de un
+// `for`) recibe un desplazamiento de su tamaño real (1, 2, 4 u 8 bytes)
+// alineado a ese tamaño. Al cerrar un bloque sus bytes quedan libres, así
+// que dos bloques hermanos comparten el mismo espacio. Las variables con
+// registro no ocupan marco; los callee-saved que usa la función se guardan
+// en lo más alto. FunDec::tamMarco es el máximo ocupado a la vez,
+// redondeado a 16.
+class FrameLayout final : public StaticVisitor<FrameLayout, void> {
+private:
+    int tope = 0;   // Bytes ocupados bajo %rbp en el punto actual
+    int maximo = 0; // Máximo de `tope` en la función
+
+    void reservar(Symbol* s);
+    void reservar(vector<Symbol*> simbolos); // De mayor a menor tamaño
+
+public:
+    void run(Program* p);
+
+    void visit(FunDec* f);
+    void visit(Block* b);
+    void visit(IfStmt* s);
+    void visit(WhileStmt* s);
+    void visit(ForStmt* s);
+
+    // Nada que reservar: las declaraciones se toman al entrar a su bloque
+    void visit(VarDec*) {}
+    void visit(PrintStm*) {}
+    void visit(ReturnStm*) {}
+    void visit(BinaryExp*) {}
+    void visit(NumberExp*) {}
+    void visit(DoubleExp*) {}
+    void visit(LongExp*) {}
+    void visit(BoolExp*) {}
+    void visit(StringExp*) {}
+    void visit(IdExp*) {}
+    void visit(AssignExp*) {}
+    void visit(FcallExp*) {}
+};
+
+#endif // FRAMELAYOUT_H
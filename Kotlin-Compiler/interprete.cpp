@@ -0,0 +1,369 @@
+#include "bytecode.h"
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+
+using namespace std;
+
+// ===========================================================
+//   Semántica de las instrucciones x86 que imita cada operación
+// ===========================================================
+
+// Escritura de un resultado de `W` bytes en %rax: con 1 y 2 bytes la parte
+// alta queda la de `previo` (el operando izquierdo); con 4 se limpia
+template <int W>
+static inline uint64_t escribir(uint64_t previo, uint64_t v) {
+    if (W == 1) return (previo & ~0xFFull) | (v & 0xFF);
+    if (W == 2) return (previo & ~0xFFFFull) | (v & 0xFFFF);
+    if (W == 4) return static_cast<uint32_t>(v);
+    return v;
+}
+
+// Los `W` bytes bajos como entero con signo
+template <int W>
+static inline int64_t conSigno(uint64_t v) {
+    if (W == 1) return static_cast<int8_t>(v);
+    if (W == 2) return static_cast<int16_t>(v);
+    if (W == 4) return static_cast<int32_t>(v);
+    return static_cast<int64_t>(v);
+}
+
+template <int W>
+static inline uint64_t bajos(uint64_t v) {
+    return W == 8 ? v : v & ((1ull << (8 * W)) - 1);
+}
+
+static inline double comoDouble(uint64_t bits) {
+    double d;
+    memcpy(&d, &bits, sizeof(d));
+    return d;
+}
+
+static inline uint64_t deDouble(double d) {
+    uint64_t bits;
+    memcpy(&bits, &d, sizeof(bits));
+    return bits;
+}
+
+static inline float comoFloat(uint64_t bits) {
+    uint32_t b32 = static_cast<uint32_t>(bits);
+    float f;
+    memcpy(&f, &b32, sizeof(f));
+    return f;
+}
+
+// movd %xmm0, %eax: los bits del float, parte alta limpia
+static inline uint64_t deFloat(float f) {
+    uint32_t b32;
+    memcpy(&b32, &f, sizeof(b32));
+    return b32;
+}
+
+// cvttsd2si: NaN o fuera de rango dan el "entero indefinido" (el mínimo)
+static inline uint64_t truncar64(double d) {
+    if (!(d > -9223372036854775809.0 && d < 9223372036854775808.0)) return 0x8000000000000000ull;
+    return static_cast<uint64_t>(static_cast<int64_t>(d));
+}
+
+// ===========================================================
+//   Intérprete
+// ===========================================================
+
+namespace {
+
+struct Marco {
+    const InstrBC* retorno; // Instrucción que sigue al CALL
+    size_t base;            // Base del llamador
+    uint16_t destino;       // Registro del llamador que recibe el resultado
+};
+
+// Tope de registros de todos los marcos juntos (32 MB, como una pila grande)
+static const size_t MAX_REGISTROS = size_t(1) << 22;
+
+} // namespace
+
+ResultadoInterprete interpretar(const ProgramaBytecode& prog, const SalidaInterprete& salida) {
+    ResultadoInterprete res;
+    if (prog.principal < 0) { // Sin main el programa no hace nada
+        res.ok = true;
+        return res;
+    }
+
+    vector<uint64_t> globales = prog.globales;
+    vector<uint64_t> pila(max<size_t>(prog.funciones[prog.principal].registros, 1024), 0);
+    vector<Marco> marcos;
+    size_t base = 0;
+    uint64_t* r = pila.data();
+    const InstrBC* codigo = prog.codigo.data();
+    const InstrBC* pc = codigo + prog.funciones[prog.principal].entrada;
+    const uint64_t* constantes = prog.constantes.data();
+    char buffer[512];
+
+    auto imprimir = [&](const char* formato, auto valor) {
+        int n = snprintf(buffer, sizeof(buffer), formato, valor);
+        if (n < 0) return;
+        if (static_cast<size_t>(n) < sizeof(buffer)) {
+            salida(buffer, static_cast<size_t>(n));
+        } else {
+            string largo(static_cast<size_t>(n) + 1, '\0');
+            snprintf(&largo[0], largo.size(), formato, valor);
+            salida(largo.data(), static_cast<size_t>(n));
+        }
+    };
+
+#if defined(__GNUC__)
+    // Despacho por `goto` calculado: un salto indirecto por instrucción, cada
+    // uno en su propio sitio (mejor predicción que un único switch)
+#define BC_ETIQUETA(n) &&L_##n,
+    static void* const tabla[NUM_OPS_BC] = {BC_OPS(BC_ETIQUETA)};
+#undef BC_ETIQUETA
+#define CASO(n) L_##n:
+#define DESPACHAR() goto *tabla[pc->op]
+#define INICIO DESPACHAR();
+#define FIN
+#else
+#define CASO(n) case BC_##n:
+#define DESPACHAR() continue
+#define INICIO for (;;) switch (pc->op) {
+#define FIN }
+#endif
+#define SIGUIENTE() do { ++pc; DESPACHAR(); } while (0)
+
+#define ARITMETICA(n, W, expr)                                  \
+    CASO(n##_##W) {                                             \
+        uint64_t a = r[pc->b], b = r[pc->c];                    \
+        (void)b;                                                \
+        r[pc->a] = escribir<W>(a, (expr));                      \
+        SIGUIENTE();                                            \
+    }
+#define FAMILIA(n, expr) ARITMETICA(n, 1, expr) ARITMETICA(n, 2, expr) ARITMETICA(n, 4, expr) ARITMETICA(n, 8, expr)
+
+    // Comparación con el ancho y setcc + movzbq: 0 o 1 en todo el registro
+#define COMPARACION(n, W, op)                                                         \
+    CASO(n##_##W) {                                                                   \
+        r[pc->a] = conSigno<W>(r[pc->b]) op conSigno<W>(r[pc->c]) ? 1 : 0;             \
+        SIGUIENTE();                                                                  \
+    }
+#define FAMILIA_CMP(n, op) COMPARACION(n, 1, op) COMPARACION(n, 2, op) COMPARACION(n, 4, op) COMPARACION(n, 8, op)
+
+    // Sin signo (jb/ja...): los `W` bytes bajos tal cual
+#define COMPARACION_SIN_SIGNO(n, W, op)                                               \
+    CASO(n##_##W) {                                                                   \
+        r[pc->a] = bajos<W>(r[pc->b]) op bajos<W>(r[pc->c]) ? 1 : 0;                   \
+        SIGUIENTE();                                                                  \
+    }
+#define FAMILIA_CMP_SIN_SIGNO(n, op) COMPARACION_SIN_SIGNO(n, 1, op) COMPARACION_SIN_SIGNO(n, 2, op) \
+                                     COMPARACION_SIN_SIGNO(n, 4, op) COMPARACION_SIN_SIGNO(n, 8, op)
+
+    INICIO
+
+    CASO(MOV) { r[pc->a] = r[pc->b]; SIGUIENTE(); }
+    CASO(MOVK) { r[pc->a] = constantes[pc->bc()]; SIGUIENTE(); }
+    CASO(MOVS) { r[pc->a] = reinterpret_cast<uint64_t>(prog.cadenas[pc->bc()].c_str()); SIGUIENTE(); }
+    CASO(SX1) { r[pc->a] = aplicarExtension(BC_SX1, r[pc->b]); SIGUIENTE(); }
+    CASO(SX2) { r[pc->a] = aplicarExtension(BC_SX2, r[pc->b]); SIGUIENTE(); }
+    CASO(SX4) { r[pc->a] = aplicarExtension(BC_SX4, r[pc->b]); SIGUIENTE(); }
+    CASO(ZX1) { r[pc->a] = aplicarExtension(BC_ZX1, r[pc->b]); SIGUIENTE(); }
+    CASO(ZX2) { r[pc->a] = aplicarExtension(BC_ZX2, r[pc->b]); SIGUIENTE(); }
+    CASO(ZX4) { r[pc->a] = aplicarExtension(BC_ZX4, r[pc->b]); SIGUIENTE(); }
+    CASO(GLOAD) { r[pc->a] = globales[pc->bc()]; SIGUIENTE(); }
+    CASO(GSTORE) { globales[pc->b] = aplicarExtension(static_cast<OpBC>(pc->c), r[pc->a]); SIGUIENTE(); }
+
+    FAMILIA(ADD, a + b)
+    FAMILIA(SUB, a - b)
+    FAMILIA(AND, a & b)
+    FAMILIA(OR, a | b)
+    // imul no tiene forma de 8 bits: el codegen usa imull y limpia la parte alta
+    CASO(MUL_1) { r[pc->a] = static_cast<uint32_t>(r[pc->b] * r[pc->c]); SIGUIENTE(); }
+    ARITMETICA(MUL, 2, a * b)
+    ARITMETICA(MUL, 4, a * b)
+    ARITMETICA(MUL, 8, a * b)
+
+    FAMILIA_CMP(LT, <)
+    FAMILIA_CMP(LE, <=)
+    FAMILIA_CMP(GT, >)
+    FAMILIA_CMP(GE, >=)
+    FAMILIA_CMP(EQ, ==)
+    FAMILIA_CMP(NE, !=)
+    FAMILIA_CMP_SIN_SIGNO(ULT, <)
+    FAMILIA_CMP_SIN_SIGNO(ULE, <=)
+    FAMILIA_CMP_SIN_SIGNO(UGT, >)
+    FAMILIA_CMP_SIN_SIGNO(UGE, >=)
+
+    CASO(DIV_1) CASO(MOD_1) CASO(DIV_2) CASO(MOD_2) CASO(DIV_4) CASO(MOD_4) CASO(DIV_8) CASO(MOD_8) {
+        OpBC op = pc->op;
+        int w = op == BC_DIV_1 || op == BC_MOD_1 ? 1 : op == BC_DIV_2 || op == BC_MOD_2 ? 2
+              : op == BC_DIV_4 || op == BC_MOD_4 ? 4 : 8;
+        uint64_t izq = r[pc->b];
+        int64_t a, b;
+        switch (w) {
+            case 1: a = conSigno<1>(izq); b = conSigno<1>(r[pc->c]); break;
+            case 2: a = conSigno<2>(izq); b = conSigno<2>(r[pc->c]); break;
+            case 4: a = conSigno<4>(izq); b = conSigno<4>(r[pc->c]); break;
+            default: a = conSigno<8>(izq); b = conSigno<8>(r[pc->c]); break;
+        }
+        if (b == 0 || (a == INT64_MIN && b == -1)) {
+            res.error = "división por cero o desbordamiento en la división";
+            return res;
+        }
+        int64_t q = a / b, m = a % b;
+        int64_t minimo = w == 8 ? INT64_MIN : -(int64_t(1) << (8 * w - 1));
+        int64_t maximo = w == 8 ? INT64_MAX : (int64_t(1) << (8 * w - 1)) - 1;
+        if (q < minimo || q > maximo) {
+            res.error = "división por cero o desbordamiento en la división";
+            return res;
+        }
+        bool esDiv = op == BC_DIV_1 || op == BC_DIV_2 || op == BC_DIV_4 || op == BC_DIV_8;
+        uint64_t v;
+        switch (w) {
+            // idivb: cociente en %al y resto en %ah; el módulo lee %ah con movzbl
+            case 1: v = esDiv ? (izq & ~0xFFFFull) | (static_cast<uint64_t>(m & 0xFF) << 8) | static_cast<uint64_t>(q & 0xFF)
+                              : static_cast<uint64_t>(m & 0xFF); break;
+            // idivw: cociente en %ax; el módulo lee %dx con movzwq
+            case 2: v = esDiv ? escribir<2>(izq, static_cast<uint64_t>(q)) : static_cast<uint64_t>(m & 0xFFFF); break;
+            // idivl: cociente en %eax; el módulo lee %edx con movslq
+            case 4: v = esDiv ? escribir<4>(izq, static_cast<uint64_t>(q)) : static_cast<uint64_t>(static_cast<int64_t>(static_cast<int32_t>(m))); break;
+            default: v = static_cast<uint64_t>(esDiv ? q : m); break;
+        }
+        r[pc->a] = v;
+        SIGUIENTE();
+    }
+
+    CASO(UDIV_1) CASO(UMOD_1) CASO(UDIV_2) CASO(UMOD_2) CASO(UDIV_4) CASO(UMOD_4) CASO(UDIV_8) CASO(UMOD_8) {
+        OpBC op = pc->op;
+        int w = op == BC_UDIV_1 || op == BC_UMOD_1 ? 1 : op == BC_UDIV_2 || op == BC_UMOD_2 ? 2
+              : op == BC_UDIV_4 || op == BC_UMOD_4 ? 4 : 8;
+        uint64_t izq = r[pc->b], a, b;
+        switch (w) {
+            case 1: a = bajos<1>(izq); b = bajos<1>(r[pc->c]); break;
+            case 2: a = bajos<2>(izq); b = bajos<2>(r[pc->c]); break;
+            case 4: a = bajos<4>(izq); b = bajos<4>(r[pc->c]); break;
+            default: a = izq; b = r[pc->c]; break;
+        }
+        if (b == 0) {
+            res.error = "división por cero o desbordamiento en la división";
+            return res;
+        }
+        uint64_t q = a / b, m = a % b;
+        bool esDiv = op == BC_UDIV_1 || op == BC_UDIV_2 || op == BC_UDIV_4 || op == BC_UDIV_8;
+        uint64_t v;
+        switch (w) {
+            // movzbl %al, %eax + divb: cociente en %al y resto en %ah, el resto del registro limpio
+            case 1: v = esDiv ? (m << 8) | q : m; break;
+            // divw: cociente en %ax; el módulo lee %dx con movzwq
+            case 2: v = esDiv ? escribir<2>(izq, q) : m; break;
+            // divl limpia la parte alta; el módulo lee %edx con movl
+            default: v = esDiv ? q : m; break;
+        }
+        r[pc->a] = v;
+        SIGUIENTE();
+    }
+
+    // Por cuadrados, como el bucle del codegen
+    CASO(IPOW) CASO(UPOW) {
+        uint64_t base = r[pc->b], n = r[pc->c], v = 1;
+        if (pc->op == BC_IPOW && static_cast<int64_t>(n) < 0) {
+            // Solo 1 y -1 dan algo distinto de 0
+            int64_t x = static_cast<int64_t>(base);
+            v = x == 1 ? 1 : x == -1 ? ((n & 1) ? ~0ull : 1) : 0;
+        } else {
+            for (; n; n >>= 1) {
+                if (n & 1) v *= base;
+                base *= base;
+            }
+        }
+        r[pc->a] = v;
+        SIGUIENTE();
+    }
+
+    CASO(FADD) { r[pc->a] = deDouble(comoDouble(r[pc->b]) + comoDouble(r[pc->c])); SIGUIENTE(); }
+    CASO(FSUB) { r[pc->a] = deDouble(comoDouble(r[pc->b]) - comoDouble(r[pc->c])); SIGUIENTE(); }
+    CASO(FMUL) { r[pc->a] = deDouble(comoDouble(r[pc->b]) * comoDouble(r[pc->c])); SIGUIENTE(); }
+    CASO(FDIV) { r[pc->a] = deDouble(comoDouble(r[pc->b]) / comoDouble(r[pc->c])); SIGUIENTE(); }
+    CASO(FPOW) { r[pc->a] = deDouble(std::pow(comoDouble(r[pc->b]), comoDouble(r[pc->c]))); SIGUIENTE(); }
+    // Comparaciones IEEE: con NaN todas son falsas salvo !=
+    CASO(FLT) { r[pc->a] = comoDouble(r[pc->b]) < comoDouble(r[pc->c]) ? 1 : 0; SIGUIENTE(); }
+    CASO(FLE) { r[pc->a] = comoDouble(r[pc->b]) <= comoDouble(r[pc->c]) ? 1 : 0; SIGUIENTE(); }
+    CASO(FGT) { r[pc->a] = comoDouble(r[pc->b]) > comoDouble(r[pc->c]) ? 1 : 0; SIGUIENTE(); }
+    CASO(FGE) { r[pc->a] = comoDouble(r[pc->b]) >= comoDouble(r[pc->c]) ? 1 : 0; SIGUIENTE(); }
+    CASO(FEQ) { r[pc->a] = comoDouble(r[pc->b]) == comoDouble(r[pc->c]) ? 1 : 0; SIGUIENTE(); }
+    CASO(FNE) { r[pc->a] = comoDouble(r[pc->b]) != comoDouble(r[pc->c]) ? 1 : 0; SIGUIENTE(); }
+
+    CASO(I2D) { r[pc->a] = deDouble(static_cast<double>(static_cast<int64_t>(r[pc->b]))); SIGUIENTE(); }
+    CASO(I2F) { r[pc->a] = deFloat(static_cast<float>(static_cast<int64_t>(r[pc->b]))); SIGUIENTE(); }
+    CASO(U2D) { r[pc->a] = deDouble(static_cast<double>(r[pc->b])); SIGUIENTE(); }
+    CASO(F2D) { r[pc->a] = deDouble(static_cast<double>(comoFloat(r[pc->b]))); SIGUIENTE(); }
+    CASO(D2F) { r[pc->a] = deFloat(static_cast<float>(comoDouble(r[pc->b]))); SIGUIENTE(); }
+    CASO(D2I8) { r[pc->a] = truncar64(comoDouble(r[pc->b])); SIGUIENTE(); }
+    CASO(F2I8) { r[pc->a] = truncar64(comoFloat(r[pc->b])); SIGUIENTE(); }
+
+    CASO(JMP) { pc = codigo + pc->bc(); DESPACHAR(); }
+    CASO(JF) {
+        if (r[pc->a] == 0) pc = codigo + pc->bc();
+        else ++pc;
+        DESPACHAR();
+    }
+    CASO(JT) {
+        if (r[pc->a] != 0) pc = codigo + pc->bc();
+        else ++pc;
+        DESPACHAR();
+    }
+
+    CASO(CALL) {
+        const FuncionBC& f = prog.funciones[pc->b];
+        size_t nueva = base + pc->a;
+        if (nueva + f.registros > pila.size()) {
+            if (nueva + f.registros > MAX_REGISTROS) {
+                res.error = "desbordamiento de pila";
+                return res;
+            }
+            pila.resize(min(MAX_REGISTROS, max(pila.size() * 2, nueva + f.registros)));
+        }
+        marcos.push_back({pc + 1, base, pc->a});
+        base = nueva;
+        r = pila.data() + base;
+        // Las locales empiezan en 0 (en el binario nativo, lo que hubiera en la pila)
+        memset(r + f.parametros, 0, (f.registros - f.parametros) * sizeof(uint64_t));
+        pc = codigo + f.entrada;
+        DESPACHAR();
+    }
+    CASO(RET) {
+        uint64_t v = r[pc->a];
+        if (marcos.empty()) {
+            res.retorno = v;
+            res.ok = true;
+            return res;
+        }
+        Marco m = marcos.back();
+        marcos.pop_back();
+        base = m.base;
+        r = pila.data() + base;
+        r[m.destino] = v;
+        pc = m.retorno;
+        DESPACHAR();
+    }
+
+    // Los formatos de print_fmt_num, print_fmt_float y print_fmt_str
+    CASO(PRINTI) { imprimir("%ld \n", static_cast<long>(r[pc->a])); SIGUIENTE(); }
+    CASO(PRINTD) { imprimir("%f\n", comoDouble(r[pc->a])); SIGUIENTE(); }
+    CASO(PRINTS) {
+        const char* s = reinterpret_cast<const char*>(r[pc->a]);
+        imprimir("%s\n", s ? s : "(null)");
+        SIGUIENTE();
+    }
+
+    FIN
+
+#undef CASO
+#undef DESPACHAR
+#undef INICIO
+#undef FIN
+#undef SIGUIENTE
+#undef ARITMETICA
+#undef FAMILIA
+#undef COMPARACION
+#undef COMPARACION_SIN_SIGNO
+#undef FAMILIA_CMP
+#undef FAMILIA_CMP_SIN_SIGNO
+    return res;
+}
@@ -0,0 +1,148 @@
+#include "jit.h"
+#include <cmath>
+#include <cstdarg>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <unordered_map>
+
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+// ===========================================================
+//   Runtime
+// ===========================================================
+
+// Destino de la salida del programa que corre en este hilo
+static thread_local const SalidaJit* salidaActual = nullptr;
+
+static int printfJit(const char* formato, ...) {
+    char corto[256];
+    va_list args, copia;
+    va_start(args, formato);
+    va_copy(copia, args);
+    int n = vsnprintf(corto, sizeof(corto), formato, args);
+    va_end(args);
+    if (n >= 0 && static_cast<size_t>(n) < sizeof(corto)) {
+        (*salidaActual)(corto, static_cast<size_t>(n));
+    } else if (n >= 0) {
+        string largo(static_cast<size_t>(n) + 1, '\0');
+        vsnprintf(&largo[0], largo.size(), formato, copia);
+        (*salidaActual)(largo.data(), static_cast<size_t>(n));
+    }
+    va_end(copia);
+    return n;
+}
+
+// Símbolos externos que el código generado puede llamar
+static void* simboloRuntime(const string& nombre) {
+    if (nombre == "printf") return reinterpret_cast<void*>(&printfJit);
+    if (nombre == "pow") return reinterpret_cast<void*>(static_cast<double (*)(double, double)>(&::pow));
+    return nullptr;
+}
+
+// ===========================================================
+//   Carga y ejecución
+// ===========================================================
+
+#ifdef _WIN32
+
+ResultadoJit ejecutarJit(const CodigoMaquina&, const SalidaJit&) {
+    ResultadoJit r;
+    r.error = "--jit no está disponible en esta plataforma";
+    return r;
+}
+
+#else
+
+// Un `jmp *0(%rip)` seguido de la dirección: la función del runtime puede
+// estar a más de 2 GB del código, fuera del alcance de un call rel32
+static const size_t TAM_STUB = 16;
+
+ResultadoJit ejecutarJit(const CodigoMaquina& m, const SalidaJit& salida) {
+    ResultadoJit r;
+    size_t pagina = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+    auto redondear = [&](size_t n) { return (n + pagina - 1) / pagina * pagina; };
+
+    // Un stub por símbolo externo, a continuación del código
+    unordered_map<int, size_t> stubs;
+    for (auto& reub : m.reubicaciones) {
+        const auto& s = m.simbolos[reub.simbolo];
+        if (s.seccion != CodigoMaquina::EXTERNO || stubs.count(reub.simbolo)) continue;
+        if (!simboloRuntime(s.nombre)) {
+            r.error = "símbolo no resuelto: " + s.nombre;
+            return r;
+        }
+        stubs.emplace(reub.simbolo, m.texto.size() + stubs.size() * TAM_STUB);
+    }
+
+    // Código y stubs en las primeras páginas, datos en las siguientes
+    size_t tamTexto = redondear(m.texto.size() + stubs.size() * TAM_STUB);
+    size_t tamTotal = tamTexto + redondear(m.datos.size() + 1);
+    void* region = mmap(nullptr, tamTotal, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (region == MAP_FAILED) {
+        r.error = "mmap falló";
+        return r;
+    }
+    uint8_t* texto = static_cast<uint8_t*>(region);
+    uint8_t* datos = texto + tamTexto;
+    if (!m.texto.empty()) memcpy(texto, m.texto.data(), m.texto.size());
+    if (!m.datos.empty()) memcpy(datos, m.datos.data(), m.datos.size());
+
+    for (auto& st : stubs) {
+        uint8_t* p = texto + st.second;
+        const uint8_t salto[6] = {0xFF, 0x25, 0, 0, 0, 0};
+        memcpy(p, salto, sizeof(salto));
+        void* destino = simboloRuntime(m.simbolos[st.first].nombre);
+        memcpy(p + sizeof(salto), &destino, sizeof(destino));
+    }
+
+    // Todas las reubicaciones son relativas a la posición (rel32)
+    for (auto& reub : m.reubicaciones) {
+        const auto& s = m.simbolos[reub.simbolo];
+        uint8_t* destino = s.seccion == CodigoMaquina::TEXTO ? texto + s.offset
+                         : s.seccion == CodigoMaquina::DATOS ? datos + s.offset
+                         : texto + stubs[reub.simbolo];
+        int64_t valor = reinterpret_cast<int64_t>(destino) + reub.sumando
+                      - reinterpret_cast<int64_t>(texto + reub.offset);
+        int32_t rel = static_cast<int32_t>(valor);
+        memcpy(texto + reub.offset, &rel, sizeof(rel));
+    }
+
+    const CodigoMaquina::Simbolo* principal = nullptr;
+    for (auto& s : m.simbolos)
+        if (s.nombre == "main" && s.seccion == CodigoMaquina::TEXTO) principal = &s;
+    if (!principal) {
+        r.error = "el programa no define main";
+    } else if (mprotect(texto, tamTexto, PROT_READ | PROT_EXEC) != 0) {
+        r.error = "mprotect falló";
+    } else {
+        auto entrada = reinterpret_cast<long (*)()>(texto + principal->offset);
+        const SalidaJit* anterior = salidaActual;
+        salidaActual = &salida;
+        r.retorno = entrada();
+        salidaActual = anterior;
+        r.ok = true;
+    }
+    munmap(region, tamTotal);
+    return r;
+}
+
+#endif
+
+ResultadoJit compilarYEjecutar(const string& fuente, const OpcionesCompilacion& opciones,
+                               const SalidaJit& salida, ResultadoCompilacion& compilacion) {
+    OpcionesCompilacion conMaquina = opciones;
+    conMaquina.maquina = true;
+    compilacion = compilar(fuente, conMaquina);
+    if (!compilacion.ok) {
+        ResultadoJit r;
+        r.error = "el programa no compila";
+        return r;
+    }
+    return ejecutarJit(compilacion.maquina, salida);
+}
@@ -0,0 +1,41 @@
+#ifndef JIT_H
+#define JIT_H
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include "compiler.h"
+#include "encoder.h"
+
+using namespace std;
+
+// ===========================================================
+//  Ejecución en el mismo proceso (--jit)
+// ===========================================================
+//
+// Copia el código máquina a memoria ejecutable (mmap), resuelve las
+// reubicaciones contra el propio proceso y llama a `main`. printf se
+// resuelve a una versión que formatea en memoria y entrega el texto a
+// `SalidaJit`, así la salida se captura sin tocar el stdout del proceso.
+// Ni el ensamblador, ni el enlazador, ni un proceso nuevo por ejecución.
+//
+// El programa corre sin aislamiento: un acceso inválido o un bucle infinito
+// afectan al proceso que lo ejecuta.
+
+using SalidaJit = function<void(const char* texto, size_t n)>;
+
+struct ResultadoJit {
+    bool ok = false;     // Se cargó y `main` terminó
+    long retorno = 0;    // Lo que dejó `main` en %rax
+    string error;        // Por qué no se pudo ejecutar
+};
+
+// Ejecuta `main` de un programa ya codificado
+ResultadoJit ejecutarJit(const CodigoMaquina& maquina, const SalidaJit& salida);
+
+// Compila `fuente` (pidiendo el código máquina) y, si no hubo errores, lo
+// ejecuta. `compilacion` queda como la devolvería `compilar`.
+ResultadoJit compilarYEjecutar(const string& fuente, const OpcionesCompilacion& opciones,
+                               const SalidaJit& salida, ResultadoCompilacion& compilacion);
+
+#endif // JIT_H
@@ -0,0 +1,388 @@
+#include "passes.h"
+#include "semantic_types.h"
+#include <algorithm>
+
+using namespace std;
+
+// ===========================================================
+//   Código invariante fuera de los bucles y variables de inducción
+// ===========================================================
+//
+// Cada while/for se procesa después de los bucles que contiene. Una
+// subexpresión es invariante si solo lee variables que el bucle no asigna
+// (ni globales, si el bucle llama a funciones propias) y no puede atrapar:
+// sacada del bucle se evalúa aunque no dé ninguna vuelta. Las invariantes
+// maximales pasan a locales nuevas declaradas justo antes del bucle, que el
+// RegisterAllocator reparte como cualquier otra.
+//
+// En un for, `i * k` con `k` constante o invariante se reemplaza por una
+// local `t` que empieza en `inicio * k` y suma `paso * k` al final de cada
+// vuelta (no hay break ni continue que se la salten). Con el mismo ancho que
+// el contador, `t` y `i * k` coinciden módulo 2^n aunque el contador desborde.
+
+static bool esReal(Type* t) {
+    return t && (t->ttype == Type::FLOAT || t->ttype == Type::DOUBLE);
+}
+
+// Lo que un bucle puede cambiar entre vueltas
+struct Efectos {
+    unordered_set<Symbol*> asignadas; // Asignadas, declaradas dentro o contadores de un for
+    bool llama = false;               // Llama a funciones propias: cualquier global puede cambiar
+};
+
+static void recolectar(Exp* e, Efectos& ef) {
+    forEachExp(e, [&](Exp* x) {
+        if (x->kind == NODE_ASSIGN) ef.asignadas.insert(static_cast<AssignExp*>(x)->sym);
+        else if (x->kind == NODE_FCALL && !static_cast<FcallExp*>(x)->receiver) ef.llama = true;
+    });
+}
+
+static void recolectar(Stm* s, Efectos& ef) {
+    if (!s) return;
+    switch (s->kind) {
+        case NODE_VARDEC: {
+            VarDec* v = static_cast<VarDec*>(s);
+            ef.asignadas.insert(v->sym);
+            recolectar(v->init, ef);
+            break;
+        }
+        case NODE_BLOCK:
+            for (auto st : static_cast<Block*>(s)->stmts) recolectar(st, ef);
+            break;
+        case NODE_IF: {
+            IfStmt* i = static_cast<IfStmt*>(s);
+            recolectar(i->condition, ef);
+            recolectar(i->thenBlock, ef);
+            recolectar(i->elseBlock, ef);
+            break;
+        }
+        case NODE_WHILE: {
+            WhileStmt* w = static_cast<WhileStmt*>(s);
+            recolectar(w->condition, ef);
+            recolectar(w->block, ef);
+            break;
+        }
+        case NODE_FOR: {
+            ForStmt* f = static_cast<ForStmt*>(s);
+            ef.asignadas.insert({f->varSym, f->endSym, f->stepSym});
+            recolectar(f->rangeExp, ef);
+            recolectar(f->block, ef);
+            break;
+        }
+        case NODE_PRINT:  recolectar(static_cast<PrintStm*>(s)->e, ef); break;
+        case NODE_RETURN: recolectar(static_cast<ReturnStm*>(s)->e, ef); break;
+        default:
+            recolectar(static_cast<Exp*>(s), ef); // El resto de nodos son expresiones
+            break;
+    }
+}
+
+static bool invariante(Exp* e, const Efectos& ef) {
+    switch (e->kind) {
+        case NODE_NUMBER: case NODE_DOUBLE: case NODE_LONG: case NODE_BOOL: case NODE_STRING:
+            return true;
+        case NODE_ID: {
+            Symbol* s = static_cast<IdExp*>(e)->sym;
+            return !ef.asignadas.count(s) && !(s->global && ef.llama);
+        }
+        case NODE_BINARY: {
+            if (e->isnumber) return true;
+            BinaryExp* b = static_cast<BinaryExp*>(e);
+            if (b->op == RANGE_OP || b->op == DOWNTO_OP || b->op == STEP_OP) return false;
+            long long k;
+            if ((b->op == DIV_OP || b->op == MOD_OP) && !esReal(b->inferredType) && !operandoReducible(b, k))
+                return false;
+            return invariante(b->left, ef) && invariante(b->right, ef);
+        }
+        case NODE_FCALL: {
+            // Las conversiones (`x.toLong()`) son las únicas sin efectos
+            FcallExp* c = static_cast<FcallExp*>(e);
+            return c->receiver && invariante(c->receiver, ef);
+        }
+        default:
+            return false;
+    }
+}
+
+// ¿Vale una local nueva? Leer una hoja o convertir entre enteros una variable
+// cuesta lo mismo que leer la local
+static bool valeLaPena(Exp* e) {
+    Type* t = e->inferredType;
+    if (e->isnumber || !t || !(t->isNumeric() || t->ttype == Type::BOOL)) return false;
+    if (e->kind == NODE_BINARY) return true;
+    if (e->kind != NODE_FCALL) return false;
+    Exp* r = static_cast<FcallExp*>(e)->receiver;
+    return r->kind != NODE_ID || esReal(t) || esReal(r->inferredType);
+}
+
+// Llama a `f` con cada expresión que evalúa la sentencia `s`, como referencia
+// para poder reemplazarla. Los rangos de un for anidado se visitan por partes
+static void paraCadaRanura(Stm* s, const function<void(Exp*&)>& f) {
+    if (!s) return;
+    switch (s->kind) {
+        case NODE_VARDEC: {
+            VarDec* v = static_cast<VarDec*>(s);
+            if (v->init) f(v->init);
+            break;
+        }
+        case NODE_BLOCK:
+            for (auto& st : static_cast<Block*>(s)->stmts) {
+                if (st->kind > NODE_FCALL) {
+                    paraCadaRanura(st, f);
+                    continue;
+                }
+                Exp* e = static_cast<Exp*>(st); // Expresión usada como sentencia
+                f(e);
+                st = e;
+            }
+            break;
+        case NODE_IF: {
+            IfStmt* i = static_cast<IfStmt*>(s);
+            f(i->condition);
+            paraCadaRanura(i->thenBlock, f);
+            paraCadaRanura(i->elseBlock, f);
+            break;
+        }
+        case NODE_WHILE: {
+            WhileStmt* w = static_cast<WhileStmt*>(s);
+            f(w->condition);
+            paraCadaRanura(w->block, f);
+            break;
+        }
+        case NODE_FOR: {
+            ForStmt* fs = static_cast<ForStmt*>(s);
+            RangoFor r = rangoDe(fs);
+            if (r.rango) {
+                f(r.rango->left);
+                f(r.rango->right);
+            }
+            if (r.paso) f(static_cast<BinaryExp*>(fs->rangeExp)->right);
+            paraCadaRanura(fs->block, f);
+            break;
+        }
+        case NODE_PRINT:  f(static_cast<PrintStm*>(s)->e); break;
+        case NODE_RETURN: {
+            ReturnStm* r = static_cast<ReturnStm*>(s);
+            if (r->e) f(r->e);
+            break;
+        }
+        default: break;
+    }
+}
+
+// Hijos de una expresión, como referencias
+static void paraCadaHijo(Exp* e, const function<void(Exp*&)>& f) {
+    switch (e->kind) {
+        case NODE_BINARY:
+            f(static_cast<BinaryExp*>(e)->left);
+            f(static_cast<BinaryExp*>(e)->right);
+            break;
+        case NODE_FCALL: {
+            FcallExp* c = static_cast<FcallExp*>(e);
+            if (c->receiver) f(c->receiver);
+            for (auto& a : c->argumentos) f(a);
+            break;
+        }
+        case NODE_ASSIGN: f(static_cast<AssignExp*>(e)->e); break;
+        default: break;
+    }
+}
+
+// Las VarDec que este pase creó dentro del bucle, en orden de programa
+static void declaracionesPropias(Stm* s, const unordered_set<Symbol*>& propias,
+                                 vector<pair<Block*, list<Stm*>::iterator>>& salida) {
+    if (!s) return;
+    switch (s->kind) {
+        case NODE_BLOCK: {
+            Block* b = static_cast<Block*>(s);
+            for (auto it = b->stmts.begin(); it != b->stmts.end(); ++it) {
+                if ((*it)->kind == NODE_VARDEC && propias.count(static_cast<VarDec*>(*it)->sym))
+                    salida.push_back({b, it});
+                else
+                    declaracionesPropias(*it, propias, salida);
+            }
+            break;
+        }
+        case NODE_IF:
+            declaracionesPropias(static_cast<IfStmt*>(s)->thenBlock, propias, salida);
+            declaracionesPropias(static_cast<IfStmt*>(s)->elseBlock, propias, salida);
+            break;
+        case NODE_WHILE: declaracionesPropias(static_cast<WhileStmt*>(s)->block, propias, salida); break;
+        case NODE_FOR:   declaracionesPropias(static_cast<ForStmt*>(s)->block, propias, salida); break;
+        default: break;
+    }
+}
+
+VarDec* LoopInvariantPass::declarar(const string& nombre, Exp* init, Type* tipo) {
+    return declaracionOculta(programa, nombre, init, tipo);
+}
+
+void LoopInvariantPass::optimizar(Stm* bucle, vector<VarDec*>& previas) {
+    Efectos ef;
+    recolectar(bucle, ef);
+
+    // Lo que ya se sacó de un bucle interno sale también de este si su valor
+    // no cambia aquí: se mueve la declaración entera, sin copiarla
+    vector<pair<Block*, list<Stm*>::iterator>> propias;
+    declaracionesPropias(bucle->kind == NODE_FOR ? static_cast<ForStmt*>(bucle)->block
+                                                 : static_cast<WhileStmt*>(bucle)->block,
+                         invariantes, propias);
+    for (auto& [b, it] : propias) {
+        VarDec* d = static_cast<VarDec*>(*it);
+        if (!invariante(d->init, ef)) continue;
+        b->stmts.erase(it);
+        previas.push_back(d);
+        ef.asignadas.erase(d->sym);
+    }
+
+    function<void(Exp*&)> sacar = [&](Exp*& e) {
+        if (!invariante(e, ef) || !valeLaPena(e)) {
+            paraCadaHijo(e, sacar);
+            return;
+        }
+        VarDec* d = declarar("inv." + to_string(creados++), e, e->inferredType);
+        invariantes.insert(d->sym);
+        previas.push_back(d);
+        e = lecturaDe(d->sym);
+    };
+    if (bucle->kind == NODE_WHILE) {
+        WhileStmt* w = static_cast<WhileStmt*>(bucle);
+        sacar(w->condition);
+        paraCadaRanura(w->block, sacar);
+    } else {
+        paraCadaRanura(static_cast<ForStmt*>(bucle)->block, sacar);
+        reducir(static_cast<ForStmt*>(bucle), previas);
+    }
+}
+
+void LoopInvariantPass::reducir(ForStmt* s, vector<VarDec*>& previas) {
+    RangoFor r = rangoDe(s);
+    Type* contador = s->varSym->tipo;
+    long long paso = 1;
+    if (!r.rango || (r.paso && !constantBits(r.paso, contador, paso))) return;
+    Efectos cuerpo, ef;
+    recolectar(s->block, cuerpo);
+    if (cuerpo.asignadas.count(s->varSym)) return;
+    recolectar(s, ef);
+
+    // Un `t` por cada tipo y factor distintos
+    struct Induccion {
+        Type* tipo;
+        Symbol* factor; // nullptr: factor constante `k`
+        long long k;
+        Symbol* t;
+    };
+    vector<Induccion> inducciones;
+    // Lo que vale el contador en la primera vuelta: constante o una local nueva
+    long long inicio = 0;
+    bool inicioConstante = constantBits(r.inicio, contador, inicio);
+    Symbol* inicioSym = nullptr;
+
+    auto esContador = [&](Exp* e) { return e->kind == NODE_ID && static_cast<IdExp*>(e)->sym == s->varSym; };
+    function<void(Exp*&)> reemplazar = [&](Exp*& e) {
+        paraCadaHijo(e, reemplazar);
+        if (e->kind != NODE_BINARY || e->isnumber) return;
+        BinaryExp* b = static_cast<BinaryExp*>(e);
+        Type* tipo = b->inferredType;
+        if (b->op != MUL_OP || !tipo || !tipo->isNumeric() || esReal(tipo)) return;
+        if (getTypeSize(tipo) != getTypeSize(contador)) return;
+        Exp* f = esContador(b->left) ? b->right : esContador(b->right) ? b->left : nullptr;
+        if (!f) return;
+        long long k = 0;
+        Symbol* factor = nullptr;
+        if (constantBits(f, tipo, k)) {
+            // Con 0, ±1 o ±2^n el producto ya es un mov, neg o shl
+            unsigned long long m = k < 0 ? -static_cast<unsigned long long>(k) : k;
+            if ((m & (m - 1)) == 0) return;
+        } else if (f->kind == NODE_ID && invariante(f, ef)) {
+            factor = static_cast<IdExp*>(f)->sym;
+        } else {
+            return;
+        }
+
+        auto it = find_if(inducciones.begin(), inducciones.end(), [&](const Induccion& x) {
+            return x.tipo == tipo && x.factor == factor && (factor || x.k == k);
+        });
+        if (it == inducciones.end()) {
+            if (!inicioConstante && !inicioSym) {
+                // El for lo evaluaba después de lo que se saca: nada de eso lo lee
+                VarDec* d = declarar(s->varName + ".inicio", r.inicio, contador);
+                invariantes.insert(d->sym);
+                previas.push_back(d);
+                inicioSym = d->sym;
+                r.rango->left = lecturaDe(inicioSym);
+            }
+            Exp* valorInicial;
+            if (inicioConstante && !factor) {
+                valorInicial = constanteDe(static_cast<long long>(static_cast<unsigned long long>(inicio) * static_cast<unsigned long long>(k)), tipo);
+            } else {
+                Exp* a = inicioSym ? static_cast<Exp*>(lecturaDe(inicioSym)) : constanteDe(inicio, contador);
+                valorInicial = operacionTipada(a, factor ? lecturaDe(factor) : constanteDe(k, tipo), MUL_OP, tipo);
+            }
+            string nombre = s->varName + ".ind" + to_string(creados++);
+            VarDec* t = declarar(nombre, valorInicial, tipo);
+            previas.push_back(t);
+
+            // Lo que suma cada vuelta: paso * k
+            Exp* incremento;
+            unsigned long long producto = static_cast<unsigned long long>(paso) * static_cast<unsigned long long>(k);
+            if (!factor) {
+                incremento = constanteDe(static_cast<long long>(producto), tipo);
+            } else if (paso == 1) {
+                incremento = lecturaDe(factor);
+            } else {
+                VarDec* d = declarar(nombre + ".paso", operacionTipada(lecturaDe(factor), constanteDe(paso, tipo), MUL_OP, tipo), tipo);
+                invariantes.insert(d->sym);
+                previas.push_back(d);
+                incremento = lecturaDe(d->sym);
+            }
+            AssignExp* avance = new AssignExp(nombre, operacionTipada(lecturaDe(t->sym), incremento, r.descendente ? MINUS_OP : PLUS_OP, tipo));
+            avance->sym = t->sym;
+            avance->inferredType = tipo;
+            s->block->stmts.push_back(avance);
+            inducciones.push_back({tipo, factor, k, t->sym});
+            ef.asignadas.insert(t->sym); // Cambia en cada vuelta: no sirve de factor en `t * i`
+            it = inducciones.end() - 1;
+        }
+        Symbol* t = it->t;
+        delete e;
+        e = lecturaDe(t);
+    };
+    paraCadaRanura(s->block, reemplazar);
+}
+
+bool LoopInvariantPass::bloque(Block* b) {
+    bool cambio = false;
+    for (auto it = b->stmts.begin(); it != b->stmts.end(); ++it) {
+        Stm* s = *it;
+        cambio |= sentencia(s);
+        if (s->kind != NODE_WHILE && s->kind != NODE_FOR) continue;
+        vector<VarDec*> previas;
+        optimizar(s, previas);
+        for (VarDec* d : previas) b->stmts.insert(it, d);
+        cambio |= !previas.empty();
+    }
+    return cambio;
+}
+
+bool LoopInvariantPass::sentencia(Stm* s) {
+    switch (s->kind) {
+        case NODE_BLOCK: return bloque(static_cast<Block*>(s));
+        case NODE_IF: {
+            IfStmt* i = static_cast<IfStmt*>(s);
+            bool cambio = bloque(i->thenBlock);
+            if (i->elseBlock) cambio |= bloque(i->elseBlock);
+            return cambio;
+        }
+        case NODE_WHILE: return bloque(static_cast<WhileStmt*>(s)->block);
+        case NODE_FOR:   return bloque(static_cast<ForStmt*>(s)->block);
+        default:         return false;
+    }
+}
+
+bool LoopInvariantPass::run(Program* p, PassManager& pm) {
+    programa = p;
+    bool cambio = false;
+    for (auto fd : p->fdlist) cambio |= bloque(fd->cuerpo);
+    return cambio;
+}
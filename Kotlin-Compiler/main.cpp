@@ -1,26 +1,74 @@
 #include <iostream>
 #include <fstream>
 #include <string>
-#include "scanner.h"
-#include "parser.h"
-#include "ast.h"
-#include "visitor.h"
-#include "TypeChecker.h"
+#include <cctype>
+#include <cstdlib>
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include "compiler.h"
+#include "jit.h"
 
 using namespace std;
 
+static void usage(const char* prog) {
+    cout << "Uso: " << prog << " [-O0|-O1|-O2] [-ftime-passes] [-fpeephole-stats] [-c] [--jit] [--interp] [-jN] [-funroll=N] [-fcache-tipos=archivo] <archivo_de_entrada>" << endl;
+}
+
 int main(int argc, const char* argv[]) {
-    // Verificar número de argumentos
-    if (argc != 2) {
+    // Opciones: nivel de optimización y reporte de tiempos
+    int optLevel = 1;
+    bool timePasses = false;
+    bool estadisticasPeephole = false;
+    bool objeto = false; // -c: escribe también el .o
+    bool jit = false;    // --jit: ejecuta el programa en este proceso
+    bool interp = false; // --interp: lo ejecuta el intérprete de bytecode
+    int hilos = 0; // 0: según los núcleos disponibles
+    int desenrollado = 4; // -funroll=N
+    string rutaCache; // Caché de tipos entre ejecuciones (vacío: sin caché)
+    const char* inputPath = nullptr;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "-O0" || arg == "-O1" || arg == "-O2") {
+            optLevel = arg[2] - '0';
+        } else if (arg == "-ftime-passes") {
+            timePasses = true;
+        } else if (arg == "-fpeephole-stats") {
+            estadisticasPeephole = true;
+        } else if (arg == "-c") {
+            objeto = true;
+        } else if (arg == "--jit") {
+            jit = true;
+        } else if (arg == "--interp") {
+            interp = true;
+        } else if (arg.size() > 2 && arg.compare(0, 2, "-j") == 0 && isdigit((unsigned char)arg[2])) {
+            hilos = max(1, atoi(arg.c_str() + 2));
+        } else if (arg.compare(0, 9, "-funroll=") == 0 && arg.size() > 9 && isdigit((unsigned char)arg[9])) {
+            desenrollado = max(1, atoi(arg.c_str() + 9));
+        } else if (arg.compare(0, 14, "-fcache-tipos=") == 0 && arg.size() > 14) {
+            rutaCache = arg.substr(14);
+        } else if (arg[0] == '-') {
+            cout << "Opción desconocida: " << arg << endl;
+            usage(argv[0]);
+            return 1;
+        } else if (!inputPath) {
+            inputPath = argv[i];
+        } else {
+            cout << "Número incorrecto de argumentos.\n";
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (!inputPath) {
         cout << "Número incorrecto de argumentos.\n";
-        cout << "Uso: " << argv[0] << " <archivo_de_entrada>" << endl;
+        usage(argv[0]);
         return 1;
     }
 
     // Abrir archivo de entrada
-    ifstream infile(argv[1]);
+    ifstream infile(inputPath);
     if (!infile.is_open()) {
-        cout << "No se pudo abrir el archivo: " << argv[1] << endl;
+        cout << "No se pudo abrir el archivo: " << inputPath << endl;
         return 1;
     }
 
@@ -31,43 +79,90 @@ int main(int argc, const char* argv[]) {
     }
     infile.close();
 
-    // Crear instancias de Scanner 
-    Scanner scanner1(input.c_str());
-    //ejecutar_scanner(&scanner1, argv[1]);
-    cout << "Scanner exitoso" << endl;
+    OpcionesCompilacion opciones;
+    opciones.optLevel = optLevel;
+    opciones.timePasses = timePasses;
+    opciones.estadisticasPeephole = estadisticasPeephole;
+    opciones.objeto = objeto;
+    opciones.maquina = jit;
+    opciones.bytecode = interp;
+    opciones.hilos = hilos;
+    opciones.desenrollado = desenrollado;
 
-    // Crear instancias de Parser
-    Parser parser(&scanner1);
-    cout << "Creacion parser exitoso" << endl;
-    // Parsear y generar AST
-    Program* program = parser.parseProgram();     
-        cout << "PASS" << endl;
-        string inputFile(argv[1]);
-        cout << "PASS" << endl;
-        size_t dotPos = inputFile.find_last_of('.');
-        cout << "PASS" << endl;
-        string baseName = (dotPos == string::npos) ? inputFile : inputFile.substr(0, dotPos);
-        cout << "PASS" << endl;
-        string outputFilename = baseName + ".s";
-        cout << "PASS" << endl;
-        ofstream outfile(outputFilename);
-        cout << "PASS" << endl;
-        if (!outfile.is_open()) {
-            cerr << "Error al crear el archivo de salida: " << outputFilename << endl;
-            return 1;
-        }
-    cout << "Parseo exitoso" << endl;
+    // Un archivo ausente o inválido equivale a una caché vacía
+    CacheTipos cache;
+    if (!rutaCache.empty()) {
+        ifstream entrada(rutaCache);
+        if (entrada.is_open()) cache.cargar(entrada);
+        opciones.cacheTipos = &cache;
+    }
+
+    ResultadoCompilacion resultado = compilar(input, opciones);
+
+    if (!rutaCache.empty()) {
+        // Se escribe aparte y se renombra: otra ejecución nunca lee un archivo a medias
+        string temporal = rutaCache + ".tmp" + to_string(random_device()());
+        ofstream salida(temporal);
+        cache.guardar(salida);
+        salida.close();
+        if (!salida || rename(temporal.c_str(), rutaCache.c_str()) != 0) remove(temporal.c_str());
+    }
 
-    // Revisión de tipos y conteo de variables
-    cout << "Iniciando TypeChecker..." << endl;
-    TypeChecker typeChecker;
-    typeChecker.typecheck(program);
-    cout << "TypeChecker finalizado." << endl;
+    if (timePasses) cerr << resultado.reporteTiempos;
+    cerr << resultado.reportePeephole;
+    for (auto& d : resultado.diagnosticos)
+        cerr << d.mensaje << endl;
+    if (!resultado.ok) return 1;
+    // Con --jit o --interp stdout queda solo para la salida del programa
+    bool ejecuta = jit || interp;
+    if (!ejecuta) cout << "Compilacion exitosa" << endl;
 
-    cout << "Generando codigo ensamblador en " << outputFilename << endl;
-    GenCodeVisitor codigo(outfile, typeChecker.functionVarCounts); // Pass variable counts
-    codigo.generar(program);
+    string inputFile(inputPath);
+    size_t dotPos = inputFile.find_last_of('.');
+    string baseName = (dotPos == string::npos) ? inputFile : inputFile.substr(0, dotPos);
+    string outputFilename = baseName + ".s";
+    ofstream outfile(outputFilename);
+    if (!outfile.is_open()) {
+        cerr << "Error al crear el archivo de salida: " << outputFilename << endl;
+        return 1;
+    }
+    if (!ejecuta) cout << "Generando codigo ensamblador en " << outputFilename << endl;
+    // Un solo write con todo el texto, que ya viene armado en un buffer
+    outfile.write(resultado.ensamblador.data(), resultado.ensamblador.size());
     outfile.close();
-    
+
+    if (objeto) {
+        // El mismo programa ya codificado: basta enlazarlo, sin ensamblar el .s
+        string objetoFilename = baseName + ".o";
+        ofstream objfile(objetoFilename, ios::binary);
+        if (!objfile.is_open()) {
+            cerr << "Error al crear el archivo de salida: " << objetoFilename << endl;
+            return 1;
+        }
+        if (!ejecuta) cout << "Generando objeto en " << objetoFilename << endl;
+        objfile.write(resultado.objeto.data(), resultado.objeto.size());
+    }
+
+    if (jit) {
+        cout.flush();
+        ResultadoJit ejecucion = ejecutarJit(resultado.maquina, [](const char* texto, size_t n) {
+            fwrite(texto, 1, n, stdout);
+        });
+        fflush(stdout);
+        if (!ejecucion.ok) {
+            cerr << "Error al ejecutar: " << ejecucion.error << endl;
+            return 1;
+        }
+    } else if (interp) {
+        cout.flush();
+        ResultadoInterprete ejecucion = interpretar(resultado.bytecode, [](const char* texto, size_t n) {
+            fwrite(texto, 1, n, stdout);
+        });
+        fflush(stdout);
+        if (!ejecucion.ok) {
+            cerr << "Error al ejecutar: " << ejecucion.error << endl;
+            return 1;
+        }
+    }
     return 0;
 }
@@ -16,10 +16,16 @@ Parser::Parser(Scanner* sc) : scanner(sc) {
     previous = nullptr;
     current = scanner->nextToken();
     if (current->type == Token::ERR) {
+        delete current; // El destructor no corre si el constructor lanza
         throw runtime_error("Error léxico");
     }
 }
 
+Parser::~Parser() {
+    delete current;
+    delete previous;
+}
+
 bool Parser::match(Token::Type ttype) {
     if (check(ttype)) {
         advance();
@@ -39,6 +45,9 @@ bool Parser::advance() {
         if (previous) delete previous;
         current = scanner->nextToken();
         previous = temp;
+        // Huella de la función en curso: tipo y texto de cada token, sin
+        // importar espacios ni comentarios (ver typecache.h)
+        huella = (huella ^ (hash<string>()(temp->text) + temp->type)) * 1099511628211ULL;
 
         if (check(Token::ERR)) {
             throw runtime_error("Error lexico");
@@ -59,6 +68,8 @@ bool Parser::isAtEnd() {
 
 Program* Parser::parseProgram() {
     Program* p = new Program();
+    // Si hay un error se libera lo ya construido antes de propagarlo
+    try {
     // VarDecList ::= (VarDec)*
     // Se revisa inicio de VarDec: const, val, var
     while (check(Token::CONST) || check(Token::VAL) || check(Token::VAR)) {
@@ -77,8 +88,10 @@ Program* Parser::parseProgram() {
              throw runtime_error("Expected function declaration");
         }
     }
-    
-    cout << "Parser exitoso" << endl;
+    } catch (...) {
+        delete p;
+        throw;
+    }
     return p;
 }
 
@@ -123,6 +136,7 @@ VarDec* Parser::parseVarDec() {
 
 FunDec* Parser::parseFunDec() {
     // FunDec ::= "fun" id "(" ParamListOpt ")" TypeAnnotationOpt Block
+    huella = 14695981039346656037ULL;
     match(Token::FUN);
     
     if (!match(Token::ID)) throw runtime_error("Expected function name");
@@ -186,7 +200,9 @@ FunDec* Parser::parseFunDec() {
     
     Block* body = parseBlock();
     
-    return new FunDec(name, returnType, pTypes, pNames, body);
+    FunDec* f = new FunDec(name, returnType, pTypes, pNames, body);
+    f->huella = huella;
+    return f;
 }
 
 Block* Parser::parseBlock() {
@@ -196,9 +212,14 @@ Block* Parser::parseBlock() {
     
     // StmtListOpt ::= StmtList | ε
     // StmtList ::= (Stmt)*
-    while (!check(Token::RKEY) && !isAtEnd()) {
-        b->stmts.push_back(parseStmt());
-       }
+    try {
+        while (!check(Token::RKEY) && !isAtEnd()) {
+            b->stmts.push_back(parseStmt());
+        }
+    } catch (...) {
+        delete b;
+        throw;
+    }
     match(Token::RKEY);
     return b;
 }
@@ -224,10 +245,17 @@ Stm* Parser::parseStmt() {
         match(Token::LPAREN);
         Exp* cond = parseExp();
         match(Token::RPAREN);
-        Block* thenB = parseBlock();
+        Block* thenB = nullptr;
         Block* elseB = nullptr;
-        if (match(Token::ELSE)) {
-            elseB = parseBlock();
+        try {
+            thenB = parseBlock();
+            if (match(Token::ELSE)) {
+                elseB = parseBlock();
+            }
+        } catch (...) {
+            delete cond;
+            delete thenB;
+            throw;
         }
         s = new IfStmt(cond, thenB, elseB);
     }
@@ -235,7 +263,13 @@ Stm* Parser::parseStmt() {
         match(Token::LPAREN);
         Exp* cond = parseExp();
         match(Token::RPAREN);
-        Block* b = parseBlock();
+        Block* b;
+        try {
+            b = parseBlock();
+        } catch (...) {
+            delete cond;
+            throw;
+        }
         s = new WhileStmt(cond, b);
     }
     else if (match(Token::FOR)) {
@@ -245,7 +279,13 @@ Stm* Parser::parseStmt() {
         if (!match(Token::IN)) throw runtime_error("Expected 'in'");
         Exp* range = parseExp();
         match(Token::RPAREN);
-        Block* b = parseBlock();
+        Block* b;
+        try {
+            b = parseBlock();
+        } catch (...) {
+            delete range;
+            throw;
+        }
         s = new ForStmt(varName, range, b);
     }
     else if (match(Token::RETURN)) {
@@ -282,6 +322,7 @@ Exp* Parser::parseExp() {
         IdExp* idExp = dynamic_cast<IdExp*>(l);
         
         if (!idExp) {
+            delete l;
             throw runtime_error("Invalid assignment target: Left side must be an ID.");
         }
         
@@ -300,9 +341,14 @@ Exp* Parser::parseExp() {
 // LogicOr ::= LogicAnd ("||" LogicAnd)*
 Exp* Parser::parseLogicOr() {
     Exp* l = parseLogicAnd();
-    while (match(Token::DISJ)) {
-        Exp* r = parseLogicAnd();
-        l = new BinaryExp(l, r, OR_OP);
+    try {
+        while (match(Token::DISJ)) {
+            Exp* r = parseLogicAnd();
+            l = new BinaryExp(l, r, OR_OP);
+        }
+    } catch (...) {
+        delete l;
+        throw;
     }
     return l;
 }
@@ -310,9 +356,14 @@ Exp* Parser::parseLogicOr() {
 // LogicAnd ::= Equality ("&&" Equality)*
 Exp* Parser::parseLogicAnd() {
     Exp* l = parseEquality();
-    while (match(Token::CONJ)) {
-        Exp* r = parseEquality();
-        l = new BinaryExp(l, r, AND_OP);
+    try {
+        while (match(Token::CONJ)) {
+            Exp* r = parseEquality();
+            l = new BinaryExp(l, r, AND_OP);
+        }
+    } catch (...) {
+        delete l;
+        throw;
     }
     return l;
 }
@@ -320,11 +371,16 @@ Exp* Parser::parseLogicAnd() {
 // Equality ::= Relational (("=="|"!=") Relational)*
 Exp* Parser::parseEquality() {
     Exp* l = parseRelational();
-    while (check(Token::EQ) || check(Token::NE)) {
-        BinaryOp op = check(Token::EQ) ? EQ_OP : NE_OP;
-        advance();
-        Exp* r = parseRelational();
-        l = new BinaryExp(l, r, op);
+    try {
+        while (check(Token::EQ) || check(Token::NE)) {
+            BinaryOp op = check(Token::EQ) ? EQ_OP : NE_OP;
+            advance();
+            Exp* r = parseRelational();
+            l = new BinaryExp(l, r, op);
+        }
+    } catch (...) {
+        delete l;
+        throw;
     }
     return l;
 }
@@ -332,15 +388,20 @@ Exp* Parser::parseEquality() {
 // Relational ::= Range (("<"|">"|"<="|">=") Range)*
 Exp* Parser::parseRelational() {
     Exp* l = parseRange();
-    while (check(Token::LT) || check(Token::GT) || check(Token::LE) || check(Token::GE)) {
-        BinaryOp op;
-        if (check(Token::LT)) op = LT_OP;
-        else if (check(Token::GT)) op = GT_OP;
-        else if (check(Token::LE)) op = LE_OP;
-        else op = GE_OP;
-        advance();
-        Exp* r = parseRange();
-        l = new BinaryExp(l, r, op);
+    try {
+        while (check(Token::LT) || check(Token::GT) || check(Token::LE) || check(Token::GE)) {
+            BinaryOp op;
+            if (check(Token::LT)) op = LT_OP;
+            else if (check(Token::GT)) op = GT_OP;
+            else if (check(Token::LE)) op = LE_OP;
+            else op = GE_OP;
+            advance();
+            Exp* r = parseRange();
+            l = new BinaryExp(l, r, op);
+        }
+    } catch (...) {
+        delete l;
+        throw;
     }
     return l;
 }
@@ -348,17 +409,22 @@ Exp* Parser::parseRelational() {
 // Range ::= Additive ((".." | "downTo") Additive)*
 Exp* Parser::parseRange() {
     Exp* l = parseAdditive();
-    while (check(Token::RANGE) || check(Token::DOWNTO)) {
-        BinaryOp op = check(Token::RANGE) ? RANGE_OP : DOWNTO_OP;
-        advance();
-        Exp* r = parseAdditive();
-        l = new BinaryExp(l, r, op);
-    }
-    // Check for 'step' after range
-    if (check(Token::STEP)) {
-        advance();
-        Exp* stepVal = parseAdditive();
-        l = new BinaryExp(l, stepVal, STEP_OP);
+    try {
+        while (check(Token::RANGE) || check(Token::DOWNTO)) {
+            BinaryOp op = check(Token::RANGE) ? RANGE_OP : DOWNTO_OP;
+            advance();
+            Exp* r = parseAdditive();
+            l = new BinaryExp(l, r, op);
+        }
+        // Check for 'step' after range
+        if (check(Token::STEP)) {
+            advance();
+            Exp* stepVal = parseAdditive();
+            l = new BinaryExp(l, stepVal, STEP_OP);
+        }
+    } catch (...) {
+        delete l;
+        throw;
     }
     return l;
 }
@@ -366,11 +432,16 @@ Exp* Parser::parseRange() {
 // Additive ::= Multiplicative (("+"|"-") Multiplicative)*
 Exp* Parser::parseAdditive() {
     Exp* l = parseMultiplicative();
-    while (check(Token::PLUS) || check(Token::MINUS)) {
-        BinaryOp op = check(Token::PLUS) ? PLUS_OP : MINUS_OP;
-        advance();
-        Exp* r = parseMultiplicative();
-        l = new BinaryExp(l, r, op);
+    try {
+        while (check(Token::PLUS) || check(Token::MINUS)) {
+            BinaryOp op = check(Token::PLUS) ? PLUS_OP : MINUS_OP;
+            advance();
+            Exp* r = parseMultiplicative();
+            l = new BinaryExp(l, r, op);
+        }
+    } catch (...) {
+        delete l;
+        throw;
     }
     return l;
 }
@@ -378,14 +449,19 @@ Exp* Parser::parseAdditive() {
 // Multiplicative ::= Unary (("*"|"/"|"%") Unary)*
 Exp* Parser::parseMultiplicative() {
     Exp* l = parseUnary();
-    while (check(Token::MUL) || check(Token::DIV) || check(Token::MOD)) {
-        BinaryOp op;
-        if (check(Token::MUL)) op = MUL_OP;
-        else if (check(Token::DIV)) op = DIV_OP;
-        else op = MOD_OP;
-        advance();
-        Exp* r = parseUnary();
-        l = new BinaryExp(l, r, op);
+    try {
+        while (check(Token::MUL) || check(Token::DIV) || check(Token::MOD)) {
+            BinaryOp op;
+            if (check(Token::MUL)) op = MUL_OP;
+            else if (check(Token::DIV)) op = DIV_OP;
+            else op = MOD_OP;
+            advance();
+            Exp* r = parseUnary();
+            l = new BinaryExp(l, r, op);
+        }
+    } catch (...) {
+        delete l;
+        throw;
     }
     return l;
 }
@@ -403,7 +479,21 @@ Exp* Parser::parseUnary() {
         // Generar e == false como una BinaryExp
         return new BinaryExp(e, new BoolExp(false), EQ_OP); 
     }
-    return parsePrimary();
+    return parsePower();
+}
+
+// Power ::= Primary ("**" Unary)?
+// Asocia a la derecha y liga más que el signo: -2 ** 2 es -(2 ** 2), 2 ** -1 es válido
+Exp* Parser::parsePower() {
+    Exp* l = parsePrimary();
+    if (!match(Token::POW)) return l;
+    try {
+        Exp* r = parseUnary();
+        return new BinaryExp(l, r, POW_OP);
+    } catch (...) {
+        delete l;
+        throw;
+    }
 }
 
 // Dentro de parser.cpp
@@ -492,7 +582,10 @@ Exp* Parser::parsePrimary() {
     // 3. Agrupación (paréntesis)
     else if (match(Token::LPAREN)) {
         expr = parseExp();
-        if (!match(Token::RPAREN)) throw runtime_error("Se esperaba ')' después de la expresión agrupada.");
+        if (!match(Token::RPAREN)) {
+            delete expr;
+            throw runtime_error("Se esperaba ')' después de la expresión agrupada.");
+        }
     }
     
     // 4. Identificador (inicio de expresión ID o ID())
@@ -509,51 +602,60 @@ Exp* Parser::parsePrimary() {
     // 6. Postfijos: Llamada de función o método (ej. foo(), 100.toByte())
     // Esta parte es la que ya tenías en tu snippet
     // =========================================================================
-    while (true) {
-        if (check(Token::LPAREN)) {
-            match(Token::LPAREN);
-            vector<Exp*> args;
-            
-            // Si no está seguido de un ')' inmediato, parsea argumentos
-            if (!check(Token::RPAREN)) {
-                do {
-                    args.push_back(parseExp());
-                } while (match(Token::COMA));
-            }
-            
-            if (!match(Token::RPAREN)) throw runtime_error("Se esperaba ')' después de los argumentos de la función");
-
-            // Esto asume que el identificador (IdExp) se parseó justo antes
-            IdExp* id = dynamic_cast<IdExp*>(expr);
-            if (!id) throw runtime_error("Solo se pueden llamar identificadores directamente.");
-            
-            // El expr actual (IdExp) se convierte en la llamada a función (FcallExp)
-            expr = new FcallExp(id->value, args);
-        }
-        else if (match(Token::DOT)) {
-            // Manejo de métodos (ej. 10.toLong())
-            if (!match(Token::ID)) throw runtime_error("Se esperaba un identificador de método después de '.'");
-            string methodName = previous->text;
-
-            vector<Exp*> args;
-            // Los métodos pueden tener paréntesis para argumentos (o no si no tienen args)
-            if (match(Token::LPAREN)) {
+    // Argumentos ya parseados de la llamada en curso: si algo falla se
+    // liberan junto con el receptor
+    vector<Exp*> args;
+    try {
+        while (true) {
+            if (check(Token::LPAREN)) {
+                match(Token::LPAREN);
+                // Si no está seguido de un ')' inmediato, parsea argumentos
                 if (!check(Token::RPAREN)) {
                     do {
                         args.push_back(parseExp());
                     } while (match(Token::COMA));
                 }
-                if (!match(Token::RPAREN)) throw runtime_error("Se esperaba ')' después de los argumentos del método");
+            
+                if (!match(Token::RPAREN)) throw runtime_error("Se esperaba ')' después de los argumentos de la función");
+
+                // Esto asume que el identificador (IdExp) se parseó justo antes
+                IdExp* id = dynamic_cast<IdExp*>(expr);
+                if (!id) throw runtime_error("Solo se pueden llamar identificadores directamente.");
+            
+                // El expr actual (IdExp) se convierte en la llamada a función (FcallExp)
+                expr = new FcallExp(id->value, args);
+                args.clear();
+                delete id;
             }
+            else if (match(Token::DOT)) {
+                // Manejo de métodos (ej. 10.toLong())
+                if (!match(Token::ID)) throw runtime_error("Se esperaba un identificador de método después de '.'");
+                string methodName = previous->text;
+
+                // Los métodos pueden tener paréntesis para argumentos (o no si no tienen args)
+                if (match(Token::LPAREN)) {
+                    if (!check(Token::RPAREN)) {
+                        do {
+                            args.push_back(parseExp());
+                        } while (match(Token::COMA));
+                    }
+                    if (!match(Token::RPAREN)) throw runtime_error("Se esperaba ')' después de los argumentos del método");
+                }
             
-            // El expr actual (que puede ser NumberExp, LongExp, etc.) se convierte en el 'receiver' (receptor)
-            // del método/llamada a función (FcallExp)
-            Exp* receiver = expr; 
-            expr = new FcallExp(methodName, args, receiver);
-        }
-        else {
-            break; // No hay más postfijos
+                // El expr actual (que puede ser NumberExp, LongExp, etc.) se convierte en el 'receiver' (receptor)
+                // del método/llamada a función (FcallExp)
+                Exp* receiver = expr; 
+                expr = new FcallExp(methodName, args, receiver);
+                args.clear();
+            }
+            else {
+                break; // No hay más postfijos
+            }
         }
+    } catch (...) {
+        for (auto a : args) delete a;
+        delete expr;
+        throw;
     }
 
     return expr;
@@ -2,18 +2,21 @@
 #define PARSER_H
 
 #include "scanner.h"    // Incluye la definición del escáner (provee tokens al parser)
+#include <cstdint>
 #include "ast.h"        // Incluye las definiciones para construir el Árbol de Sintaxis Abstracta (AST)
 
 class Parser {
 private:
     Scanner* scanner;       // Puntero al escáner, de donde se leen los tokens
     Token *current, *previous; // Punteros al token actual y al anterior
+    uint64_t huella = 0;       // Hash de los tokens consumidos desde el inicio de la función actual
     bool match(Token::Type ttype);   // Verifica si el token actual coincide con un tipo esperado y avanza si es así
     bool check(Token::Type ttype);   // Comprueba si el token actual es de cierto tipo, sin avanzar
     bool advance();                  // Avanza al siguiente token
     bool isAtEnd();                  // Comprueba si ya se llegó al final de la entrada
 public:
     Parser(Scanner* scanner);       
+    ~Parser();
     Program* parseProgram();
     FunDec* parseFunDec();
     VarDec* parseVarDec();
@@ -30,6 +33,7 @@ public:
     Exp* parseAdditive();   // +, -
     Exp* parseMultiplicative(); // *, /, %
     Exp* parseUnary();      // +, -, !
+    Exp* parsePower();      // ** (asociativo a la derecha)
     Exp* parsePrimary();    // id, num, bool, (), llamada
 };
 
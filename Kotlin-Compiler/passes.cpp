@@ -0,0 +1,333 @@
+#include "passes.h"
+#include "semantic_types.h"
+#include <iostream>
+#include <iomanip>
+#include <algorithm>
+#include <functional>
+#include <cstdint>
+
+using namespace std;
+
+// ===========================================================
+//   Recorridos auxiliares
+// ===========================================================
+
+void forEachExp(Exp* e, const function<void(Exp*)>& f) {
+    if (!e) return;
+    switch (e->kind) {
+        case NODE_BINARY: {
+            BinaryExp* b = static_cast<BinaryExp*>(e);
+            forEachExp(b->left, f);
+            forEachExp(b->right, f);
+            break;
+        }
+        case NODE_FCALL: {
+            FcallExp* c = static_cast<FcallExp*>(e);
+            forEachExp(c->receiver, f);
+            for (auto arg : c->argumentos) forEachExp(arg, f);
+            break;
+        }
+        case NODE_ASSIGN:
+            forEachExp(static_cast<AssignExp*>(e)->e, f);
+            break;
+        default: break;
+    }
+    f(e);
+}
+
+void forEachExp(Stm* s, const function<void(Exp*)>& f) {
+    if (!s) return;
+    switch (s->kind) {
+        case NODE_VARDEC: forEachExp(static_cast<VarDec*>(s)->init, f); break;
+        case NODE_PRINT:  forEachExp(static_cast<PrintStm*>(s)->e, f); break;
+        case NODE_RETURN: forEachExp(static_cast<ReturnStm*>(s)->e, f); break;
+        case NODE_BLOCK:
+            for (auto st : static_cast<Block*>(s)->stmts) forEachExp(st, f);
+            break;
+        case NODE_IF: {
+            IfStmt* i = static_cast<IfStmt*>(s);
+            forEachExp(i->condition, f);
+            forEachExp(i->thenBlock, f);
+            forEachExp(i->elseBlock, f);
+            break;
+        }
+        case NODE_WHILE: {
+            WhileStmt* w = static_cast<WhileStmt*>(s);
+            forEachExp(w->condition, f);
+            forEachExp(w->block, f);
+            break;
+        }
+        case NODE_FOR: {
+            ForStmt* fs = static_cast<ForStmt*>(s);
+            forEachExp(fs->rangeExp, f);
+            forEachExp(fs->block, f);
+            break;
+        }
+        default:
+            forEachExp(static_cast<Exp*>(s), f); // El resto de nodos son expresiones
+            break;
+    }
+}
+
+void forEachExp(Program* p, const function<void(Exp*)>& f) {
+    for (auto v : p->vdlist) forEachExp(v, f);
+    for (auto fd : p->fdlist) forEachExp(fd->cuerpo, f);
+}
+
+IdExp* lecturaDe(Symbol* s) {
+    IdExp* id = new IdExp(s->nombre);
+    id->sym = s;
+    id->inferredType = s->tipo;
+    return id;
+}
+
+BinaryExp* operacionTipada(Exp* l, Exp* r, BinaryOp op, Type* tipo) {
+    BinaryExp* b = new BinaryExp(l, r, op);
+    b->inferredType = tipo;
+    return b;
+}
+
+VarDec* declaracionOculta(Program* p, const string& nombre, Exp* init, Type* tipo) {
+    Symbol* sym = new Symbol(nombre, false);
+    sym->tipo = tipo;
+    p->simbolos.push_back(sym);
+    VarDec* d = new VarDec(nombre, Type::type_names[tipo->ttype], init, false);
+    d->sym = sym;
+    return d;
+}
+
+RangoFor rangoDe(ForStmt* s) {
+    RangoFor r;
+    Exp* rango = s->rangeExp;
+    if (rango->kind == NODE_BINARY && static_cast<BinaryExp*>(rango)->op == STEP_OP) {
+        r.paso = static_cast<BinaryExp*>(rango)->right;
+        rango = static_cast<BinaryExp*>(rango)->left;
+    }
+    if (rango->kind != NODE_BINARY) return r;
+    BinaryExp* b = static_cast<BinaryExp*>(rango);
+    if (b->op != RANGE_OP && b->op != DOWNTO_OP) return r;
+    r.rango = b;
+    r.inicio = b->left;
+    r.limite = b->right;
+    r.descendente = b->op == DOWNTO_OP;
+    return r;
+}
+
+bool inmediatoDeBucle(Exp* e, Type* tipo, long long& v) {
+    if (!e) {
+        v = 1;
+        return true;
+    }
+    if (!constantBits(e, tipo, v)) return false;
+    // Los bits bajos con signo: `as` acepta así cualquier ancho de operando
+    switch (getTypeSize(tipo)) {
+        case 1: v = static_cast<int8_t>(v); return true;
+        case 2: v = static_cast<int16_t>(v); return true;
+        case 4: v = static_cast<int32_t>(v); return true;
+        default: return v >= INT32_MIN && v <= INT32_MAX;
+    }
+}
+
+// ===========================================================
+//   Análisis
+// ===========================================================
+
+void SethiUllmanAnalysis::run(Program* p, PassManager& pm) {
+    forEachExp(p, [](Exp* e) {
+        if (e->kind != NODE_BINARY || e->isnumber) {
+            e->etiqueta = 0; // Hojas y constantes plegadas: un solo mov
+            return;
+        }
+        BinaryExp* b = static_cast<BinaryExp*>(e);
+        int le = b->left ? b->left->etiqueta : 0;
+        int ri = b->right ? b->right->etiqueta : 0;
+        b->etiqueta = (le == ri) ? le + 1 : max(le, ri);
+    });
+}
+
+// ===========================================================
+//   Transformaciones
+// ===========================================================
+
+// Reemplaza en una lista de sentencias los if/while cuya condición es constante
+static bool pruneBlock(Block* b);
+
+static bool pruneStm(Stm* s) {
+    switch (s->kind) {
+        case NODE_BLOCK: return pruneBlock(static_cast<Block*>(s));
+        case NODE_IF: {
+            IfStmt* i = static_cast<IfStmt*>(s);
+            bool changed = pruneBlock(i->thenBlock);
+            if (i->elseBlock) changed |= pruneBlock(i->elseBlock);
+            return changed;
+        }
+        case NODE_WHILE: return pruneBlock(static_cast<WhileStmt*>(s)->block);
+        case NODE_FOR:   return pruneBlock(static_cast<ForStmt*>(s)->block);
+        default:         return false;
+    }
+}
+
+static bool pruneBlock(Block* b) {
+    if (!b) return false;
+    bool changed = false;
+    for (auto it = b->stmts.begin(); it != b->stmts.end();) {
+        if ((*it)->kind == NODE_IF) {
+            IfStmt* i = static_cast<IfStmt*>(*it);
+            if (i->condition->isnumber) {
+                // Distinta de cero: queda el bloque then; cero: el else (si existe)
+                Block* kept = i->condition->valor != 0 ? i->thenBlock : i->elseBlock;
+                // El if se borra con la condición y la rama descartada; la que queda se conserva
+                if (kept == i->thenBlock) i->thenBlock = nullptr;
+                else i->elseBlock = nullptr;
+                delete i;
+                changed = true;
+                if (kept) {
+                    *it = kept;
+                } else {
+                    it = b->stmts.erase(it);
+                    continue;
+                }
+            }
+        } else if ((*it)->kind == NODE_WHILE) {
+            WhileStmt* w = static_cast<WhileStmt*>(*it);
+            if (w->condition->isnumber && w->condition->valor == 0) {
+                delete w;
+                it = b->stmts.erase(it);
+                changed = true;
+                continue;
+            }
+        }
+        changed |= pruneStm(*it);
+        ++it;
+    }
+    return changed;
+}
+
+bool DeadBranchPass::run(Program* p, PassManager& pm) {
+    bool changed = false;
+    for (auto fd : p->fdlist) changed |= pruneBlock(fd->cuerpo);
+    return changed;
+}
+
+bool DeadFunctionPass::run(Program* p, PassManager& pm) {
+    CallGraphAnalysis* grafo = pm.getAnalysis<CallGraphAnalysis>(p);
+    bool changed = false;
+    for (auto it = p->fdlist.begin(); it != p->fdlist.end();) {
+        if (!grafo->alcanzable((*it)->nombre)) {
+            delete *it;
+            it = p->fdlist.erase(it);
+            changed = true;
+        } else {
+            ++it;
+        }
+    }
+    return changed;
+}
+
+// ===========================================================
+//   PassManager
+// ===========================================================
+
+PassManager::PassManager(int optLevel, bool timePasses) : optLevel(optLevel), timePasses(timePasses) {
+    registerPass(new SethiUllmanAnalysis());
+    registerPass(new CallGraphAnalysis());
+    registerPass(new ConstantFoldPass());
+    registerPass(new DeadBranchPass());
+    registerPass(new DeadFunctionPass());
+    registerPass(new LoopInvariantPass());
+    registerPass(new ScalarEvolutionPass());
+    registerPass(new LoopUnrollPass());
+    buildPipeline(optLevel);
+}
+
+PassManager::~PassManager() {
+    for (auto& pair : registry) delete pair.second;
+}
+
+void PassManager::registerPass(Pass* p) {
+    auto it = registry.find(p->name());
+    if (it != registry.end()) delete it->second;
+    registry[p->name()] = p;
+    if (p->isAnalysis()) validAnalyses[p->name()] = false;
+}
+
+void PassManager::buildPipeline(int level) {
+    optLevel = level;
+    pipeline.clear();
+    if (level <= 0) return; // -O0: el AST va directo al codegen
+
+    // Lo que dejan la forma cerrada y el desenrollado (constantes) se vuelve a plegar
+    pipeline = {"constfold", "dead-branch", "dead-functions", "licm", "scev", "unroll", "constfold", "dead-branch",
+                SethiUllmanAnalysis::ID};
+}
+
+PassManager::Timing& PassManager::timingFor(const string& name) {
+    for (auto& t : timings)
+        if (t.name == name) return t;
+    timings.push_back({name});
+    return timings.back();
+}
+
+AnalysisPass* PassManager::getAnalysis(const string& name, Program* p) {
+    auto it = registry.find(name);
+    if (it == registry.end() || !it->second->isAnalysis()) {
+        cerr << "[Error] Análisis no registrado: " << name << endl;
+        return nullptr;
+    }
+    AnalysisPass* a = static_cast<AnalysisPass*>(it->second);
+    if (!validAnalyses[name]) {
+        time(name, [&]() { a->run(p, *this); });
+        validAnalyses[name] = true;
+    }
+    return a;
+}
+
+void PassManager::invalidateAll() {
+    for (auto& pair : validAnalyses) pair.second = false;
+}
+
+bool PassManager::runTransform(TransformPass* t, Program* p) {
+    bool changed = false;
+    time(t->name(), [&]() { changed = t->run(p, *this); });
+    if (changed) {
+        // Invalida los análisis que el pase no declara preservar
+        for (auto& pair : validAnalyses)
+            if (!t->preserves(pair.first)) pair.second = false;
+    }
+    return changed;
+}
+
+bool PassManager::run(Program* p) {
+    bool any = false;
+    // En -O2 se repiten las transformaciones hasta un punto fijo
+    int maxIterations = optLevel >= 2 ? 4 : 1;
+    for (int iter = 0; iter < maxIterations; ++iter) {
+        bool changed = false;
+        for (auto& name : pipeline) {
+            Pass* pass = registry[name];
+            if (pass->isAnalysis()) getAnalysis(name, p);
+            else changed |= runTransform(static_cast<TransformPass*>(pass), p);
+        }
+        any |= changed;
+        if (!changed) break;
+    }
+    return any;
+}
+
+void PassManager::printTimeReport(ostream& os) const {
+    double total = 0;
+    for (auto& t : timings) total += t.ms;
+    os << "===-------------------------------------------------------------===\n";
+    os << "                 Reporte de tiempo por pase (-O" << optLevel << ")\n";
+    os << "===-------------------------------------------------------------===\n";
+    os << "  Tiempo (ms)    %      Ejec.  Pase\n";
+    os << fixed << setprecision(3);
+    for (auto& t : timings) {
+        double pct = total > 0 ? 100.0 * t.ms / total : 0;
+        os << setw(12) << t.ms << "  " << setw(6) << setprecision(1) << pct << setprecision(3)
+           << setw(7) << t.runs << "  " << t.name << "\n";
+    }
+    os << setw(12) << total << "  " << setw(6) << setprecision(1) << 100.0 << setprecision(3)
+       << setw(7) << "" << "  Total\n";
+    os.unsetf(ios::floatfield);
+}
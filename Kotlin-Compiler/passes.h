@@ -0,0 +1,321 @@
+#ifndef PASSES_H
+#define PASSES_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <chrono>
+#include <ostream>
+#include <functional>
+#include "ast.h"
+
+using namespace std;
+
+class PassManager;
+class TypeTable;
+
+// Visita en post-orden todas las expresiones de un nodo (passes.cpp)
+void forEachExp(Exp* e, const function<void(Exp*)>& f);
+void forEachExp(Stm* s, const function<void(Exp*)>& f);
+void forEachExp(Program* p, const function<void(Exp*)>& f);
+
+// Patrón de bits de la constante plegada `e` convertida al tipo `target`,
+// listo para un inmediato o un .quad. Devuelve false si no es constante (constfold.cpp)
+bool constantBits(Exp* e, Type* target, long long& bits);
+
+// En `x ** k` real con `k` constante 0, 1 o 2 devuelve `k`: se calcula sin
+// `pow` (1, x, x * x), también al plegar. -1 en cualquier otro caso.
+int exponenteRealSimple(BinaryExp* e);
+
+// ¿El codegen evalúa `e` llamando a `pow` de la libm?
+bool llamaPow(BinaryExp* e);
+
+// ¿La comparación entera `e` es sin signo? Lo es si su tipo común (el de
+// mayor rango; a igual rango, el izquierdo) lo es. Así la pliega constfold
+bool comparacionSinSigno(BinaryExp* e);
+
+// En `x * k`, `x / k` o `x % k` enteros con `k` constante (o `k * x`), el
+// operando constante si el codegen lo reduce a desplazamientos, máscaras o un
+// producto por el inverso, con `k` ya convertido al tipo del resultado.
+// nullptr si no se reduce: k = 0 y MIN / -1 siguen en `idiv`, que atrapa.
+Exp* operandoReducible(BinaryExp* e, long long& k);
+
+// Nodo ya plegado con el valor `v` ajustado al ancho y signo de `t` (constfold.cpp)
+Exp* constanteDe(long long v, Type* t);
+
+// Nodos que crean los pases después del TypeChecker, ya con su tipo
+IdExp* lecturaDe(Symbol* s);
+BinaryExp* operacionTipada(Exp* l, Exp* r, BinaryOp op, Type* tipo);
+// Local nueva (oculta) de tipo `tipo`; el Program queda dueño del símbolo
+VarDec* declaracionOculta(Program* p, const string& nombre, Exp* init, Type* tipo);
+
+// Partes de `for (x in inicio..limite step paso)`, o `downTo` si es descendente
+struct RangoFor {
+    BinaryExp* rango = nullptr; // El `..`/`downTo`; nullptr si el rango no tiene esa forma
+    Exp* inicio = nullptr;
+    Exp* limite = nullptr;
+    Exp* paso = nullptr;        // nullptr: paso 1
+    bool descendente = false;
+};
+RangoFor rangoDe(ForStmt* s);
+
+// Límite o paso constante de un `for` que el codegen usa como inmediato de
+// `add`/`cmp` en lugar de guardarlo en su símbolo oculto (también el `k` de
+// un `x = x + k`). `paso` nullptr es 1
+bool inmediatoDeBucle(Exp* e, Type* tipo, long long& v);
+
+// ===========================================================
+//  Pases de optimización y análisis sobre el AST
+// ===========================================================
+
+// Clase base de todos los pases
+class Pass {
+public:
+    virtual ~Pass() {}
+    virtual string name() const = 0;
+    virtual bool isAnalysis() const { return false; }
+};
+
+// Pase de análisis: calcula información sin modificar el AST.
+// El PassManager guarda el resultado hasta que una transformación lo invalide.
+class AnalysisPass : public Pass {
+public:
+    bool isAnalysis() const override { return true; }
+    virtual void run(Program* p, PassManager& pm) = 0;
+};
+
+// Pase de transformación: modifica el AST. Devuelve true si hubo cambios.
+class TransformPass : public Pass {
+public:
+    virtual bool run(Program* p, PassManager& pm) = 0;
+    // Análisis que siguen siendo válidos después de este pase
+    virtual bool preserves(const string& analysis) const { return false; }
+};
+
+// Orden de evaluación de un BinaryExp según Sethi-Ullman: primero el hijo
+// que necesita más registros, si adelantar el derecho no se nota. El codegen,
+// el bytecode y el RegisterAllocator lo comparten (definido en visitor.cpp)
+bool izquierdaPrimero(BinaryExp* e);
+
+// ===========================================================
+//  Análisis
+// ===========================================================
+
+// Pesos de Sethi-Ullman: guarda en cada Exp::etiqueta el número de
+// registros necesarios para evaluarla sin pasar por la pila.
+class SethiUllmanAnalysis : public AnalysisPass {
+public:
+    static constexpr const char* ID = "sethi-ullman";
+    string name() const override { return ID; }
+    void run(Program* p, PassManager& pm) override;
+};
+
+// Forma de un argumento en un sitio de llamada
+enum FormaArgumento {
+    ARG_CONSTANTE, // Plegado por constfold (isnumber)
+    ARG_VARIABLE,  // IdExp
+    ARG_EXPRESION  // Cualquier otra cosa
+};
+
+struct SitioLlamada {
+    FcallExp* llamada;
+    int llamador;   // Índice en `funciones` (-1: inicializador de una global)
+    int destino;    // Índice de la función llamada
+    vector<FormaArgumento> formas;
+};
+
+struct NodoLlamadas {
+    FunDec* dec;
+    vector<int> salientes;   // Sitios de llamada dentro de su cuerpo
+    vector<int> entrantes;   // Sitios de llamada que la invocan
+    int componente = -1;     // Índice en `componentes`
+    bool recursiva = false;  // Se llama a sí misma, directa o indirectamente
+    bool hoja = false;       // No llama a nada: ni funciones propias, ni printf, ni pow
+    bool alcanzable = false; // Desde `main` o desde el inicializador de una global
+};
+
+// Grafo de llamadas de todo el programa (callgraph.cpp). Solo cuenta las
+// llamadas a funciones declaradas; las conversiones (`x.toInt()`) no son
+// llamadas. Se calcula una vez y lo consultan los pases que necesiten
+// saber quién llama a quién.
+class CallGraphAnalysis : public AnalysisPass {
+public:
+    static constexpr const char* ID = "call-graph";
+    vector<NodoLlamadas> funciones;   // En el orden de Program::fdlist
+    vector<SitioLlamada> sitios;
+    // Componentes fuertemente conexas en orden topológico inverso: cada
+    // una aparece después de todas las que llama (de abajo hacia arriba)
+    vector<vector<int>> componentes;
+
+    string name() const override { return ID; }
+    void run(Program* p, PassManager& pm) override;
+
+    // nullptr si no hay una función con ese nombre
+    const NodoLlamadas* nodo(const string& nombre) const;
+    bool alcanzable(const string& nombre) const;
+
+private:
+    unordered_map<string, int> indice;
+
+    void agregarSitios(Stm* s, int llamador);
+    void calcularComponentes();
+    void marcarAlcanzables(int raiz);
+};
+
+// ===========================================================
+//  Transformaciones
+// ===========================================================
+
+// Plegado de constantes según el tipo inferido (isnumber / valor / valorReal).
+// Corre después del TypeChecker (constfold.cpp)
+class ConstantFoldPass : public TransformPass {
+public:
+    string name() const override { return "constfold"; }
+    bool run(Program* p, PassManager& pm) override;
+    bool preserves(const string& analysis) const override { return analysis == CallGraphAnalysis::ID; }
+};
+
+// Eliminación de ramas muertas: if/while con condición constante
+class DeadBranchPass : public TransformPass {
+public:
+    string name() const override { return "dead-branch"; }
+    bool run(Program* p, PassManager& pm) override;
+    bool preserves(const string& analysis) const override { return analysis == SethiUllmanAnalysis::ID; }
+};
+
+// Eliminación de funciones no alcanzables desde `main`
+class DeadFunctionPass : public TransformPass {
+public:
+    string name() const override { return "dead-functions"; }
+    bool run(Program* p, PassManager& pm) override;
+    // El grafo apunta a las FunDec borradas
+    bool preserves(const string& analysis) const override { return analysis != CallGraphAnalysis::ID; }
+};
+
+// Bucles (licm.cpp): saca de cada while/for las subexpresiones que no cambian
+// entre vueltas y reduce `i * k` sobre el contador de un for a una suma por vuelta
+class LoopInvariantPass : public TransformPass {
+public:
+    string name() const override { return "licm"; }
+    bool run(Program* p, PassManager& pm) override;
+
+private:
+    Program* programa = nullptr;
+    int creados = 0;                    // Para nombrar los símbolos nuevos
+    unordered_set<Symbol*> invariantes; // Locales nuevas que solo se asignan al declararlas
+
+    bool bloque(Block* b);
+    bool sentencia(Stm* s);
+    // Lo que sale del bucle queda en `previas`, para declararlo justo antes
+    void optimizar(Stm* bucle, vector<VarDec*>& previas);
+    void reducir(ForStmt* s, vector<VarDec*>& previas);
+    VarDec* declarar(const string& nombre, Exp* init, Type* tipo);
+};
+
+// Forma cerrada de los while/for que solo acumulan en locales (scev.cpp):
+// `s = s + i` y sus variantes polinomiales se reemplazan por el valor final.
+// Necesita la TypeTable para los ULong y Bool que crea; sin ella no hace nada.
+class ScalarEvolutionPass : public TransformPass {
+public:
+    explicit ScalarEvolutionPass(TypeTable* tipos = nullptr) : tipos(tipos) {}
+    string name() const override { return "scev"; }
+    bool run(Program* p, PassManager& pm) override;
+
+private:
+    TypeTable* tipos;
+    Program* programa = nullptr;
+    unordered_set<Stm*> conservados; // Bucles que quedaron como respaldo de una forma cerrada
+
+    bool bloque(Block* b);
+    bool sentencia(Stm* s);
+    // Inserta en `destino` antes de `donde` lo que reemplaza al bucle
+    bool cerrar(Stm* bucle, list<Stm*>& destino, list<Stm*>::iterator donde);
+};
+
+// Desenrollado de for con paso constante (unroll.cpp): del todo si son pocas
+// vueltas constantes; si no, `factor` copias del cuerpo por vuelta y el for
+// original para el resto. Necesita la TypeTable para las comparaciones que
+// crea: sin ella (el PassManager por defecto) no hace nada.
+class LoopUnrollPass : public TransformPass {
+public:
+    explicit LoopUnrollPass(TypeTable* tipos = nullptr, int factor = 4) : tipos(tipos), factor(factor) {}
+    string name() const override { return "unroll"; }
+    bool run(Program* p, PassManager& pm) override;
+
+private:
+    TypeTable* tipos;
+    int factor;
+    Program* programa = nullptr;
+    unordered_set<ForStmt*> restos; // For que ya quedaron como resto de un desenrollado
+
+    bool bloque(Block* b);
+    bool sentencia(Stm* s);
+    // Inserta en `destino` antes de `donde` lo que reemplaza o precede al for
+    bool desenrollar(ForStmt* s, list<Stm*>& destino, list<Stm*>::iterator donde);
+};
+
+// ===========================================================
+//  PassManager
+// ===========================================================
+
+class PassManager {
+private:
+    struct Timing {
+        string name;
+        double ms = 0;
+        int runs = 0;
+    };
+
+    int optLevel;
+    bool timePasses;
+    unordered_map<string, Pass*> registry;    // Pases registrados por nombre
+    unordered_map<string, bool> validAnalyses; // Análisis con resultado vigente
+    vector<string> pipeline;                   // Secuencia del nivel -O elegido
+    vector<Timing> timings;                    // Reporte -ftime-passes
+    double nestedMs = 0;                       // Tiempo de fases anidadas (p. ej. un análisis pedido por un pase)
+
+    Timing& timingFor(const string& name);
+    bool runTransform(TransformPass* t, Program* p);
+
+public:
+    PassManager(int optLevel = 1, bool timePasses = false);
+    ~PassManager();
+
+    // Registra un pase (el PassManager toma posesión del puntero)
+    void registerPass(Pass* p);
+    // Arma la secuencia de pases para -O0/-O1/-O2
+    void buildPipeline(int level);
+    const vector<string>& getPipeline() const { return pipeline; }
+    int getOptLevel() const { return optLevel; }
+
+    // Ejecuta la secuencia. Devuelve true si algún pase modificó el AST
+    bool run(Program* p);
+
+    // Devuelve un análisis, recalculándolo solo si fue invalidado
+    AnalysisPass* getAnalysis(const string& name, Program* p);
+    template <class A>
+    A* getAnalysis(Program* p) { return static_cast<A*>(getAnalysis(A::ID, p)); }
+    void invalidateAll();
+
+    // Mide una fase externa al pipeline (parser, typechecker, codegen).
+    // Cada fase registra solo su tiempo propio: lo de las fases anidadas se descuenta.
+    template <class F>
+    void time(const string& name, F f) {
+        double outerNested = nestedMs;
+        nestedMs = 0;
+        auto t0 = chrono::steady_clock::now();
+        f();
+        auto t1 = chrono::steady_clock::now();
+        double elapsed = chrono::duration<double, milli>(t1 - t0).count();
+        Timing& t = timingFor(name);
+        t.ms += elapsed - nestedMs;
+        t.runs++;
+        nestedMs = outerNested + elapsed;
+    }
+
+    bool timingEnabled() const { return timePasses; }
+    void printTimeReport(ostream& os) const;
+};
+
+#endif // PASSES_H
@@ -0,0 +1,201 @@
+#include "peephole.h"
+#include <cstdint>
+
+using namespace std;
+
+// Registro de propósito general (no XMM ni AH)
+static bool esGP(const Operando& o) {
+    return o.tipo == Operando::REG && o.reg < XMM0;
+}
+
+static bool esCero(const Operando& o) {
+    return o.tipo == Operando::INM && o.valor == 0;
+}
+
+// `i` escribe el registro `r` completo (64 bits) con un valor que ya está
+// extendido desde `tam` bytes como lo haría `ext` (MOVSX o MOVZX)
+static bool yaExtendido(const Instr& i, Op ext, int r, int tam) {
+    if ((i.op == MOVSX || i.op == MOVZX) && i.b.esReg() && i.b.reg == r && i.b.tam == 8)
+        return i.op == ext && i.a.tam <= tam;
+    // mov $v: con 4 bytes limpia la parte alta, con 8 extiende el inmediato
+    if (i.op == MOV && i.a.tipo == Operando::INM && i.b.esReg() && i.b.reg == r && i.b.tam >= 4) {
+        int64_t v = i.a.valor;
+        if (tam == 4) return v >= 0 && v <= INT32_MAX;
+        if (tam == 2) return ext == MOVSX ? v >= 0 && v <= INT16_MAX : v >= 0 && v <= UINT16_MAX;
+        if (tam == 1) return ext == MOVSX ? v >= 0 && v <= INT8_MAX : v >= 0 && v <= UINT8_MAX;
+    }
+    return false;
+}
+
+// ===========================================================
+//   Patrones
+// ===========================================================
+
+// pushq X; popq X  ->  (nada)
+// pushq X; popq Y  ->  movq X, Y
+static int pushPop(vector<Instr>& v) {
+    size_t n = v.size();
+    if (n < 2 || v[n - 2].op != PUSH || v[n - 1].op != POP) return -1;
+    Operando x = v[n - 2].a, y = v[n - 1].a;
+    if (!esGP(x) || !esGP(y)) return -1;
+    v.pop_back();
+    v.pop_back();
+    if (x == y) return 2;
+    v.push_back({MOV, CC_O, x, y});
+    return 1;
+}
+
+// mov X, X  ->  (nada); salvo movl, que limpia la parte alta
+static int movNulo(vector<Instr>& v) {
+    Instr& i = v.back();
+    if (i.op != MOV || !esGP(i.a) || i.a != i.b || i.a.tam == 4) return -1;
+    v.pop_back();
+    return 1;
+}
+
+// mov S, D; mov D', R  ->  mov S, D; mov S', R
+// La recarga (también movs/movz) lee el valor recién guardado desde el
+// registro de origen en lugar de la memoria o del registro destino.
+static int guardarRecargar(vector<Instr>& v) {
+    size_t n = v.size();
+    if (n < 2) return -1;
+    Instr& g = v[n - 2];
+    Instr& c = v[n - 1];
+    if (g.op != MOV || !esGP(g.a) || g.b.tipo == Operando::INM || g.a == g.b) return -1;
+    if (c.op != MOV && c.op != MOVSX && c.op != MOVZX) return -1;
+    if (c.a != g.b) return -1;
+    c.a = g.a;
+    if (c.op == MOV && c.a == c.b && c.a.tam != 4) {
+        v.pop_back(); // Recargaba en el mismo registro
+        return 1;
+    }
+    return 0;
+}
+
+// movl $0, %eax; setCC %al; movzbq %al, %rax  ->  setCC %al; movzbq %al, %rax
+static int ceroAntesDeSet(vector<Instr>& v) {
+    size_t n = v.size();
+    if (n < 3) return -1;
+    Instr& cero = v[n - 3];
+    Instr& set = v[n - 2];
+    Instr& ext = v[n - 1];
+    if (cero.op != MOV || !esCero(cero.a) || !esGP(cero.b)) return -1;
+    if (set.op != SETCC || !set.a.esReg() || set.a.reg != cero.b.reg) return -1;
+    if (ext.op != MOVZX || ext.a != set.a || !ext.b.esReg() || ext.b.reg != cero.b.reg || ext.b.tam < 4) return -1;
+    v.erase(v.end() - 3); // movzb ya escribe el registro entero, y mov no toca las banderas
+    return 1;
+}
+
+// movslq X, %rax; movslq %eax, %rax  ->  movslq X, %rax
+// (lo mismo con movz y con un mov $v que ya deja el valor extendido)
+static int extensionRedundante(vector<Instr>& v) {
+    size_t n = v.size();
+    if (n < 2) return -1;
+    Instr& ext = v[n - 1];
+    if (ext.op != MOVSX && ext.op != MOVZX) return -1;
+    if (!esGP(ext.a) || !ext.b.esReg() || ext.a.reg != ext.b.reg || ext.b.tam != 8) return -1;
+    if (!yaExtendido(v[n - 2], ext.op, ext.a.reg, ext.a.tam)) return -1;
+    v.pop_back();
+    return 1;
+}
+
+// movq %rax, %rcx; <carga en rax>; xchgq %rax, %rcx  ->  <carga en rcx>
+// (el operando izquierdo esperaba en RCX mientras se cargaba el derecho)
+static int cargaIntercambiada(vector<Instr>& v) {
+    size_t n = v.size();
+    if (n < 3) return -1;
+    Instr& mov = v[n - 3];
+    Instr carga = v[n - 2];
+    Instr& xchg = v[n - 1];
+    if (mov.op != MOV || !mov.a.esReg(RAX) || !mov.b.esReg(RCX) || mov.a.tam != 8 || mov.b.tam != 8) return -1;
+    if (xchg.op != XCHG || !xchg.a.esReg(RAX) || !xchg.b.esReg(RCX) || xchg.a.tam != 8) return -1;
+    if (carga.op != MOV && carga.op != MOVSX && carga.op != MOVZX && carga.op != LEA) return -1;
+    if (!carga.b.esReg(RAX) || carga.a.esReg(RAX) || carga.a.esReg(RCX)) return -1;
+    carga.b.reg = RCX;
+    v.resize(n - 3);
+    v.push_back(carga);
+    return 2;
+}
+
+// jmp L; L:  ->  L:
+static int saltoAlSiguiente(vector<Instr>& v) {
+    size_t n = v.size();
+    if (n < 2 || v[n - 1].op != ETIQUETA) return -1;
+    Instr& salto = v[n - 2];
+    if ((salto.op != JMP && salto.op != JCC) || salto.a != v[n - 1].a) return -1;
+    v.erase(v.end() - 2);
+    return 1;
+}
+
+// jmp/ret seguido de algo que no es una etiqueta: nunca se ejecuta
+static int inalcanzable(vector<Instr>& v) {
+    size_t n = v.size();
+    if (n < 2) return -1;
+    Op previo = v[n - 2].op;
+    Op actual = v[n - 1].op;
+    if ((previo != JMP && previo != RET) || esPseudo(actual)) return -1;
+    v.pop_back();
+    return 1;
+}
+
+Peephole::Peephole() {
+    patrones = {
+        {"push-pop", pushPop},
+        {"mov-nulo", movNulo},
+        {"guardar-recargar", guardarRecargar},
+        {"cero-antes-de-set", ceroAntesDeSet},
+        {"extension-redundante", extensionRedundante},
+        {"carga-intercambiada", cargaIntercambiada},
+        {"salto-al-siguiente", saltoAlSiguiente},
+        {"inalcanzable", inalcanzable},
+    };
+}
+
+bool Peephole::pasada(vector<Instr>& instrs) {
+    vector<Instr> salida;
+    salida.reserve(instrs.size());
+    bool cambio = false;
+    for (auto& i : instrs) {
+        salida.push_back(i);
+        // Aplica patrones sobre la cola mientras alguno la cambie
+        bool aplico = true;
+        while (aplico && !salida.empty()) {
+            aplico = false;
+            for (auto& p : patrones) {
+                int eliminadas = p.aplicar(salida);
+                if (eliminadas < 0) continue;
+                if (eliminadas == 0) p.reescrituras++;
+                p.eliminadas += eliminadas;
+                cambio = true;
+                // Una reescritura no vuelve a aplicar sobre la misma cola
+                aplico = eliminadas > 0;
+                break;
+            }
+        }
+    }
+    instrs.swap(salida);
+    return cambio;
+}
+
+void Peephole::run(vector<Instr>& instrs) {
+    pasadas = 0;
+    do {
+        ++pasadas;
+    } while (pasada(instrs));
+}
+
+int Peephole::totalEliminadas() const {
+    int total = 0;
+    for (auto& p : patrones) total += p.eliminadas;
+    return total;
+}
+
+void Peephole::reporte(ostream& os) const {
+    os << "peephole: " << totalEliminadas() << " instrucciones eliminadas en " << pasadas << " pasadas\n";
+    for (auto& p : patrones) {
+        if (p.eliminadas == 0 && p.reescrituras == 0) continue;
+        os << "  " << p.nombre << ": " << p.eliminadas << " eliminadas";
+        if (p.reescrituras) os << ", " << p.reescrituras << " reescritas";
+        os << "\n";
+    }
+}
@@ -0,0 +1,45 @@
+#ifndef PEEPHOLE_H
+#define PEEPHOLE_H
+
+#include <ostream>
+#include <vector>
+#include "x86.h"
+
+using namespace std;
+
+// ===========================================================
+//  Optimizador peephole sobre la lista de instrucciones
+// ===========================================================
+//
+// Corre en -O1 y -O2 después del codegen. Recorre las instrucciones
+// copiándolas a una salida; tras cada copia prueba la tabla de patrones
+// sobre la cola de la salida (la ventana). Si uno aplica, reescribe la cola
+// y se vuelve a probar, así una simplificación puede habilitar otra. Las
+// pasadas se repiten hasta que ninguna cambia nada.
+class Peephole {
+public:
+    struct Patron {
+        const char* nombre;
+        // Mira la cola de `v`; devuelve las instrucciones eliminadas, o -1
+        // si no aplica. Si reescribe sin eliminar devuelve 0.
+        int (*aplicar)(vector<Instr>& v);
+        int eliminadas = 0;
+        int reescrituras = 0;
+    };
+
+private:
+    vector<Patron> patrones;
+
+    bool pasada(vector<Instr>& instrs);
+
+public:
+    int pasadas = 0;
+
+    Peephole();
+    void run(vector<Instr>& instrs);
+    int totalEliminadas() const;
+    // Una línea por patrón que aplicó al menos una vez
+    void reporte(ostream& os) const;
+};
+
+#endif // PEEPHOLE_H
@@ -0,0 +1,235 @@
+#include "regalloc.h"
+#include "passes.h"
+#include <algorithm>
+
+using namespace std;
+
+// ===========================================================
+//   Intervalos de vida
+// ===========================================================
+
+void RegisterAllocator::referencia(Symbol* s) {
+    if (!s || s->global) return;
+    auto it = indice.find(s);
+    if (it == indice.end()) {
+        indice.emplace(s, static_cast<int>(intervalos.size()));
+        intervalos.push_back({s, pos, pos});
+        it = indice.find(s);
+    }
+    Intervalo& iv = intervalos[it->second];
+    iv.inicio = min(iv.inicio, pos);
+    iv.fin = max(iv.fin, pos);
+    double peso = 1;
+    for (int i = 0; i < min(profundidad, 4); ++i) peso *= 8;
+    iv.peso += peso;
+}
+
+void RegisterAllocator::run(Program* p) {
+    enRegistro = enMemoria = 0;
+    for (auto f : p->fdlist)
+        visit(f);
+}
+
+void RegisterAllocator::visit(FunDec* f) {
+    pos = 0;
+    profundidad = 0;
+    intervalos.clear();
+    indice.clear();
+    llamadas.clear();
+    bucles.clear();
+
+    // Los parámetros se definen al entrar
+    for (auto s : f->params) referencia(s);
+    dispatch(f->cuerpo);
+    asignar(f);
+}
+
+// Las posiciones siguen el orden en que GenCodeVisitor evalúa cada nodo:
+// si no, una variable leída después de una llamada podría quedar en un
+// registro que la llamada destruye.
+
+void RegisterAllocator::visit(Block* b) {
+    for (auto s : b->stmts)
+        dispatch(s);
+}
+
+void RegisterAllocator::visit(VarDec* v) {
+    // Aunque no tenga inicializador, el intervalo empieza en la declaración:
+    // una variable asignada dentro de un bucle sigue viva entre vueltas
+    if (v->init) dispatch(v->init);
+    ++pos;
+    referencia(v->sym);
+}
+
+void RegisterAllocator::visit(IfStmt* s) {
+    dispatch(s->condition);
+    dispatch(s->thenBlock);
+    if (s->elseBlock) dispatch(s->elseBlock);
+}
+
+void RegisterAllocator::visit(WhileStmt* s) {
+    int inicio = ++pos;
+    ++profundidad;
+    dispatch(s->condition);
+    dispatch(s->block);
+    --profundidad;
+    bucles.push_back({inicio, ++pos});
+}
+
+void RegisterAllocator::visit(ForStmt* s) {
+    // Mismo orden que GenCodeVisitor::visit(ForStmt*): el contador se guarda
+    // antes de evaluar el límite, así que no puede compartir registro con
+    // una variable que el límite lee por última vez
+    RangoFor r = rangoDe(s);
+    long long v;
+    Symbol* limite = inmediatoDeBucle(r.limite, s->varSym->tipo, v) ? nullptr : s->endSym;
+    Symbol* paso = inmediatoDeBucle(r.paso, s->varSym->tipo, v) ? nullptr : s->stepSym;
+    if (r.inicio) dispatch(r.inicio);
+    ++pos;
+    referencia(s->varSym);
+    if (limite) {
+        dispatch(r.limite);
+        ++pos;
+        referencia(limite);
+    }
+    if (paso) {
+        dispatch(r.paso);
+        ++pos;
+        referencia(paso);
+    }
+
+    int inicio = ++pos;
+    ++profundidad;
+    referencia(s->varSym); // Comparación con el límite
+    referencia(limite);
+    dispatch(s->block);
+    ++pos;
+    referencia(s->varSym); // Incremento
+    referencia(paso);
+    --profundidad;
+    bucles.push_back({inicio, pos});
+}
+
+void RegisterAllocator::visit(PrintStm* s) {
+    dispatch(s->e);
+    llamadas.push_back(++pos);
+}
+
+void RegisterAllocator::visit(ReturnStm* s) {
+    if (s->e) dispatch(s->e);
+}
+
+void RegisterAllocator::visit(BinaryExp* e) {
+    if (e->isnumber) return;
+    if (izquierdaPrimero(e)) {
+        dispatch(e->left);
+        dispatch(e->right);
+    } else {
+        dispatch(e->right);
+        dispatch(e->left);
+    }
+    if (llamaPow(e)) llamadas.push_back(++pos);
+}
+
+void RegisterAllocator::visit(IdExp* e) {
+    ++pos;
+    referencia(e->sym);
+}
+
+void RegisterAllocator::visit(AssignExp* e) {
+    dispatch(e->e);
+    ++pos;
+    referencia(e->sym);
+}
+
+void RegisterAllocator::visit(FcallExp* e) {
+    if (e->receiver) {
+        if (!e->isnumber) dispatch(e->receiver);
+        return;
+    }
+    // Primero los argumentos de la pila (del último al séptimo), luego los de registro
+    int n = static_cast<int>(e->argumentos.size());
+    for (int i = n - 1; i >= 6; --i) dispatch(e->argumentos[i]);
+    for (int i = 0; i < min(n, 6); ++i) dispatch(e->argumentos[i]);
+    llamadas.push_back(++pos);
+}
+
+// ===========================================================
+//   Linear scan
+// ===========================================================
+
+void RegisterAllocator::asignar(FunDec* f) {
+    f->salvados.clear();
+
+    // Lo que ya estaba vivo al entrar a un bucle y se usa dentro debe
+    // sobrevivir a la vuelta: el intervalo llega hasta el final del bucle
+    for (auto& b : bucles) {
+        for (auto& iv : intervalos)
+            if (iv.inicio < b.first && iv.fin >= b.first && iv.fin < b.second) iv.fin = b.second;
+    }
+
+    for (auto& iv : intervalos) {
+        auto it = upper_bound(llamadas.begin(), llamadas.end(), iv.inicio);
+        iv.cruzaLlamada = it != llamadas.end() && *it < iv.fin;
+    }
+
+    vector<int> orden(intervalos.size());
+    for (size_t i = 0; i < orden.size(); ++i) orden[i] = static_cast<int>(i);
+    stable_sort(orden.begin(), orden.end(), [&](int a, int b) {
+        return intervalos[a].inicio < intervalos[b].inicio;
+    });
+
+    vector<int> activos; // Intervalos con registro, vivos
+    int ocupante[16];    // Intervalo que ocupa cada registro (-1: libre)
+    fill(begin(ocupante), end(ocupante), -1);
+    bool usado[16] = {};
+
+    for (int i : orden) {
+        Intervalo& iv = intervalos[i];
+        iv.sym->reg = -1;
+
+        // Libera los que terminaron antes de este
+        for (auto it = activos.begin(); it != activos.end();) {
+            if (intervalos[*it].fin < iv.inicio) {
+                ocupante[intervalos[*it].sym->reg] = -1;
+                it = activos.erase(it);
+            } else {
+                ++it;
+            }
+        }
+
+        auto permitido = [&](int reg) { return !iv.cruzaLlamada || esCalleeSaved(reg); };
+        int elegido = -1;
+        for (int reg : registrosAsignables) {
+            if (permitido(reg) && ocupante[reg] < 0) { elegido = reg; break; }
+        }
+
+        if (elegido < 0) {
+            // Sin registro libre: cede el suyo el activo de menor peso, si pesa menos
+            int victima = -1;
+            for (int a : activos) {
+                int reg = intervalos[a].sym->reg;
+                if (!permitido(reg)) continue;
+                if (victima < 0 || intervalos[a].peso < intervalos[victima].peso ||
+                    (intervalos[a].peso == intervalos[victima].peso && intervalos[a].fin > intervalos[victima].fin))
+                    victima = a;
+            }
+            if (victima < 0 || intervalos[victima].peso >= iv.peso) continue; // Queda en memoria
+            elegido = intervalos[victima].sym->reg;
+            intervalos[victima].sym->reg = -1;
+            activos.erase(find(activos.begin(), activos.end(), victima));
+        }
+
+        iv.sym->reg = elegido;
+        ocupante[elegido] = i;
+        usado[elegido] = true;
+        activos.push_back(i);
+    }
+
+    for (int reg = 0; reg < 16; ++reg)
+        if (usado[reg] && esCalleeSaved(reg)) f->salvados.push_back(reg);
+    for (auto& iv : intervalos) {
+        if (iv.sym->reg >= 0) ++enRegistro;
+        else ++enMemoria;
+    }
+}
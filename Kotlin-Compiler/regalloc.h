@@ -0,0 +1,80 @@
+#ifndef REGALLOC_H
+#define REGALLOC_H
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "ast.h"
+#include "static_visitor.h"
+#include "x86.h"
+
+using namespace std;
+
+// ===========================================================
+//  Asignación de registros a variables locales (linear scan)
+// ===========================================================
+//
+// Corre en -O1 y -O2 después de los pases y antes de FrameLayout. Numera las
+// referencias de cada función en orden de evaluación y arma un intervalo
+// [primera, última] por local; si una variable se usa dentro de un bucle y
+// ya estaba viva al entrar, su intervalo se extiende hasta el final del
+// bucle. Luego recorre los intervalos por inicio (Poletto-Sarkar):
+//
+//   - Los que cruzan una llamada (función propia o printf) solo pueden ir a
+//     registros callee-saved; la función los guarda en su marco.
+//   - El resto prefiere r10/r11, que ninguna otra parte del codegen toca.
+//   - Sin registro libre, queda en memoria el intervalo de menor peso (las
+//     referencias dentro de bucles pesan más).
+//
+// El resultado queda en Symbol::reg y FunDec::salvados.
+
+// Registros que reparte, en orden de preferencia: r10/r11 primero porque no
+// hay que guardarlos
+static const Reg registrosAsignables[] = {R10, R11, RBX, R12, R13, R14, R15};
+inline bool esCalleeSaved(int reg) { return reg == RBX || (reg >= R12 && reg <= R15); }
+
+class RegisterAllocator final : public StaticVisitor<RegisterAllocator, void> {
+private:
+    struct Intervalo {
+        Symbol* sym;
+        int inicio, fin;
+        double peso = 0;
+        bool cruzaLlamada = false;
+    };
+
+    int pos = 0;         // Posición en orden de evaluación
+    int profundidad = 0; // Bucles que encierran el punto actual
+    vector<Intervalo> intervalos;
+    unordered_map<Symbol*, int> indice;
+    vector<int> llamadas;             // Posiciones de cada call
+    vector<pair<int, int>> bucles;    // [inicio, fin] de cada while/for
+
+    void referencia(Symbol* s);
+    void asignar(FunDec* f);
+
+public:
+    int enRegistro = 0; // Locales que quedaron en registro (estadística)
+    int enMemoria = 0;
+
+    void run(Program* p);
+
+    void visit(FunDec* f);
+    void visit(Block* b);
+    void visit(VarDec* v);
+    void visit(IfStmt* s);
+    void visit(WhileStmt* s);
+    void visit(ForStmt* s);
+    void visit(PrintStm* s);
+    void visit(ReturnStm* s);
+    void visit(BinaryExp* e);
+    void visit(IdExp* e);
+    void visit(AssignExp* e);
+    void visit(FcallExp* e);
+    void visit(NumberExp*) {}
+    void visit(DoubleExp*) {}
+    void visit(LongExp*) {}
+    void visit(BoolExp*) {}
+    void visit(StringExp*) {}
+};
+
+#endif // REGALLOC_H
@@ -0,0 +1,117 @@
+#include "resolver.h"
+
+using namespace std;
+
+Symbol* Resolver::nuevoSimbolo(const string& nombre, bool global) {
+    Symbol* s = new Symbol(nombre, global);
+    program->simbolos.push_back(s);
+    return s;
+}
+
+Symbol* Resolver::buscar(const string& nombre) {
+    Symbol* s = nullptr;
+    if (!env.lookup(nombre, s))
+        errores.push_back("Error: variable '" + nombre + "' no declarada.");
+    return s;
+}
+
+bool Resolver::resolve(Program* p) {
+    program = p;
+    errores.clear();
+    env.clear();
+    env.add_level();
+    for (auto v : p->vdlist)
+        visit(v);
+    for (auto f : p->fdlist)
+        visit(f);
+    env.remove_level();
+    return errores.empty();
+}
+
+void Resolver::visit(FunDec* f) {
+    env.add_level();
+    f->params.clear();
+    for (auto& nombre : f->Pnombres) {
+        Symbol* s = nuevoSimbolo(nombre, false);
+        env.add_var(nombre, s);
+        f->params.push_back(s);
+    }
+    dispatch(f->cuerpo);
+    env.remove_level();
+}
+
+// ===========================================================
+//   Declaraciones y sentencias
+// ===========================================================
+
+void Resolver::visit(VarDec* v) {
+    // El inicializador se resuelve antes: `var x = x` se refiere a otra x
+    if (v->init) dispatch(v->init);
+    if (env.check(v->name))
+        errores.push_back("Error: variable '" + v->name + "' ya declarada.");
+    v->sym = nuevoSimbolo(v->name, env.depth() == 0);
+    env.add_var(v->name, v->sym);
+}
+
+void Resolver::visit(Block* b) {
+    env.add_level();
+    for (auto s : b->stmts)
+        dispatch(s);
+    env.remove_level();
+}
+
+void Resolver::visit(IfStmt* s) {
+    dispatch(s->condition);
+    dispatch(s->thenBlock);
+    if (s->elseBlock) dispatch(s->elseBlock);
+}
+
+void Resolver::visit(WhileStmt* s) {
+    dispatch(s->condition);
+    dispatch(s->block);
+}
+
+void Resolver::visit(ForStmt* s) {
+    // El rango se evalúa fuera del alcance de la variable del bucle
+    dispatch(s->rangeExp);
+
+    env.add_level();
+    s->varSym = nuevoSimbolo(s->varName, false);
+    s->endSym = nuevoSimbolo(s->varName + ".end", false);
+    s->stepSym = nuevoSimbolo(s->varName + ".step", false);
+    env.add_var(s->varName, s->varSym);
+    dispatch(s->block);
+    env.remove_level();
+}
+
+void Resolver::visit(PrintStm* s) {
+    dispatch(s->e);
+}
+
+void Resolver::visit(ReturnStm* s) {
+    if (s->e) dispatch(s->e);
+}
+
+// ===========================================================
+//   Expresiones
+// ===========================================================
+
+void Resolver::visit(BinaryExp* e) {
+    dispatch(e->left);
+    dispatch(e->right);
+}
+
+void Resolver::visit(IdExp* e) {
+    e->sym = buscar(e->value);
+}
+
+void Resolver::visit(AssignExp* e) {
+    dispatch(e->e);
+    e->sym = buscar(e->id);
+}
+
+void Resolver::visit(FcallExp* e) {
+    if (e->receiver) dispatch(e->receiver);
+    for (auto arg : e->argumentos)
+        dispatch(arg);
+}
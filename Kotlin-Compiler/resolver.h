@@ -0,0 +1,56 @@
+#ifndef RESOLVER_H
+#define RESOLVER_H
+
+#include "ast.h"
+#include "environment.h"
+#include "static_visitor.h"
+
+using namespace std;
+
+// ===========================================================
+//  Resolución de nombres
+// ===========================================================
+//
+// Corre una sola vez, justo después del parser. Crea un Symbol por cada
+// declaración (global, parámetro, variable local, variable de bucle) y
+// enlaza cada IdExp / AssignExp / ForStmt con el suyo; el TypeChecker y el
+// codegen ya no buscan nombres por string. La posición de cada local en el
+// marco la decide FrameLayout cuando ya se conocen los tipos.
+//
+// Acumula en `errores` las variables no declaradas y redeclaradas y sigue
+// resolviendo (los usos no declarados quedan con sym == nullptr).
+class Resolver final : public StaticVisitor<Resolver, void> {
+private:
+    Environment<Symbol*> env;
+    Program* program = nullptr;
+
+    Symbol* nuevoSimbolo(const string& nombre, bool global);
+    Symbol* buscar(const string& nombre);
+
+public:
+    vector<string> errores;
+
+    // Devuelve false si hubo errores
+    bool resolve(Program* p);
+
+    void visit(FunDec* f);
+
+    void visit(BinaryExp* e);
+    void visit(NumberExp* e) {}
+    void visit(DoubleExp* e) {}
+    void visit(LongExp* e) {}
+    void visit(BoolExp* e) {}
+    void visit(StringExp* e) {}
+    void visit(IdExp* e);
+    void visit(AssignExp* e);
+    void visit(FcallExp* e);
+    void visit(VarDec* v);
+    void visit(Block* b);
+    void visit(IfStmt* s);
+    void visit(WhileStmt* s);
+    void visit(ForStmt* s);
+    void visit(PrintStm* s);
+    void visit(ReturnStm* s);
+};
+
+#endif // RESOLVER_H
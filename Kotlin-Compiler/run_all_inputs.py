@@ -1,13 +1,15 @@
 import os
+import re
 import subprocess
 import shutil
+import tempfile
 
 # Archivos c++
-programa = ["main.cpp", "scanner.cpp", "token.cpp", "parser.cpp", "ast.cpp", "visitor.cpp", "TypeChecker.cpp"]
+programa = ["main.cpp", "scanner.cpp", "token.cpp", "parser.cpp", "ast.cpp", "visitor.cpp", "TypeChecker.cpp", "passes.cpp", "constfold.cpp", "resolver.cpp", "compiler.cpp", "typecache.cpp", "framelayout.cpp", "callgraph.cpp", "regalloc.cpp", "licm.cpp", "unroll.cpp", "scev.cpp", "x86.cpp", "peephole.cpp", "encoder.cpp", "jit.cpp", "bytecode.cpp", "interprete.cpp"]
 scanner_test = ["test_scanner.cpp", "scanner.cpp", "token.cpp"]
 
 # Compilar Main
-compile = ["g++", "-o", "main.exe"] + programa
+compile = ["g++", "-pthread", "-o", "main.exe"] + programa
 print("Compilando Main:", " ".join(compile))
 result = subprocess.run(compile, capture_output=True, text=True)
 
@@ -26,12 +28,49 @@ if result_scanner.returncode != 0:
 
 print("Compilación exitosa")
 
+# Compila una copia de `fuente` con `opciones`, enlaza el .s y devuelve lo
+# que imprime el programa (None si no compila, no enlaza o no termina)
+def salida_nativa(fuente, opciones):
+    with tempfile.TemporaryDirectory() as tmp:
+        copia = os.path.join(tmp, "programa.txt")
+        shutil.copy(fuente, copia)
+        compilado = subprocess.run([os.path.abspath("main.exe")] + opciones + [copia], capture_output=True, text=True)
+        if compilado.returncode != 0:
+            return None
+        ejecutable = os.path.join(tmp, "programa")
+        enlazado = subprocess.run(["gcc", "-no-pie", "-o", ejecutable, os.path.join(tmp, "programa.s"), "-lm"], capture_output=True, text=True)
+        if enlazado.returncode != 0:
+            return None
+        try:
+            return subprocess.run([ejecutable], capture_output=True, text=True, timeout=10).stdout
+        except subprocess.TimeoutExpired:
+            return None
+
+# Lo que imprime `fuente` ejecutado por el propio compilador (--jit o
+# --interp): con esas opciones stdout es solo la salida del programa
+def salida_en_proceso(fuente, opciones):
+    with tempfile.TemporaryDirectory() as tmp:
+        copia = os.path.join(tmp, "programa.txt")
+        shutil.copy(fuente, copia)
+        try:
+            return subprocess.run([os.path.abspath("main.exe")] + opciones + [copia], capture_output=True, text=True, timeout=10).stdout
+        except subprocess.TimeoutExpired:
+            return None
+
+# Niveles (y factores de desenrollado) que deben imprimir lo mismo que -O0
+variantes = [["-O1"], ["-O2"], ["-O1", "-funroll=1"], ["-O1", "-funroll=2"], ["-O2", "-funroll=8"]]
+# Modos de ejecución que deben imprimir lo mismo que el binario nativo
+en_proceso = [["--jit", "-O0"], ["--jit", "-O1"], ["--jit", "-O2"],
+              ["--interp", "-O0"], ["--interp", "-O1"], ["--interp", "-O2"]]
+
 # Ejecutar
 input_dir = "inputs"
 output_dir = "outputs"
 os.makedirs(output_dir, exist_ok=True)
+diferencias = []
 
-for i in range(1, 19):
+numeros = [int(m.group(1)) for m in (re.fullmatch(r"input(\d+)\.txt", f) for f in os.listdir(input_dir)) if m]
+for i in range(1, max(numeros) + 1):
     filename = f"input{i}.txt"
     filepath = os.path.join(input_dir, filename)
 
@@ -59,5 +98,29 @@ for i in range(1, 19):
             dest_scanner = os.path.join(output_dir, f"input_{i}_tokens.txt")
             shutil.move(scanner_out_file, dest_scanner)
 
+        # Los pases no deben cambiar lo que imprime el programa
+        base = salida_nativa(filepath, ["-O0"])
+        esperada_file = os.path.join(output_dir, f"input_{i}_salida.txt")
+        if os.path.isfile(esperada_file):
+            with open(esperada_file) as f:
+                if base != f.read():
+                    diferencias.append(f"{filename} -O0: salida distinta de {esperada_file}")
+        if base is not None:
+            for opciones in variantes:
+                salida = salida_nativa(filepath, opciones)
+                if salida != base:
+                    diferencias.append(f"{filename} {' '.join(opciones)}: salida distinta de -O0")
+            for opciones in en_proceso:
+                salida = salida_en_proceso(filepath, opciones)
+                if salida != base:
+                    diferencias.append(f"{filename} {' '.join(opciones)}: salida distinta del binario nativo")
+
     else:
         print(filename, "no encontrado en", input_dir)
+
+if diferencias:
+    print("Diferencias:")
+    for d in diferencias:
+        print(" ", d)
+    exit(1)
+print("Todas las salidas coinciden")
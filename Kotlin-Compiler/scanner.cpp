@@ -54,7 +54,7 @@ Token* Scanner::nextToken() {
         // a) Está seguido de un dígito (ej. 3.14) O
         // b) Es el final del número (ej. 3.0f), aunque en muchos lenguajes (Kotlin, Java) 3. es inválido.
         // Usaremos la convención estricta: punto seguido de dígito.
-        if (current < input.length() && input[current] == '.') {
+        if (current + 1 < input.length() && input[current] == '.' && isdigit(input[current + 1])) {
             // Marcamos como flotante. Asumimos que FLOAT_LIT cubre Float y Double.
             is_float = true; 
             type = Token::FLOAT_LIT; 
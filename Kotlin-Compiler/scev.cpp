@@ -0,0 +1,634 @@
+#include "passes.h"
+#include "semantic_types.h"
+#include <climits>
+#include <map>
+
+using namespace std;
+
+// ===========================================================
+//   Forma cerrada de las variables de inducción
+// ===========================================================
+//
+// Un while/for cuyo cuerpo solo acumula en locales (`s = s + i`,
+// `t = t + k * i`, `u = u + t`...) se reemplaza por el valor final de cada
+// una. Cada valor se describe como una cadena de recurrencias: en la vuelta
+// k vale Σ c_j · C(k, j), con los c_j polinomios en valores que el bucle no
+// cambia. Una variable que se suma algo ya descrito gana un término, porque
+// x_k = x_0 + Σ_{t<k} d(t) y Σ_{t<k} C(t, j) = C(k, j + 1).
+//
+// Todo es suma y producto módulo 2^n, así que el resultado coincide con el
+// del bucle aunque las variables desborden. Los C(n, j) van en ULong:
+// C(n, 2) = (n / 2) * (n - 1 + n % 2) es exacto módulo 2^64; para j > 2 el
+// producto n(n-1)..(n-j+1) se divide por la potencia de 2 de j! y se
+// multiplica por el inverso de su parte impar, exacto en los 64 - T bits
+// bajos: por eso esos grados solo con variables de hasta 32 bits.
+//
+// Si el último valor del contador está a menos de un paso del máximo, el
+// siguiente desborda y el bucle sigue dando vueltas (con paso 1 para siempre,
+// con otros hasta caer pasado el límite). Con inicio y límite constantes eso
+// se ve en compilación y el bucle queda como está; con un límite variable
+// la forma cerrada va detrás de `b <= MAX - paso` y el bucle original queda
+// en el else.
+
+// Monomio: producto de átomos (índices en Analisis::atomos, ordenados)
+using Monomio = vector<int>;
+// Polinomio con coeficientes módulo 2^64
+using Polinomio = map<Monomio, unsigned long long>;
+// Cadena de recurrencias: en la vuelta k vale Σ_j c[j] · C(k, j)
+using Cadena = vector<Polinomio>;
+
+// Términos de una cadena (grado en k + 1) y monomios por coeficiente
+static const size_t TERMINOS_32 = 6;
+static const size_t TERMINOS_64 = 3;
+static const size_t MONOMIOS = 16;
+
+static bool esEntero(Type* t) {
+    return t && t->isNumeric() && t->ttype != Type::FLOAT && t->ttype != Type::DOUBLE;
+}
+
+// C(m, i) exacto para los m chicos de un producto de cadenas
+static unsigned long long combinaciones(size_t m, size_t i) {
+    unsigned long long c = 1;
+    for (size_t t = 1; t <= i; ++t) c = c * (m - i + t) / t;
+    return c;
+}
+
+static void recortar(Cadena& c) {
+    while (!c.empty() && c.back().empty()) c.pop_back();
+}
+
+static Cadena constante(unsigned long long v) {
+    Cadena c(1);
+    if (v) c[0][{}] = v;
+    recortar(c);
+    return c;
+}
+
+static void acumular(Polinomio& a, const Monomio& m, unsigned long long c) {
+    unsigned long long& x = a[m];
+    x += c;
+    if (!x) a.erase(m);
+}
+
+static Cadena suma(const Cadena& a, const Cadena& b, unsigned long long factor) {
+    Cadena r = a;
+    if (r.size() < b.size()) r.resize(b.size());
+    for (size_t j = 0; j < b.size(); ++j)
+        for (auto& [m, c] : b[j]) acumular(r[j], m, c * factor);
+    recortar(r);
+    return r;
+}
+
+static Polinomio producto(const Polinomio& a, const Polinomio& b) {
+    Polinomio r;
+    for (auto& [ma, ca] : a) {
+        for (auto& [mb, cb] : b) {
+            Monomio m = ma;
+            m.insert(m.end(), mb.begin(), mb.end());
+            sort(m.begin(), m.end());
+            acumular(r, m, ca * cb);
+        }
+    }
+    return r;
+}
+
+// C(k, i) · C(k, j) = Σ_m C(m, i) · C(i, m - j) · C(k, m), con max(i, j) <= m <= i + j
+static bool producto(const Cadena& a, const Cadena& b, Cadena& r) {
+    r.clear();
+    if (a.empty() || b.empty()) return true;
+    r.resize(a.size() + b.size() - 1);
+    for (size_t i = 0; i < a.size(); ++i) {
+        for (size_t j = 0; j < b.size(); ++j) {
+            if (a[i].empty() || b[j].empty()) continue;
+            Polinomio p = producto(a[i], b[j]);
+            for (size_t m = max(i, j); m <= i + j; ++m) {
+                unsigned long long k = combinaciones(m, i) * combinaciones(i, m - j);
+                for (auto& [mono, c] : p) acumular(r[m], mono, c * k);
+            }
+        }
+    }
+    recortar(r);
+    if (r.size() > TERMINOS_32) return false;
+    for (auto& p : r)
+        if (p.size() > MONOMIOS) return false;
+    return true;
+}
+
+// Lo que se sabe del cuerpo mientras se recorre
+struct Analisis {
+    int tam = 0;                            // Ancho común de lo que se acumula
+    vector<Symbol*> atomos;                 // Valores que el bucle no cambia (y los de entrada)
+    unordered_map<Symbol*, int> indices;
+    vector<Symbol*> acumuladas;             // Locales de afuera que el cuerpo asigna
+    unordered_map<Symbol*, Cadena> valores; // Valor actual de lo asignado o declarado en el cuerpo
+    Symbol* contador = nullptr;             // Contador del for
+    Cadena evolucionContador;
+
+    int indice(Symbol* s) {
+        auto it = indices.find(s);
+        if (it != indices.end()) return it->second;
+        atomos.push_back(s);
+        return indices[s] = static_cast<int>(atomos.size() - 1);
+    }
+    Cadena atomo(Symbol* s) {
+        Cadena c(1);
+        c[0][{indice(s)}] = 1;
+        return c;
+    }
+    bool acumulada(int i) const {
+        return find(acumuladas.begin(), acumuladas.end(), atomos[i]) != acumuladas.end();
+    }
+};
+
+// Solo sumas, restas y productos del ancho común: lo demás puede atrapar,
+// tener efectos o cambiar de ancho (y entonces no es un polinomio módulo 2^n)
+static bool evaluar(Exp* e, Type* tipo, Analisis& a, Cadena& r) {
+    long long v;
+    if (constantBits(e, tipo, v)) {
+        r = constante(static_cast<unsigned long long>(v));
+        return true;
+    }
+    Type* t = e->inferredType;
+    if (!esEntero(t) || getTypeSize(t) != a.tam) return false;
+    switch (e->kind) {
+        case NODE_ID: {
+            Symbol* s = static_cast<IdExp*>(e)->sym;
+            if (!s || !esEntero(s->tipo) || getTypeSize(s->tipo) != a.tam) return false;
+            auto it = a.valores.find(s);
+            if (it != a.valores.end()) r = it->second;
+            else if (s == a.contador) r = a.evolucionContador;
+            else r = a.atomo(s);
+            return true;
+        }
+        case NODE_BINARY: {
+            BinaryExp* b = static_cast<BinaryExp*>(e);
+            if (b->op != PLUS_OP && b->op != MINUS_OP && b->op != MUL_OP) return false;
+            Cadena x, y;
+            if (!evaluar(b->left, t, a, x) || !evaluar(b->right, t, a, y)) return false;
+            if (b->op == MUL_OP) return producto(x, y, r);
+            r = suma(x, y, b->op == MINUS_OP ? ~0ull : 1);
+            return true;
+        }
+        default:
+            return false;
+    }
+}
+
+// El cuerpo: solo declaraciones y asignaciones de enteros del mismo ancho
+static bool recorrer(Block* cuerpo, Analisis& a) {
+    unordered_set<Symbol*> propias;
+    for (Stm* s : cuerpo->stmts) {
+        if (s->kind == NODE_VARDEC) {
+            propias.insert(static_cast<VarDec*>(s)->sym);
+            continue;
+        }
+        if (s->kind != NODE_ASSIGN) return false;
+        Symbol* sym = static_cast<AssignExp*>(s)->sym;
+        if (propias.count(sym) || a.valores.count(sym)) continue;
+        if (!sym || sym->global || !esEntero(sym->tipo) || sym == a.contador) return false;
+        if (!a.tam) a.tam = getTypeSize(sym->tipo);
+        if (getTypeSize(sym->tipo) != a.tam) return false;
+        a.acumuladas.push_back(sym);
+        a.valores[sym] = a.atomo(sym); // Lo que vale al empezar la vuelta
+    }
+    if (a.acumuladas.empty()) return false;
+
+    for (Stm* s : cuerpo->stmts) {
+        Cadena c;
+        if (s->kind == NODE_VARDEC) {
+            VarDec* d = static_cast<VarDec*>(s);
+            if (!d->init || !d->sym || !esEntero(d->sym->tipo) || getTypeSize(d->sym->tipo) != a.tam) return false;
+            if (!evaluar(d->init, d->sym->tipo, a, c)) return false;
+            a.valores[d->sym] = c;
+        } else {
+            AssignExp* as = static_cast<AssignExp*>(s);
+            if (!evaluar(as->e, as->sym->tipo, a, c)) return false;
+            a.valores[as->sym] = c;
+        }
+    }
+    return true;
+}
+
+// Reemplaza en `d` el valor al empezar la vuelta de cada acumulada por su cadena
+static bool sustituir(const Cadena& d, const unordered_map<Symbol*, Cadena>& cadenas, Analisis& a, Cadena& r) {
+    r.clear();
+    for (size_t j = 0; j < d.size(); ++j) {
+        for (auto& [m, c] : d[j]) {
+            Cadena termino(j + 1);
+            termino[j][{}] = c;
+            for (int i : m) {
+                Cadena factor;
+                if (a.acumulada(i)) {
+                    factor = cadenas.at(a.atomos[i]);
+                } else {
+                    factor = Cadena(1);
+                    factor[0][{i}] = 1;
+                }
+                Cadena t;
+                if (!producto(termino, factor, t)) return false;
+                termino = t;
+            }
+            r = suma(r, termino, 1);
+        }
+    }
+    return true;
+}
+
+// Cadena de cada acumulada en función de los valores al entrar al bucle:
+// el cuerpo debe dejarla en `x + d`, con `d` sin `x`
+static bool resolver(Analisis& a, unordered_map<Symbol*, Cadena>& cadenas) {
+    unordered_map<Symbol*, Cadena> incrementos;
+    unordered_map<Symbol*, vector<Symbol*>> dependencias;
+    for (Symbol* x : a.acumuladas) {
+        Cadena d = a.valores[x];
+        int ix = a.indice(x);
+        if (d.empty()) return false;
+        auto it = d[0].find({ix});
+        if (it == d[0].end() || it->second != 1) return false;
+        d[0].erase(it);
+        recortar(d);
+        for (auto& p : d) {
+            for (auto& [m, c] : p) {
+                for (int i : m) {
+                    if (i == ix) return false; // x * algo: no es una suma
+                    if (a.acumulada(i)) dependencias[x].push_back(a.atomos[i]);
+                }
+            }
+        }
+        incrementos[x] = d;
+    }
+
+    size_t limite = a.tam == 8 ? TERMINOS_64 : TERMINOS_32;
+    bool avance = true;
+    while (cadenas.size() < a.acumuladas.size() && avance) {
+        avance = false;
+        for (Symbol* x : a.acumuladas) {
+            if (cadenas.count(x)) continue;
+            bool listas = true;
+            for (Symbol* y : dependencias[x]) listas &= cadenas.count(y) > 0;
+            if (!listas) continue;
+            Cadena d;
+            if (!sustituir(incrementos[x], cadenas, a, d)) return false;
+            Cadena c = a.atomo(x);
+            c.insert(c.end(), d.begin(), d.end());
+            recortar(c);
+            if (c.size() > limite) return false;
+            cadenas[x] = c;
+            avance = true;
+        }
+    }
+    return cadenas.size() == a.acumuladas.size(); // Si no, dependen en ciclo
+}
+
+// ---------- Coeficientes binomiales ----------
+
+// j! = 2^T · impar
+static void factorialPartido(int j, int& T, unsigned long long& impar) {
+    unsigned long long f = 1;
+    for (int t = 2; t <= j; ++t) f *= t;
+    T = __builtin_ctzll(f);
+    impar = f >> T;
+}
+
+// Inverso de un impar módulo 2^64 (Newton: cada paso duplica los bits correctos)
+static unsigned long long inverso(unsigned long long impar) {
+    unsigned long long x = impar;
+    for (int i = 0; i < 5; ++i) x *= 2 - impar * x;
+    return x;
+}
+
+// C(n, j) módulo 2^64 (2^(64-T) para j > 2), con la misma fórmula que se emite
+static unsigned long long binomial(unsigned long long n, int j) {
+    if (j == 0) return 1;
+    if (j == 1) return n;
+    if (j == 2) return (n / 2) * (n - 1 + n % 2);
+    unsigned long long p = 1;
+    for (int t = 0; t < j; ++t) p *= n - t;
+    int T;
+    unsigned long long impar;
+    factorialPartido(j, T, impar);
+    return (p >> T) * inverso(impar);
+}
+
+static Exp* convertir(Exp* e, Type* tipo) {
+    static const unordered_map<int, string> nombres = {
+        {Type::BYTE, "toByte"}, {Type::SHORT, "toShort"}, {Type::INT, "toInt"}, {Type::LONG, "toLong"},
+        {Type::UBYTE, "toUByte"}, {Type::USHORT, "toUShort"}, {Type::UINT, "toUInt"}, {Type::ULONG, "toULong"}};
+    if (e->inferredType == tipo) return e;
+    FcallExp* c = new FcallExp(nombres.at(tipo->ttype), {}, e);
+    c->inferredType = tipo;
+    return c;
+}
+
+static AssignExp* asignacion(Symbol* s, Exp* e) {
+    AssignExp* a = new AssignExp(s->nombre, e);
+    a->sym = s;
+    a->inferredType = s->tipo;
+    return a;
+}
+
+// Un polinomio como expresión de `tipo`; `atomos` da la variable de cada índice
+static Exp* expresion(const Polinomio& p, const vector<Symbol*>& atomos, Type* tipo) {
+    int bits = getTypeSize(tipo) * 8;
+    Exp* r = nullptr;
+    for (auto& [m, c] : p) {
+        // El coeficiente con signo en el ancho del tipo: los negativos restan
+        long long v = bits == 64 ? static_cast<long long>(c) : (static_cast<long long>(c << (64 - bits)) >> (64 - bits));
+        bool resta = v < 0;
+        unsigned long long magnitud = resta ? -static_cast<unsigned long long>(v) : static_cast<unsigned long long>(v);
+        Exp* termino = nullptr;
+        for (int i : m) {
+            Exp* f = lecturaDe(atomos[i]);
+            termino = termino ? operacionTipada(termino, f, MUL_OP, tipo) : f;
+        }
+        if (!termino) termino = constanteDe(static_cast<long long>(magnitud), tipo);
+        else if (magnitud != 1) termino = operacionTipada(constanteDe(static_cast<long long>(magnitud), tipo), termino, MUL_OP, tipo);
+        if (!r) r = resta ? operacionTipada(constanteDe(0, tipo), termino, MINUS_OP, tipo) : termino;
+        else r = operacionTipada(r, termino, resta ? MINUS_OP : PLUS_OP, tipo);
+    }
+    return r ? r : constanteDe(0, tipo);
+}
+
+// ---------- El pase ----------
+
+// Primer valor del contador o límite: constante o una local
+struct Extremo {
+    bool constante = false;
+    long long valor = 0;
+    Symbol* sym = nullptr;
+    Exp* leer(Type* tipo) const { return constante ? constanteDe(valor, tipo) : lecturaDe(sym); }
+};
+
+bool ScalarEvolutionPass::cerrar(Stm* bucle, list<Stm*>& destino, list<Stm*>::iterator donde) {
+    Analisis a;
+    Block* cuerpo;
+    Type* tipoContador;
+    Symbol* contador;         // El contador del for o la acumulada que decide el while
+    Extremo desde, hasta;     // Primer valor del contador y el límite
+    Exp* limiteWhile = nullptr;
+    long long paso;           // Lo que avanza por vuelta (positivo)
+    bool descendente, estricto = false;
+    RangoFor r;
+
+    if (bucle->kind == NODE_FOR) {
+        ForStmt* s = static_cast<ForStmt*>(bucle);
+        r = rangoDe(s);
+        contador = s->varSym;
+        tipoContador = contador->tipo;
+        cuerpo = s->block;
+        paso = 1;
+        if (!r.rango || (r.paso && !constantBits(r.paso, tipoContador, paso))) return false;
+        if (getTypeSize(tipoContador) == 4) paso = static_cast<int32_t>(paso);
+        if (paso <= 0) return false;
+        descendente = r.descendente;
+        desde.constante = constantBits(r.inicio, tipoContador, desde.valor);
+        hasta.constante = constantBits(r.limite, tipoContador, hasta.valor);
+
+        // El contador vale `desde ± k * paso`; su átomo es el primer valor. Lo
+        // acumulado fija el ancho: el cuerpo solo lee el contador si coincide
+        a.contador = contador;
+        a.evolucionContador = desde.constante ? constante(static_cast<unsigned long long>(desde.valor)) : a.atomo(contador);
+        a.evolucionContador.resize(2);
+        a.evolucionContador[1][{}] = descendente ? -static_cast<unsigned long long>(paso) : static_cast<unsigned long long>(paso);
+        recortar(a.evolucionContador);
+        if (!recorrer(cuerpo, a)) return false;
+    } else {
+        WhileStmt* w = static_cast<WhileStmt*>(bucle);
+        cuerpo = w->block;
+        if (w->condition->kind != NODE_BINARY) return false;
+        BinaryExp* c = static_cast<BinaryExp*>(w->condition);
+        BinaryOp op = c->op;
+        if (op != LT_OP && op != LE_OP && op != GT_OP && op != GE_OP) return false;
+        if (!recorrer(cuerpo, a)) return false;
+        // `n >= i` es `i <= n`
+        Exp* izquierdo = c->left;
+        Exp* derecho = c->right;
+        auto esAcumulada = [&](Exp* e) {
+            return e->kind == NODE_ID && find(a.acumuladas.begin(), a.acumuladas.end(), static_cast<IdExp*>(e)->sym) != a.acumuladas.end();
+        };
+        if (!esAcumulada(izquierdo)) {
+            swap(izquierdo, derecho);
+            op = op == LT_OP ? GT_OP : op == LE_OP ? GE_OP : op == GT_OP ? LT_OP : LE_OP;
+        }
+        if (!esAcumulada(izquierdo)) return false;
+        contador = static_cast<IdExp*>(izquierdo)->sym;
+        tipoContador = contador->tipo;
+        if (tipoContador->ttype != Type::INT && tipoContador->ttype != Type::LONG) return false;
+        // Con el límite de otro tipo se compararía en otro ancho o sin signo
+        if (!derecho->inferredType || derecho->inferredType->ttype != tipoContador->ttype) return false;
+        descendente = op == GT_OP || op == GE_OP;
+        estricto = op == LT_OP || op == GT_OP;
+        desde.sym = contador; // Su valor al entrar
+        limiteWhile = derecho;
+    }
+
+    unordered_map<Symbol*, Cadena> cadenas;
+    if (!resolver(a, cadenas)) return false;
+
+    if (limiteWhile) {
+        // El contador del while: `i = i ± paso` con paso constante
+        const Cadena& ci = cadenas[contador];
+        if (ci.size() != 2 || ci[1].size() != 1 || !ci[1].count({})) return false;
+        long long v = static_cast<long long>(ci[1].at({}));
+        if (a.tam == 4) v = static_cast<int32_t>(v);
+        if (v == 0 || (v < 0) != descendente) return false;
+        paso = v < 0 ? -v : v;
+        // El límite: sin nada que cambie el cuerpo (se evalúa una vez, antes)
+        Analisis sinCuerpo;
+        sinCuerpo.tam = a.tam;
+        Cadena l;
+        if (!evaluar(limiteWhile, tipoContador, sinCuerpo, l) || l.size() > 1) return false;
+        for (Symbol* x : sinCuerpo.atomos)
+            if (find(a.acumuladas.begin(), a.acumuladas.end(), x) != a.acumuladas.end()) return false;
+        if (l.empty() || (l[0].size() == 1 && l[0].count({}))) {
+            hasta.constante = true;
+            hasta.valor = l.empty() ? 0 : static_cast<long long>(l[0].at({}));
+            if (a.tam == 4) hasta.valor = static_cast<int32_t>(hasta.valor);
+        } else {
+            limiteWhile = expresion(l[0], sinCuerpo.atomos, tipoContador);
+        }
+    }
+
+    // Si el último valor del contador pasa de `ultimo` el siguiente desborda.
+    // Con un límite dentro de `borde` no puede pasar; si no, queda el bucle
+    bool ancho = getTypeSize(tipoContador) == 8;
+    long long maximo = ancho ? LLONG_MAX : INT_MAX;
+    long long minimo = ancho ? LLONG_MIN : INT_MIN;
+    long long ultimo = descendente ? minimo + paso : maximo - paso;
+    long long borde = ultimo + (estricto ? (descendente ? -1 : 1) : 0);
+    bool guarda = !hasta.constante;
+    if (hasta.constante && !desde.constante && (descendente ? hasta.valor < borde : hasta.valor > borde)) return false;
+
+    // Vueltas: 0 si no entra; si no, distancia / paso + 1 (la distancia cabe sin signo)
+    bool vueltasConstantes = desde.constante && hasta.constante;
+    unsigned long long n = 0;
+    if (vueltasConstantes) {
+        bool entra = estricto ? (descendente ? desde.valor > hasta.valor : desde.valor < hasta.valor)
+                              : (descendente ? desde.valor >= hasta.valor : desde.valor <= hasta.valor);
+        if (entra) {
+            unsigned long long d = descendente ? static_cast<unsigned long long>(desde.valor) - static_cast<unsigned long long>(hasta.valor)
+                                               : static_cast<unsigned long long>(hasta.valor) - static_cast<unsigned long long>(desde.valor);
+            if (estricto) --d;
+            unsigned long long q = d / static_cast<unsigned long long>(paso);
+            long long fin = static_cast<long long>(static_cast<unsigned long long>(desde.valor) +
+                (descendente ? -(q * paso) : q * paso));
+            if (descendente ? fin < ultimo : fin > ultimo) return false;
+            n = q + 1;
+        }
+        guarda = false;
+    }
+
+    // ---- Desde aquí el bucle se reemplaza ----
+    Type* ulong = tipos->get(Type::ULONG);
+    Type* tipoBool = tipos->get(Type::BOOL);
+    string base = contador->nombre + ".";
+    if (bucle->kind == NODE_FOR) {
+        // Inicio y límite una vez, en el orden del for; el for de respaldo los lee
+        if (!desde.constante) {
+            VarDec* d = declaracionOculta(programa, base + "desde", r.inicio, tipoContador);
+            destino.insert(donde, d);
+            desde.sym = d->sym;
+            r.rango->left = lecturaDe(d->sym);
+        }
+        if (!hasta.constante) {
+            VarDec* d = declaracionOculta(programa, base + "hasta", r.limite, tipoContador);
+            destino.insert(donde, d);
+            hasta.sym = d->sym;
+            r.rango->right = lecturaDe(d->sym);
+        }
+    } else if (!hasta.constante) {
+        VarDec* d = declaracionOculta(programa, base + "hasta", limiteWhile, tipoContador);
+        destino.insert(donde, d);
+        hasta.sym = d->sym;
+    }
+
+    // Átomos como expresiones: el del contador del for es su primer valor
+    vector<Symbol*> atomos = a.atomos;
+    for (auto& x : atomos)
+        if (x == a.contador) x = desde.sym;
+
+    Block* calculo = new Block();
+    size_t terminos = 0;
+    for (auto& [x, c] : cadenas) terminos = max(terminos, c.size());
+
+    vector<Symbol*> binomiales; // C(n, j) en ULong
+    vector<unsigned long long> binomialesConstantes;
+    if (vueltasConstantes) {
+        for (size_t j = 0; j < terminos; ++j) binomialesConstantes.push_back(binomial(n, static_cast<int>(j)));
+    } else {
+        Exp* entra = operacionTipada(desde.leer(tipoContador), hasta.leer(tipoContador),
+            estricto ? (descendente ? GT_OP : LT_OP) : (descendente ? GE_OP : LE_OP), tipoBool);
+        Exp* distancia = descendente ? operacionTipada(desde.leer(tipoContador), hasta.leer(tipoContador), MINUS_OP, tipoContador)
+                                     : operacionTipada(hasta.leer(tipoContador), desde.leer(tipoContador), MINUS_OP, tipoContador);
+        if (estricto) distancia = operacionTipada(distancia, constanteDe(1, tipoContador), MINUS_OP, tipoContador);
+        Type* sinSigno = tipos->get(ancho ? Type::ULONG : Type::UINT);
+        distancia = convertir(distancia, sinSigno);
+        if (paso != 1) distancia = operacionTipada(distancia, constanteDe(paso, sinSigno), DIV_OP, sinSigno);
+        Exp* cuenta = operacionTipada(convertir(distancia, ulong), constanteDe(1, ulong), PLUS_OP, ulong);
+        VarDec* vueltas = declaracionOculta(programa, base + "vueltas", constanteDe(0, ulong), ulong);
+        Block* siEntra = new Block();
+        siEntra->stmts.push_back(asignacion(vueltas->sym, cuenta));
+        calculo->stmts.push_back(vueltas);
+        calculo->stmts.push_back(new IfStmt(entra, siEntra, nullptr));
+
+        auto leerN = [&]() { return lecturaDe(vueltas->sym); };
+        binomiales = {nullptr, vueltas->sym};
+        for (size_t j = 2; j < terminos; ++j) {
+            Exp* e;
+            if (j == 2) {
+                // (n / 2) * (n - 1 + n % 2)
+                Exp* mitad = operacionTipada(leerN(), constanteDe(2, ulong), DIV_OP, ulong);
+                Exp* impar = operacionTipada(operacionTipada(leerN(), constanteDe(1, ulong), MINUS_OP, ulong),
+                                             operacionTipada(leerN(), constanteDe(2, ulong), MOD_OP, ulong), PLUS_OP, ulong);
+                e = operacionTipada(mitad, impar, MUL_OP, ulong);
+            } else {
+                e = leerN();
+                for (size_t t = 1; t < j; ++t)
+                    e = operacionTipada(e, operacionTipada(leerN(), constanteDe(static_cast<long long>(t), ulong), MINUS_OP, ulong), MUL_OP, ulong);
+                int T;
+                unsigned long long impar;
+                factorialPartido(static_cast<int>(j), T, impar);
+                e = operacionTipada(e, constanteDe(1LL << T, ulong), DIV_OP, ulong);
+                e = operacionTipada(e, constanteDe(static_cast<long long>(inverso(impar)), ulong), MUL_OP, ulong);
+            }
+            VarDec* d = declaracionOculta(programa, base + "c" + to_string(j), e, ulong);
+            calculo->stmts.push_back(d);
+            binomiales.push_back(d->sym);
+        }
+    }
+
+    // x = Σ c_j · C(n, j), todo en el tipo de x; primero a locales nuevas
+    // porque cada fórmula lee los valores de entrada de las demás
+    vector<pair<Symbol*, Symbol*>> finales;
+    for (Symbol* x : a.acumuladas) {
+        const Cadena& c = cadenas[x];
+        Type* tipo = x->tipo;
+        Exp* valor = nullptr;
+        for (size_t j = 0; j < c.size(); ++j) {
+            if (c[j].empty()) continue;
+            Exp* termino = expresion(c[j], atomos, tipo);
+            if (j > 0) {
+                Exp* b = vueltasConstantes ? constanteDe(static_cast<long long>(binomialesConstantes[j]), tipo)
+                                           : convertir(lecturaDe(binomiales[j]), tipo);
+                termino = operacionTipada(termino, b, MUL_OP, tipo);
+            }
+            valor = valor ? operacionTipada(valor, termino, PLUS_OP, tipo) : termino;
+        }
+        if (!valor) valor = constanteDe(0, tipo);
+        VarDec* d = declaracionOculta(programa, x->nombre + ".final", valor, tipo);
+        calculo->stmts.push_back(d);
+        finales.push_back({x, d->sym});
+    }
+    for (auto& [x, f] : finales) calculo->stmts.push_back(asignacion(x, lecturaDe(f)));
+
+    if (!guarda) {
+        destino.insert(donde, calculo);
+        return true;
+    }
+    Exp* condicion = operacionTipada(hasta.leer(tipoContador), constanteDe(borde, tipoContador),
+                                     descendente ? GE_OP : LE_OP, tipoBool);
+    Block* respaldo = new Block();
+    respaldo->stmts.push_back(bucle);
+    conservados.insert(bucle);
+    destino.insert(donde, new IfStmt(condicion, calculo, respaldo));
+    return true;
+}
+
+bool ScalarEvolutionPass::bloque(Block* b) {
+    bool cambio = false;
+    for (auto it = b->stmts.begin(); it != b->stmts.end();) {
+        Stm* s = *it;
+        cambio |= sentencia(s);
+        if ((s->kind != NODE_FOR && s->kind != NODE_WHILE) || conservados.count(s) || !cerrar(s, b->stmts, it)) {
+            ++it;
+            continue;
+        }
+        cambio = true;
+        it = b->stmts.erase(it);
+        if (!conservados.count(s)) delete s;
+    }
+    return cambio;
+}
+
+bool ScalarEvolutionPass::sentencia(Stm* s) {
+    switch (s->kind) {
+        case NODE_BLOCK: return bloque(static_cast<Block*>(s));
+        case NODE_IF: {
+            IfStmt* i = static_cast<IfStmt*>(s);
+            bool cambio = bloque(i->thenBlock);
+            if (i->elseBlock) cambio |= bloque(i->elseBlock);
+            return cambio;
+        }
+        case NODE_WHILE: return bloque(static_cast<WhileStmt*>(s)->block);
+        case NODE_FOR:   return bloque(static_cast<ForStmt*>(s)->block);
+        default:         return false;
+    }
+}
+
+bool ScalarEvolutionPass::run(Program* p, PassManager& pm) {
+    if (!tipos) return false;
+    programa = p;
+    bool cambio = false;
+    for (auto fd : p->fdlist) cambio |= bloque(fd->cuerpo);
+    return cambio;
+}
@@ -65,6 +65,41 @@ public:
 
 };
 
+// Bytes que ocupa un valor del tipo en memoria (marco de pila, cargas y stores)
+inline int getTypeSize(Type* t) {
+    if (!t) return 8; // Por defecto 64 bits si se desconoce
+    if (t->ttype == Type::BYTE || t->ttype == Type::UBYTE) return 1;
+    if (t->ttype == Type::SHORT || t->ttype == Type::USHORT) return 2;
+
+    if (t->ttype == Type::INT || t->ttype == Type::UINT) return 4;
+    if (t->ttype == Type::FLOAT) return 4;
+    if (t->ttype == Type::DOUBLE) return 8;
+    if (t->ttype == Type::LONG || t->ttype == Type::ULONG) return 8;
+    if (t->ttype == Type::BOOL) return 1; // Bool as byte
+    return 8; // Valor por defecto
+}
+
+// Una instancia canónica por TType. Los tipos son inmutables, así que todos
+// los nodos de una compilación comparten estas instancias (y se liberan con
+// la tabla, sin `new Type` sueltos).
+class TypeTable {
+private:
+    Type tipos[15];
+public:
+    TypeTable() {
+        for (int i = 0; i < 15; ++i) tipos[i].ttype = static_cast<Type::TType>(i);
+    }
+    TypeTable(const TypeTable&) = delete;
+    TypeTable& operator=(const TypeTable&) = delete;
+
+    Type* get(Type::TType tt) { return &tipos[tt]; }
+    // nullptr si el nombre no es un tipo básico
+    Type* fromName(const string& s) {
+        Type::TType tt = Type::string_to_type(s);
+        return tt == Type::NOTYPE ? nullptr : &tipos[tt];
+    }
+};
+
 inline const char* Type::type_names[15] = { "notype", "void", "Int", "bool", "string", "range", "byte", "short", "long", "float", "double", "ubyte", "ushort", "uint", "ulong" };
 
 #endif // SEMANTIC_TYPES_H
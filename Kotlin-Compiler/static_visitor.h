@@ -0,0 +1,45 @@
+#ifndef STATIC_VISITOR_H
+#define STATIC_VISITOR_H
+
+#include "ast.h"
+
+// ===========================================================
+//  Visitante con despacho estático (CRTP)
+// ===========================================================
+//
+// `accept` + `visit` cuesta dos llamadas indirectas por nodo. Aquí el
+// despacho es un switch sobre Stm::kind que llama directamente a
+// Derived::visit; si Derived es `final`, el compilador puede incluir en
+// línea cada visit. Uso:
+//
+//   class MiVisitor final : public StaticVisitor<MiVisitor, int> { ... };
+//   dispatch(nodo);   // en lugar de nodo->accept(this)
+
+template <class Derived, class R>
+class StaticVisitor {
+public:
+    R dispatch(Stm* s) {
+        Derived* self = static_cast<Derived*>(this);
+        switch (s->kind) {
+            case NODE_BINARY: return self->visit(static_cast<BinaryExp*>(s));
+            case NODE_NUMBER: return self->visit(static_cast<NumberExp*>(s));
+            case NODE_DOUBLE: return self->visit(static_cast<DoubleExp*>(s));
+            case NODE_LONG:   return self->visit(static_cast<LongExp*>(s));
+            case NODE_BOOL:   return self->visit(static_cast<BoolExp*>(s));
+            case NODE_STRING: return self->visit(static_cast<StringExp*>(s));
+            case NODE_ID:     return self->visit(static_cast<IdExp*>(s));
+            case NODE_ASSIGN: return self->visit(static_cast<AssignExp*>(s));
+            case NODE_FCALL:  return self->visit(static_cast<FcallExp*>(s));
+            case NODE_VARDEC: return self->visit(static_cast<VarDec*>(s));
+            case NODE_BLOCK:  return self->visit(static_cast<Block*>(s));
+            case NODE_IF:     return self->visit(static_cast<IfStmt*>(s));
+            case NODE_WHILE:  return self->visit(static_cast<WhileStmt*>(s));
+            case NODE_FOR:    return self->visit(static_cast<ForStmt*>(s));
+            case NODE_PRINT:  return self->visit(static_cast<PrintStm*>(s));
+            case NODE_RETURN: return self->visit(static_cast<ReturnStm*>(s));
+        }
+        return R();
+    }
+};
+
+#endif // STATIC_VISITOR_H
@@ -0,0 +1,198 @@
+#include "typecache.h"
+#include "static_visitor.h"
+
+using namespace std;
+
+// Cambiar si cambia el formato, la numeración de Type::TType o lo que
+// anota el TypeChecker
+static const int VERSION_CACHE = 2;
+static const int NUM_TIPOS = 15;
+
+static bool tipoValido(int t) { return t >= -1 && t < NUM_TIPOS; }
+
+// ===========================================================
+//   Entradas
+// ===========================================================
+
+const EntradaCacheTipos* CacheTipos::buscar(const string& nombre, uint64_t huella) const {
+    auto it = entradas.find(nombre);
+    if (it == entradas.end() || it->second.huella != huella) return nullptr;
+    return &it->second;
+}
+
+void CacheTipos::actualizar(const vector<FunDec*>& funciones, vector<unique_ptr<EntradaCacheTipos>>& nuevas) {
+    for (size_t i = 0; i < funciones.size(); ++i)
+        if (nuevas[i]) entradas[funciones[i]->nombre] = move(*nuevas[i]);
+
+    // Sobran entradas solo si se renombró o borró alguna función
+    if (entradas.size() <= funciones.size()) return;
+    unordered_map<string, EntradaCacheTipos> siguiente;
+    siguiente.reserve(funciones.size());
+    for (auto f : funciones) {
+        auto it = entradas.find(f->nombre);
+        if (it != entradas.end()) siguiente[f->nombre] = move(it->second);
+    }
+    entradas = move(siguiente);
+}
+
+// ===========================================================
+//   Archivo
+// ===========================================================
+//
+//   cache-tipos <versión> <entradas>
+//   <nombre> <huella> <retorno> <deps> <anotaciones> <largo> <error>
+//   <G|F> <nombre> <tipo> <retornoPropio>      (una línea por dependencia)
+//   <anotaciones separadas por espacios>
+
+void CacheTipos::guardar(ostream& out) const {
+    out << "cache-tipos " << VERSION_CACHE << ' ' << entradas.size() << '\n';
+    for (auto& par : entradas) {
+        const EntradaCacheTipos& e = par.second;
+        out << par.first << ' ' << e.huella << ' ' << e.retorno << ' ' << e.deps.size() << ' '
+            << e.anotaciones.size() << ' ' << e.error.size() << ' ' << e.error << '\n';
+        for (auto& d : e.deps)
+            out << (d.clase == DependenciaTipos::GLOBAL ? 'G' : 'F') << ' ' << d.nombre << ' '
+                << d.tipo << ' ' << d.retornoPropio << '\n';
+        for (size_t i = 0; i < e.anotaciones.size(); ++i)
+            out << (i ? " " : "") << e.anotaciones[i];
+        out << '\n';
+    }
+}
+
+bool CacheTipos::cargar(istream& in) {
+    entradas.clear();
+    string magia;
+    int version;
+    size_t n;
+    if (!(in >> magia >> version >> n) || magia != "cache-tipos" || version != VERSION_CACHE)
+        return false;
+
+    for (size_t k = 0; k < n; ++k) {
+        string nombre;
+        EntradaCacheTipos e;
+        size_t numDeps, numAnotaciones, largo;
+        if (!(in >> nombre >> e.huella >> e.retorno >> numDeps >> numAnotaciones >> largo) ||
+            !tipoValido(e.retorno) || in.get() != ' ') {
+            entradas.clear();
+            return false;
+        }
+        e.error.resize(largo);
+        in.read(&e.error[0], largo);
+
+        e.deps.resize(numDeps);
+        for (auto& d : e.deps) {
+            char clase;
+            if (!(in >> clase >> d.nombre >> d.tipo >> d.retornoPropio) ||
+                (clase != 'G' && clase != 'F') || d.tipo < DependenciaTipos::FALLIDA || d.tipo >= NUM_TIPOS) {
+                entradas.clear();
+                return false;
+            }
+            d.clase = clase == 'G' ? DependenciaTipos::GLOBAL : DependenciaTipos::FUNCION;
+        }
+
+        e.anotaciones.resize(numAnotaciones);
+        for (auto& a : e.anotaciones) {
+            if (!(in >> a) || !tipoValido(a)) {
+                entradas.clear();
+                return false;
+            }
+        }
+        entradas[nombre] = move(e);
+    }
+    return true;
+}
+
+// ===========================================================
+//   Anotaciones de un cuerpo
+// ===========================================================
+
+namespace {
+
+// Recorre el cuerpo siempre en el mismo orden: al grabar guarda el tipo de
+// cada expresión y variable, al aplicar lo repone y al limpiar lo borra.
+class RecorridoAnotaciones final : public StaticVisitor<RecorridoAnotaciones, void> {
+public:
+    enum Modo { GRABAR, APLICAR, LIMPIAR };
+
+    Modo modo;
+    vector<int>* salida = nullptr;        // GRABAR
+    const vector<int>* entrada = nullptr; // APLICAR
+    TypeTable* tipos = nullptr;           // APLICAR
+    size_t pos = 0;
+    bool fallo = false;
+
+    explicit RecorridoAnotaciones(Modo modo) : modo(modo) {}
+
+    void anotar(Type*& t) {
+        switch (modo) {
+            case GRABAR:
+                salida->push_back(t ? static_cast<int>(t->ttype) : -1);
+                break;
+            case APLICAR: {
+                if (pos >= entrada->size()) { fallo = true; return; }
+                int v = (*entrada)[pos++];
+                t = v < 0 ? nullptr : tipos->get(static_cast<Type::TType>(v));
+                break;
+            }
+            case LIMPIAR:
+                t = nullptr;
+                break;
+        }
+    }
+
+    void visit(BinaryExp* e) { anotar(e->inferredType); dispatch(e->left); dispatch(e->right); }
+    void visit(NumberExp* e) { anotar(e->inferredType); }
+    void visit(DoubleExp* e) { anotar(e->inferredType); }
+    void visit(LongExp* e) { anotar(e->inferredType); }
+    void visit(BoolExp* e) { anotar(e->inferredType); }
+    void visit(StringExp* e) { anotar(e->inferredType); }
+    void visit(IdExp* e) { anotar(e->inferredType); }
+    void visit(AssignExp* e) { anotar(e->inferredType); dispatch(e->e); }
+    void visit(FcallExp* e) {
+        anotar(e->inferredType);
+        if (e->receiver) dispatch(e->receiver);
+        for (auto a : e->argumentos) dispatch(a);
+    }
+    void visit(VarDec* v) {
+        anotar(v->sym->tipo);
+        if (v->init) dispatch(v->init);
+    }
+    void visit(Block* b) {
+        for (auto s : b->stmts) dispatch(s);
+    }
+    void visit(IfStmt* s) {
+        dispatch(s->condition);
+        dispatch(s->thenBlock);
+        if (s->elseBlock) dispatch(s->elseBlock);
+    }
+    void visit(WhileStmt* s) { dispatch(s->condition); dispatch(s->block); }
+    void visit(ForStmt* s) {
+        dispatch(s->rangeExp);
+        anotar(s->varSym->tipo);
+        s->endSym->tipo = s->stepSym->tipo = s->varSym->tipo; // Mismo tipo que el contador
+        dispatch(s->block);
+    }
+    void visit(PrintStm* s) { if (s->e) dispatch(s->e); }
+    void visit(ReturnStm* s) { if (s->e) dispatch(s->e); }
+};
+
+} // namespace
+
+vector<int> grabarAnotaciones(Block* cuerpo) {
+    vector<int> datos;
+    RecorridoAnotaciones r(RecorridoAnotaciones::GRABAR);
+    r.salida = &datos;
+    r.dispatch(cuerpo);
+    return datos;
+}
+
+bool aplicarAnotaciones(Block* cuerpo, const vector<int>& datos, TypeTable& tipos) {
+    RecorridoAnotaciones r(RecorridoAnotaciones::APLICAR);
+    r.entrada = &datos;
+    r.tipos = &tipos;
+    r.dispatch(cuerpo);
+    if (!r.fallo && r.pos == datos.size()) return true;
+    RecorridoAnotaciones limpiar(RecorridoAnotaciones::LIMPIAR);
+    limpiar.dispatch(cuerpo);
+    return false;
+}
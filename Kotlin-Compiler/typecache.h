@@ -0,0 +1,78 @@
+#ifndef TYPECACHE_H
+#define TYPECACHE_H
+
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <ostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "ast.h"
+#include "semantic_types.h"
+
+using namespace std;
+
+// ===========================================================
+//  Caché de revisión de tipos entre compilaciones
+// ===========================================================
+//
+// Guarda, por función, el resultado de revisar su cuerpo junto con todo lo
+// que la revisión consultó fuera de él (el grafo de dependencias). En la
+// siguiente compilación el TypeChecker reutiliza la entrada si la huella de
+// la función (sus tokens, ver Parser) es la misma y cada dependencia sigue
+// teniendo la misma firma; si no, la revisa de nuevo.
+
+// Algo que el cuerpo consultó fuera de sí mismo, en el orden en que ocurrió
+struct DependenciaTipos {
+    enum Clase { GLOBAL, FUNCION };
+    // Valores de `tipo` además de un Type::TType
+    static const int SIN_DECLARAR = -1; // La función no existía
+    static const int FALLIDA = -2;      // Revisar la función lanzó un error
+
+    Clase clase;
+    string nombre;
+    int tipo;                  // Tipo del global o de retorno de la función
+    bool retornoPropio = true; // ¿La función que llama ya tenía tipo de retorno?
+};
+
+struct EntradaCacheTipos {
+    uint64_t huella = 0;
+    int retorno = -1;               // TType de retorno (-1: no se llegó a fijar)
+    string error;                   // Vacío si la función pasó la revisión
+    vector<DependenciaTipos> deps;
+    vector<int> anotaciones;        // Ver grabarAnotaciones (solo sin error)
+};
+
+// Una caché por sesión de edición. La leen a la vez los hilos del
+// TypeChecker, pero no debe compartirse entre compilaciones simultáneas.
+class CacheTipos {
+private:
+    unordered_map<string, EntradaCacheTipos> entradas; // Por nombre de función
+
+public:
+    // nullptr si no hay entrada para esa función con esa huella
+    const EntradaCacheTipos* buscar(const string& nombre, uint64_t huella) const;
+
+    // Guarda el resultado de las funciones revisadas (nuevas[i] no nulo); el
+    // resto conserva su entrada. Descarta las de funciones renombradas o borradas.
+    void actualizar(const vector<FunDec*>& funciones, vector<unique_ptr<EntradaCacheTipos>>& nuevas);
+
+    // Formato de texto propio. cargar() deja la caché vacía si el archivo
+    // no es válido o es de otra versión.
+    bool cargar(istream& in);
+    void guardar(ostream& out) const;
+
+    size_t size() const { return entradas.size(); }
+    void clear() { entradas.clear(); }
+};
+
+// Tipos que dejó el TypeChecker en un cuerpo (inferredType de cada expresión
+// y Symbol::tipo de cada variable), en preorden.
+vector<int> grabarAnotaciones(Block* cuerpo);
+
+// Los vuelve a poner en un cuerpo con la misma huella. Si no calzan deja el
+// cuerpo sin anotar y devuelve false.
+bool aplicarAnotaciones(Block* cuerpo, const vector<int>& datos, TypeTable& tipos);
+
+#endif // TYPECACHE_H
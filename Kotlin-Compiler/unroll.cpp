@@ -0,0 +1,316 @@
+#include "passes.h"
+#include "semantic_types.h"
+#include <climits>
+
+using namespace std;
+
+// ===========================================================
+//   Desenrollado de for con paso constante
+// ===========================================================
+//
+// Solo cuerpos sin bucles anidados y que no asignan el contador. Con inicio,
+// límite y paso constantes y pocas vueltas el for desaparece: una copia del
+// cuerpo por vuelta, con el contador reemplazado por su valor. Si no, el for
+// se parte en
+//
+//     var i.c = inicio; var i.fin = limite
+//     if (i.fin >= MIN + K) {              // K = (copias - 1) * paso
+//         var i.lim = i.fin - K
+//         while (i.c <= i.lim) { cuerpo(i.c); i.c = i.c + paso; ... }
+//     }
+//     for (i in i.c..i.fin step paso) cuerpo(i)   // el for original: el resto
+//
+// Mientras `i.c <= i.lim` las `copias` vueltas siguientes caben antes del
+// límite sin desbordar; el for del final sigue exactamente como lo haría el
+// original, también si el contador desborda.
+
+// Vueltas del for que se desarrollan del todo, y tamaño máximo del resultado
+static const int VUELTAS_COMPLETAS = 16;
+static const int TAMANO_COMPLETO = 160;
+// Tamaño máximo del cuerpo del while con todas sus copias
+static const int TAMANO_PARCIAL = 96;
+
+// Nodos del cuerpo: lo que crece el código con cada copia
+struct Medida {
+    int nodos = 0;
+    bool bucles = false;   // while/for anidados
+    bool llamadas = false; // println o funciones propias: el salto no es lo que pesa
+};
+
+static void medir(Stm* s, Medida& m) {
+    if (!s) return;
+    switch (s->kind) {
+        case NODE_WHILE: case NODE_FOR:
+            m.bucles = true;
+            break;
+        case NODE_BLOCK:
+            for (auto st : static_cast<Block*>(s)->stmts) medir(st, m);
+            break;
+        case NODE_IF: {
+            IfStmt* i = static_cast<IfStmt*>(s);
+            ++m.nodos;
+            forEachExp(i->condition, [&](Exp*) { ++m.nodos; });
+            medir(i->thenBlock, m);
+            medir(i->elseBlock, m);
+            break;
+        }
+        case NODE_PRINT:
+            m.llamadas = true;
+            [[fallthrough]];
+        default:
+            forEachExp(s, [&](Exp* e) {
+                ++m.nodos;
+                if (e->kind == NODE_FCALL && !static_cast<FcallExp*>(e)->receiver) m.llamadas = true;
+            });
+            break;
+    }
+}
+
+static bool asigna(Stm* s, Symbol* sym) {
+    bool asignado = false;
+    forEachExp(s, [&](Exp* e) {
+        if (e->kind == NODE_ASSIGN && static_cast<AssignExp*>(e)->sym == sym) asignado = true;
+    });
+    return asignado;
+}
+
+// Copia profunda de un cuerpo sin bucles. Cada VarDec de la copia declara un
+// símbolo nuevo y las lecturas del contador se reemplazan por `valor()`
+struct Clonador {
+    Program* programa;
+    Symbol* contador;
+    function<Exp*()> valor;
+    unordered_map<Symbol*, Symbol*> nuevos;
+
+    Symbol* simbolo(Symbol* s) {
+        auto it = nuevos.find(s);
+        return it == nuevos.end() ? s : it->second;
+    }
+
+    static Exp* datos(Exp* copia, Exp* e) {
+        copia->inferredType = e->inferredType;
+        copia->isnumber = e->isnumber;
+        copia->valor = e->valor;
+        copia->valorReal = e->valorReal;
+        copia->etiqueta = e->etiqueta;
+        return copia;
+    }
+
+    Exp* exp(Exp* e) {
+        if (!e) return nullptr;
+        switch (e->kind) {
+            case NODE_NUMBER: return datos(new NumberExp(static_cast<NumberExp*>(e)->value), e);
+            case NODE_DOUBLE: return datos(new DoubleExp(static_cast<DoubleExp*>(e)->value), e);
+            case NODE_LONG:   return datos(new LongExp(e->valor), e);
+            case NODE_BOOL:   return datos(new BoolExp(static_cast<BoolExp*>(e)->value), e);
+            case NODE_STRING: return datos(new StringExp(static_cast<StringExp*>(e)->value), e);
+            case NODE_ID: {
+                IdExp* id = static_cast<IdExp*>(e);
+                if (id->sym == contador) return valor();
+                IdExp* copia = new IdExp(id->value);
+                copia->sym = simbolo(id->sym);
+                return datos(copia, e);
+            }
+            case NODE_BINARY: {
+                BinaryExp* b = static_cast<BinaryExp*>(e);
+                return datos(new BinaryExp(exp(b->left), exp(b->right), b->op), e);
+            }
+            case NODE_ASSIGN: {
+                AssignExp* a = static_cast<AssignExp*>(e);
+                AssignExp* copia = new AssignExp(a->id, exp(a->e));
+                copia->sym = simbolo(a->sym);
+                return datos(copia, e);
+            }
+            case NODE_FCALL: {
+                FcallExp* c = static_cast<FcallExp*>(e);
+                vector<Exp*> argumentos;
+                for (auto a : c->argumentos) argumentos.push_back(exp(a));
+                return datos(new FcallExp(c->nombre, argumentos, exp(c->receiver)), e);
+            }
+            default: return nullptr;
+        }
+    }
+
+    Block* bloque(Block* b) {
+        if (!b) return nullptr;
+        Block* copia = new Block();
+        for (auto st : b->stmts) copia->stmts.push_back(stm(st));
+        return copia;
+    }
+
+    Stm* stm(Stm* s) {
+        switch (s->kind) {
+            case NODE_VARDEC: {
+                VarDec* v = static_cast<VarDec*>(s);
+                VarDec* copia = new VarDec(v->name, v->type, exp(v->init), v->isConst);
+                Symbol* sym = new Symbol(v->sym->nombre, false);
+                sym->tipo = v->sym->tipo;
+                programa->simbolos.push_back(sym);
+                nuevos[v->sym] = sym;
+                copia->sym = sym;
+                return copia;
+            }
+            case NODE_BLOCK: return bloque(static_cast<Block*>(s));
+            case NODE_IF: {
+                IfStmt* i = static_cast<IfStmt*>(s);
+                return new IfStmt(exp(i->condition), bloque(i->thenBlock), bloque(i->elseBlock));
+            }
+            case NODE_PRINT:  return new PrintStm(exp(static_cast<PrintStm*>(s)->e));
+            case NODE_RETURN: return new ReturnStm(exp(static_cast<ReturnStm*>(s)->e));
+            default:          return exp(static_cast<Exp*>(s)); // El resto de nodos son expresiones
+        }
+    }
+};
+
+// Con todo constante: las vueltas del for, o -1 si son demasiadas o si el
+// contador desborda antes de pasar el límite (el for no termina)
+static long long vueltas(long long inicio, long long limite, long long paso, bool descendente, int tam) {
+    // Con downTo se cuenta sobre los valores negados: la misma cuenta ascendente
+    __int128 a = inicio, b = limite, s = paso;
+    __int128 maximo = tam == 8 ? LLONG_MAX : INT_MAX;
+    if (descendente) {
+        a = -a;
+        b = -b;
+        maximo = -static_cast<__int128>(tam == 8 ? LLONG_MIN : INT_MIN);
+    }
+    if (s <= 0) return -1;
+    if (a > b) return 0;
+    __int128 n = (b - a) / s + 1;
+    if (n > VUELTAS_COMPLETAS || a + n * s > maximo) return -1;
+    return static_cast<long long>(n);
+}
+
+bool LoopUnrollPass::desenrollar(ForStmt* s, list<Stm*>& destino, list<Stm*>::iterator donde) {
+    RangoFor r = rangoDe(s);
+    Type* tipo = s->varSym->tipo;
+    int tam = getTypeSize(tipo);
+    long long paso = 1;
+    if (!r.rango || (r.paso && !constantBits(r.paso, tipo, paso))) return false;
+    Medida m;
+    medir(s->block, m);
+    if (m.bucles || asigna(s->block, s->varSym)) return false;
+    int nodos = max(m.nodos, 1);
+
+    // Todo constante y pocas vueltas: una copia por vuelta
+    long long inicio, limite;
+    if (constantBits(r.inicio, tipo, inicio) && constantBits(r.limite, tipo, limite)) {
+        long long n = vueltas(inicio, limite, paso, r.descendente, tam);
+        if (n >= 0 && n * nodos <= TAMANO_COMPLETO) {
+            Block* copias = new Block();
+            for (long long k = 0; k < n; ++k) {
+                unsigned long long avance = static_cast<unsigned long long>(k) * static_cast<unsigned long long>(paso);
+                long long v = static_cast<long long>(static_cast<unsigned long long>(inicio) + (r.descendente ? -avance : avance));
+                Clonador c{programa, s->varSym, [&]() { return constanteDe(v, tipo); }};
+                copias->stmts.push_back(c.bloque(s->block));
+            }
+            destino.insert(donde, copias);
+            return true;
+        }
+    }
+
+    int copiasPorVuelta = factor;
+    while (copiasPorVuelta > 1 && copiasPorVuelta * nodos > TAMANO_PARCIAL) copiasPorVuelta /= 2;
+    if (copiasPorVuelta < 2 || m.llamadas || paso <= 0) return false;
+    // K = (copias - 1) * paso: si no cabe en el tipo del contador no se desenrolla
+    __int128 k = static_cast<__int128>(copiasPorVuelta - 1) * paso;
+    long long maximo = tam == 8 ? LLONG_MAX : INT_MAX;
+    if (k > maximo) return false;
+    long long K = static_cast<long long>(k);
+
+    // El inicio y el límite se evalúan una vez, en el mismo orden que en el for
+    string base = s->varName + ".";
+    VarDec* cursor = declaracionOculta(programa, base + "c", r.inicio, tipo);
+    destino.insert(donde, cursor);
+    r.rango->left = lecturaDe(cursor->sym);
+    bool limiteConstante = constantBits(r.limite, tipo, limite);
+    VarDec* fin = nullptr;
+    if (!limiteConstante) {
+        fin = declaracionOculta(programa, base + "fin", r.limite, tipo);
+        destino.insert(donde, fin);
+        r.rango->right = lecturaDe(fin->sym);
+    }
+    auto leerFin = [&]() -> Exp* { return fin ? static_cast<Exp*>(lecturaDe(fin->sym)) : constanteDe(limite, tipo); };
+
+    // while (i.c <= i.lim) { cuerpo; i.c = i.c + paso; ... }
+    Type* tipoBool = tipos->get(Type::BOOL);
+    Block* cuerpo = new Block();
+    for (int k = 0; k < copiasPorVuelta; ++k) {
+        Clonador c{programa, s->varSym, [&]() { return lecturaDe(cursor->sym); }};
+        cuerpo->stmts.push_back(c.bloque(s->block));
+        AssignExp* avance = new AssignExp(cursor->sym->nombre,
+            operacionTipada(lecturaDe(cursor->sym), constanteDe(paso, tipo), r.descendente ? MINUS_OP : PLUS_OP, tipo));
+        avance->sym = cursor->sym;
+        avance->inferredType = tipo;
+        cuerpo->stmts.push_back(avance);
+    }
+    VarDec* lim = declaracionOculta(programa, base + "lim",
+        operacionTipada(leerFin(), constanteDe(K, tipo), r.descendente ? PLUS_OP : MINUS_OP, tipo), tipo);
+    WhileStmt* principal = new WhileStmt(
+        operacionTipada(lecturaDe(cursor->sym), lecturaDe(lim->sym), r.descendente ? GE_OP : LE_OP, tipoBool), cuerpo);
+    Block* protegido = new Block();
+    protegido->stmts.push_back(lim);
+    protegido->stmts.push_back(principal);
+
+    // i.fin - K no debe dar la vuelta: i.fin >= MIN + K (o <= MAX - K con downTo)
+    long long minimo = tam == 8 ? LLONG_MIN : INT_MIN;
+    long long borde = r.descendente ? maximo - K : minimo + K;
+    if (limiteConstante) {
+        if (r.descendente ? limite > borde : limite < borde) {
+            delete protegido; // Nunca entra: el for de siempre hace todo
+        } else {
+            destino.insert(donde, protegido);
+        }
+    } else {
+        Exp* guarda = operacionTipada(leerFin(), constanteDe(borde, tipo), r.descendente ? LE_OP : GE_OP, tipoBool);
+        destino.insert(donde, new IfStmt(guarda, protegido, nullptr));
+    }
+    restos.insert(s);
+    return true;
+}
+
+bool LoopUnrollPass::bloque(Block* b) {
+    bool cambio = false;
+    for (auto it = b->stmts.begin(); it != b->stmts.end();) {
+        Stm* s = *it;
+        cambio |= sentencia(s);
+        if (s->kind != NODE_FOR || restos.count(static_cast<ForStmt*>(s))) {
+            ++it;
+            continue;
+        }
+        if (!desenrollar(static_cast<ForStmt*>(s), b->stmts, it)) {
+            ++it;
+            continue;
+        }
+        cambio = true;
+        if (restos.count(static_cast<ForStmt*>(s))) {
+            ++it; // Queda como el for del resto
+        } else {
+            it = b->stmts.erase(it);
+            delete s;
+        }
+    }
+    return cambio;
+}
+
+bool LoopUnrollPass::sentencia(Stm* s) {
+    switch (s->kind) {
+        case NODE_BLOCK: return bloque(static_cast<Block*>(s));
+        case NODE_IF: {
+            IfStmt* i = static_cast<IfStmt*>(s);
+            bool cambio = bloque(i->thenBlock);
+            if (i->elseBlock) cambio |= bloque(i->elseBlock);
+            return cambio;
+        }
+        case NODE_WHILE: return bloque(static_cast<WhileStmt*>(s)->block);
+        case NODE_FOR:   return bloque(static_cast<ForStmt*>(s)->block);
+        default:         return false;
+    }
+}
+
+bool LoopUnrollPass::run(Program* p, PassManager& pm) {
+    if (!tipos || factor < 2) return false;
+    programa = p;
+    bool cambio = false;
+    for (auto fd : p->fdlist) cambio |= bloque(fd->cuerpo);
+    return cambio;
+}
@@ -2,194 +2,644 @@
 #include "ast.h"
 #include "visitor.h"
 #include "semantic_types.h"
+#include "passes.h"
+#include "regalloc.h"
 #include <unordered_map>
 #include <unordered_set>
 
 #include <vector>
 #include <algorithm>
 #include <cstring>
+#include <cstdint>
 #include <string>
 using namespace std;
 
-// Ayuda para obtener el nombre de registro según el tamaño
-string getReg(string baseReg, int size) {
-    if (baseReg == "rax" || baseReg == "%rax") {
-        if (size == 1) return "%al";
-        if (size == 2) return "%ax";
-        if (size == 4) return "%eax";
-        return "%rax";
-    }
-    if (baseReg == "rcx" || baseReg == "%rcx") {
-        if (size == 1) return "%cl";
-        if (size == 2) return "%cx";
-        if (size == 4) return "%ecx";
-        return "%rcx";
-    }
-    if (baseReg == "rdx" || baseReg == "%rdx") {
-        if (size == 1) return "%dl";
-        if (size == 2) return "%dx";
-        if (size == 4) return "%edx";
-        return "%rdx";
-    }
-    if (baseReg == "rbx" || baseReg == "%rbx") {
-        if (size == 1) return "%bl";
-        if (size == 2) return "%bx";
-        if (size == 4) return "%ebx";
-        return "%rbx";
-    }
-    if (baseReg == "rdi" || baseReg == "%rdi") {
-        if (size == 1) return "%dil";
-        if (size == 2) return "%di";
-        if (size == 4) return "%edi";
-        return "%rdi";
-    }
-    if (baseReg == "rsi" || baseReg == "%rsi") {
-        if (size == 1) return "%sil";
-        if (size == 2) return "%si";
-        if (size == 4) return "%esi";
-        return "%rsi";
-    }
-    if (baseReg == "r8" || baseReg == "%r8") {
-        if (size == 1) return "%r8b";
-        if (size == 2) return "%r8w";
-        if (size == 4) return "%r8d";
-        return "%r8";
-    }
-    if (baseReg == "r9" || baseReg == "%r9") {
-        if (size == 1) return "%r9b";
-        if (size == 2) return "%r9w";
-        if (size == 4) return "%r9d";
-        return "%r9";
-    }
-    // Add more if needed
-    return (baseReg[0] == '%' ? "" : "%") + baseReg;
+static bool esSinSigno(Type* t) {
+    return t && (t->ttype == Type::UBYTE || t->ttype == Type::USHORT ||
+                 t->ttype == Type::UINT || t->ttype == Type::ULONG);
 }
 
-// Ayuda para obtener el sufijo de instrucción
-string getSuffix(int size) {
-    if (size == 1) return "b";
-    if (size == 2) return "w";
-    if (size == 4) return "l";
-    return "q";
+// Extiende a 64 bits el valor de `tam` bytes que está en `r`
+static void extender(Reg r, int tam, bool sinSigno, CodigoX86& out) {
+    if (tam == 8) return;
+    if (tam == 4 && sinSigno) out.emit(MOV, R(r, 4), R(r, 4)); // movl limpia la parte alta
+    else out.emit(sinSigno ? MOVZX : MOVSX, R(r, tam), R(r, 8));
 }
 
-int getTypeSize(Type* t) {
-    if (!t) return 8; // Por defecto 64 bits si se desconoce
-    if (t->ttype == Type::BYTE || t->ttype == Type::UBYTE) return 1;
-    if (t->ttype == Type::SHORT || t->ttype == Type::USHORT) return 2;
+static void extenderRax(int tam, bool sinSigno, CodigoX86& out) {
+    extender(RAX, tam, sinSigno, out);
+}
 
-    if (t->ttype == Type::INT || t->ttype == Type::UINT) return 4;
-    if (t->ttype == Type::FLOAT) return 4;
-    if (t->ttype == Type::DOUBLE) return 8;
-    if (t->ttype == Type::LONG || t->ttype == Type::ULONG) return 8;
-    if (t->ttype == Type::BOOL) return 1; // Bool as byte
-    return 8; // Valor por defecto
+// Entero de tipo `src` en RAX -> double en XMM0. cvtsi2sd solo convierte con
+// signo: un ULong se parte en alta * 2^32 + baja, ambas exactas, y la suma
+// redondea una vez (como `(double)` de un unsigned long long). Solo usa RAX
+static void enteroADouble(Type* src, CodigoX86& out) {
+    if (src->ttype != Type::ULONG) {
+        extenderRax(getTypeSize(src), esSinSigno(src), out);
+        out.emit(CVTSI2SD, R(RAX), R(XMM0));
+        return;
+    }
+    out.emit(MOV, R(RAX), R(XMM1));
+    out.emit(SHR, Inm(32), R(RAX));
+    out.emit(SHL, Inm(31), R(RAX)); // alta * 2^31: positivo
+    out.emit(CVTSI2SD, R(RAX), R(XMM0));
+    out.emit(ADDSD, R(XMM0), R(XMM0));
+    out.emit(MOV, R(XMM1), R(RAX));
+    out.emit(MOV, R(RAX, 4), R(RAX, 4));
+    out.emit(CVTSI2SD, R(RAX), R(XMM1));
+    out.emit(ADDSD, R(XMM1), R(XMM0));
+}
+
+// Entero a entero: al angostar se trunca y se extiende según el destino; al
+// ensanchar se extiende según la fuente (un UInt no arrastra el signo)
+static void enteroAEntero(Type* src, Type* dst, CodigoX86& out) {
+    int tamFuente = getTypeSize(src), tamDestino = getTypeSize(dst);
+    if (tamDestino <= tamFuente) extenderRax(tamDestino, esSinSigno(dst), out);
+    else extenderRax(tamFuente, esSinSigno(src), out);
 }
 
 // Convertir el valor en RAX al tipo destino, dejando el resultado en RAX/EAX
-static void convertValueTo(Type* src, Type* dst, ostream& out) {
+static void convertValueTo(Type* src, Type* dst, CodigoX86& out) {
     if (!src || !dst || src->ttype == dst->ttype) return;
 
     // Destino flotante
     if (dst->ttype == Type::FLOAT) {
         if (src->ttype == Type::DOUBLE) {
-            out << " movq %rax, %xmm0\n cvtsd2ss %xmm0, %xmm0\n movd %xmm0, %eax\n";
+            out.emit(MOV, R(RAX), R(XMM0));
+            out.emit(CVTSD2SS, R(XMM0), R(XMM0));
+            out.emit(MOV, R(XMM0, 4), R(RAX, 4));
             return;
         }
         if (src->ttype == Type::FLOAT) return;
 
         // Entero -> float
-        int sz = getTypeSize(src);
-        if (sz == 1) out << " movsbq %al, %rax\n";
-        else if (sz == 2) out << " movswq %ax, %rax\n";
-        else if (sz == 4) out << " movslq %eax, %rax\n";
-        out << " cvtsi2ssq %rax, %xmm0\n movd %xmm0, %eax\n";
+        if (src->ttype == Type::ULONG) {
+            enteroADouble(src, out);
+            out.emit(CVTSD2SS, R(XMM0), R(XMM0));
+        } else {
+            extenderRax(getTypeSize(src), esSinSigno(src), out);
+            out.emit(CVTSI2SS, R(RAX), R(XMM0));
+        }
+        out.emit(MOV, R(XMM0, 4), R(RAX, 4));
         return;
     }
 
     if (dst->ttype == Type::DOUBLE) {
         if (src->ttype == Type::FLOAT) {
-            out << " movd %eax, %xmm0\n cvtss2sd %xmm0, %xmm0\n movq %xmm0, %rax\n";
+            out.emit(MOV, R(RAX, 4), R(XMM0, 4));
+            out.emit(CVTSS2SD, R(XMM0), R(XMM0));
+            out.emit(MOV, R(XMM0), R(RAX));
             return;
         }
         if (src->ttype == Type::DOUBLE) return;
 
-        int sz = getTypeSize(src);
-        if (sz == 1) out << " movsbq %al, %rax\n";
-        else if (sz == 2) out << " movswq %ax, %rax\n";
-        else if (sz == 4) out << " movslq %eax, %rax\n";
-        out << " cvtsi2sdq %rax, %xmm0\n movq %xmm0, %rax\n";
+        enteroADouble(src, out);
+        out.emit(MOV, R(XMM0), R(RAX));
         return;
     }
 
     // Destino entero
     if (src->ttype == Type::DOUBLE || src->ttype == Type::FLOAT) {
-        out << " movq %rax, %xmm0\n";
-        if (src->ttype == Type::DOUBLE)
-            out << " cvttsd2siq %xmm0, %rax\n";
-        else
-            out << " cvttss2siq %xmm0, %rax\n";
+        out.emit(MOV, R(RAX), R(XMM0));
+        out.emit(src->ttype == Type::DOUBLE ? CVTTSD2SI : CVTTSS2SI, R(XMM0), R(RAX));
+        extenderRax(getTypeSize(dst), false, out);
+        return;
     }
-    int dsz = getTypeSize(dst);
-    if (dsz == 1) out << " movsbq %al, %rax\n";
-    else if (dsz == 2) out << " movswq %ax, %rax\n";
-    else if (dsz == 4) out << " movslq %eax, %rax\n";
-}
-
-// Recolección de llamadas para eliminar funciones no usadas
-static void collectCallsFromExp(Exp* e, unordered_set<string>& calls) {
-    if (!e) return;
-    if (auto b = dynamic_cast<BinaryExp*>(e)) {
-        collectCallsFromExp(b->left, calls);
-        collectCallsFromExp(b->right, calls);
-    } else if (auto f = dynamic_cast<FcallExp*>(e)) {
-        calls.insert(f->nombre);
-        for (auto arg : f->argumentos) collectCallsFromExp(arg, calls);
-        collectCallsFromExp(f->receiver, calls);
-    } else if (auto a = dynamic_cast<AssignExp*>(e)) {
-        collectCallsFromExp(a->e, calls);
+    enteroAEntero(src, dst, out);
+}
+
+// Carga en RAX una constante plegada con el ancho de su tipo
+static void emitConstant(Exp* e, CodigoX86& out) {
+    long long bits = 0;
+    constantBits(e, e->inferredType, bits);
+    int size = getTypeSize(e->inferredType);
+    if (e->inferredType && e->inferredType->ttype == Type::BOOL) size = 4; // limpia la parte alta
+    // Con 8 bytes el writer elige movq o movabsq según el valor
+    out.emit(MOV, Inm(bits), R(RAX, size));
+}
+
+// Operando de una variable resuelta para un acceso de `size` bytes:
+// etiqueta global, registro asignado o celda del marco
+static Operando direccion(Symbol* sym, int size, CodigoX86& out) {
+    if (sym->global) return out.global(sym->nombre, size);
+    if (sym->reg >= 0) return R(static_cast<Reg>(sym->reg), size);
+    return Mem(RBP, sym->offset, size);
+}
+
+// Los callee-saved que usa la función van en lo alto del marco
+static int offsetSalvado(size_t i) {
+    return -8 * static_cast<int>(i + 1);
+}
+
+static void emitRetorno(FunDec* f, CodigoX86& out) {
+    for (size_t i = 0; i < f->salvados.size(); ++i)
+        out.emit(MOV, Mem(RBP, offsetSalvado(i), 8), R(static_cast<Reg>(f->salvados[i])));
+    out.emit(LEAVE);
+    out.emit(RET);
+}
+
+// ===========================================================
+//   Temporales en registros
+// ===========================================================
+//
+// Mientras se evalúa el segundo operando de un BinaryExp, el primero espera
+// en un registro del pool, uno por nivel de anidamiento. El orden de
+// Sethi-Ullman (`etiqueta`) hace que la profundidad sea la mínima. Ninguno
+// lo toca el RegisterAllocator (r10, r11, rbx, r12-r15), ni las
+// operaciones (rax, rcx, rdx).
+static const Reg poolTemporales[] = {RSI, RDI, R8, R9};
+static const int NUM_TEMPORALES = 4;
+
+// ¿Emite un `call`? Una llamada destruye los registros del pool
+static bool contieneLlamada(Exp* e) {
+    switch (e->kind) {
+        case NODE_BINARY: {
+            BinaryExp* b = static_cast<BinaryExp*>(e);
+            return !b->isnumber && (llamaPow(b) || contieneLlamada(b->left) || contieneLlamada(b->right));
+        }
+        case NODE_FCALL: {
+            FcallExp* f = static_cast<FcallExp*>(e);
+            if (!f->receiver) return true;
+            return !f->isnumber && contieneLlamada(f->receiver);
+        }
+        case NODE_ASSIGN:
+            return contieneLlamada(static_cast<AssignExp*>(e)->e);
+        default:
+            return false;
     }
 }
 
-static void collectCallsFromStm(Stm* s, unordered_set<string>& calls) {
-    if (!s) return;
+// ¿Usa algo más que RAX? (temporales, rcx/rdx de una operación o una llamada)
+bool usaTemporales(Exp* e) {
+    switch (e->kind) {
+        case NODE_BINARY:
+            return !e->isnumber;
+        case NODE_FCALL: {
+            FcallExp* f = static_cast<FcallExp*>(e);
+            return !f->receiver || (!f->isnumber && usaTemporales(f->receiver));
+        }
+        case NODE_ASSIGN:
+            return usaTemporales(static_cast<AssignExp*>(e)->e);
+        default:
+            return false;
+    }
+}
 
-    if (auto e = dynamic_cast<Exp*>(s)) {
-        collectCallsFromExp(e, calls);
-        return;
+// Ancho en que opera un BinaryExp entero: el del resultado, o el del
+// operando más ancho en una comparación
+static int anchoOperacion(BinaryExp* e) {
+    if (e->op >= LE_OP && e->op <= NE_OP)
+        return max(getTypeSize(e->left->inferredType), getTypeSize(e->right->inferredType));
+    return getTypeSize(e->inferredType);
+}
+
+// Un operando más angosto que la operación se extiende según su propio tipo
+// (`Int + Long`, `UInt < Long`): la parte alta de RAX no siempre es su signo
+static void ensancharOperando(Exp* e, int ancho, Reg r, CodigoX86& out) {
+    int tam = getTypeSize(e->inferredType);
+    if (tam < ancho) extender(r, tam, esSinSigno(e->inferredType), out);
+}
+
+void GenCodeVisitor::cargarOperando(Exp* e, bool aDouble, int ancho) {
+    dispatch(e);
+    if (aDouble) {
+        static Type tipoDouble(Type::DOUBLE);
+        convertValueTo(e->inferredType, &tipoDouble, out);
+    } else {
+        ensancharOperando(e, ancho, RAX, out);
     }
-    if (auto v = dynamic_cast<VarDec*>(s)) {
-        collectCallsFromExp(v->init, calls);
+}
+
+void GenCodeVisitor::evaluarOperandos(BinaryExp* e, bool aDouble) {
+    bool izquierdo = izquierdaPrimero(e);
+    Exp* primero = izquierdo ? e->left : e->right;
+    Exp* segundo = izquierdo ? e->right : e->left;
+    int ancho = aDouble ? 8 : anchoOperacion(e);
+
+    cargarOperando(primero, aDouble, ancho);
+    if (!usaTemporales(segundo)) {
+        // El segundo solo usa RAX: el primero espera en RCX
+        out.emit(MOV, R(RAX), R(RCX));
+        cargarOperando(segundo, aDouble, ancho);
+        if (izquierdo) out.emit(XCHG, R(RAX), R(RCX));
         return;
     }
-    if (auto p = dynamic_cast<PrintStm*>(s)) {
-        collectCallsFromExp(p->e, calls);
+
+    if (temporalesEnUso < NUM_TEMPORALES && !contieneLlamada(segundo)) {
+        Reg temporal = poolTemporales[temporalesEnUso++];
+        out.emit(MOV, R(RAX), R(temporal));
+        cargarOperando(segundo, aDouble, ancho);
+        --temporalesEnUso;
+        if (izquierdo) out.emit(MOV, R(RAX), R(RCX));
+        out.emit(MOV, R(temporal), R(izquierdo ? RAX : RCX));
         return;
     }
-    if (auto r = dynamic_cast<ReturnStm*>(s)) {
-        collectCallsFromExp(r->e, calls);
+
+    // Pool agotado o hay una llamada en medio: el primero va a la pila
+    out.emit(PUSH, R(RAX));
+    ++enPila;
+    cargarOperando(segundo, aDouble, ancho);
+    --enPila;
+    if (izquierdo) {
+        out.emit(MOV, R(RAX), R(RCX));
+        out.emit(POP, R(RAX));
+    } else {
+        out.emit(POP, R(RCX));
+    }
+}
+
+// ===========================================================
+//   Condiciones: comparación y salto directos
+// ===========================================================
+//
+// En un if/while la condición no pasa por un 0/1 en RAX: una comparación
+// termina en `cmp` + `jcc` (que el procesador fusiona), y `&&`/`||` saltan
+// en cuanto el operando izquierdo decide (cortocircuito).
+
+static bool operandosDouble(BinaryExp* e) {
+    auto esReal = [](Type* t) { return t && (t->ttype == Type::DOUBLE || t->ttype == Type::FLOAT); };
+    return esReal(e->left->inferredType) || esReal(e->right->inferredType);
+}
+
+bool esOmitible(Exp* e) {
+    switch (e->kind) {
+        case NODE_BINARY: {
+            BinaryExp* b = static_cast<BinaryExp*>(e);
+            if (b->isnumber) return true;
+            long long k;
+            if ((b->op == DIV_OP || b->op == MOD_OP) && !operandoReducible(b, k)) return false; // idiv atrapa
+            return esOmitible(b->left) && esOmitible(b->right);
+        }
+        case NODE_FCALL: {
+            FcallExp* f = static_cast<FcallExp*>(e);
+            return f->receiver && (f->isnumber || esOmitible(f->receiver));
+        }
+        case NODE_ASSIGN:
+            return false;
+        default:
+            return true;
+    }
+}
+
+// ¿Se puede evaluar el derecho antes que el izquierdo sin que se note? El
+// izquierdo no tiene efectos ni atrapa, y el derecho no escribe nada que el
+// izquierdo lea: ni sus variables ni, si llama a funciones, sus globales
+static bool adelantarDerecho(BinaryExp* e) {
+    if (!esOmitible(e->left)) return false;
+    unordered_set<Symbol*> asignadas;
+    bool llama = false;
+    forEachExp(e->right, [&](Exp* x) {
+        if (x->kind == NODE_ASSIGN) asignadas.insert(static_cast<AssignExp*>(x)->sym);
+        else if (x->kind == NODE_FCALL && !static_cast<FcallExp*>(x)->receiver) llama = true;
+    });
+    if (asignadas.empty() && !llama) return true;
+    bool independiente = true;
+    forEachExp(e->left, [&](Exp* x) {
+        if (x->kind != NODE_ID) return;
+        Symbol* s = static_cast<IdExp*>(x)->sym;
+        if (!s || asignadas.count(s) || (s->global && llama)) independiente = false;
+    });
+    return independiente;
+}
+
+bool izquierdaPrimero(BinaryExp* e) {
+    // && y || cortocircuitan: el izquierdo va siempre primero
+    if (e->op == AND_OP || e->op == OR_OP) return true;
+    return e->left->etiqueta >= e->right->etiqueta || !adelantarDerecho(e);
+}
+
+Cond GenCodeVisitor::comparar(BinaryExp* e) {
+    if (operandosDouble(e)) {
+        // Ambos como bits de double; ucomisd fija las banderas como una comparación
+        // sin signo y con NaN deja ZF = PF = CF = 1. Solo A y AE son falsas con
+        // NaN, así que < y <= comparan al revés, y == / != miran también PF
+        evaluarOperandos(e, true);
+        out.emit(MOV, R(RAX), R(XMM0));
+        out.emit(MOV, R(RCX), R(XMM1));
+        switch (e->op) {
+            case LE_OP:
+                out.emit(UCOMISD, R(XMM0), R(XMM1));
+                return CC_AE;
+            case LT_OP:
+                out.emit(UCOMISD, R(XMM0), R(XMM1));
+                return CC_A;
+            case GT_OP:
+                out.emit(UCOMISD, R(XMM1), R(XMM0));
+                return CC_A;
+            case GE_OP:
+                out.emit(UCOMISD, R(XMM1), R(XMM0));
+                return CC_AE;
+            default:
+                // Igual = ZF y no PF, en AL; el salto o el setcc miran si AL es 0
+                out.emit(UCOMISD, R(XMM1), R(XMM0));
+                out.setcc(CC_E, R(RAX, 1));
+                out.setcc(CC_NP, R(RCX, 1));
+                out.emit(AND, R(RCX, 1), R(RAX, 1));
+                out.emit(TEST, R(RAX, 1), R(RAX, 1));
+                return e->op == EQ_OP ? CC_NE : CC_E;
+        }
+    }
+
+    // Se compara con el ancho de los operandos; sin signo con below/above
+    evaluarOperandos(e, false);
+    int size = anchoOperacion(e);
+    out.emit(CMP, R(RCX, size), R(RAX, size));
+    if (comparacionSinSigno(e)) {
+        switch (e->op) {
+            case LE_OP: return CC_BE;
+            case LT_OP: return CC_B;
+            case GT_OP: return CC_A;
+            case GE_OP: return CC_AE;
+            case EQ_OP: return CC_E;
+            default:    return CC_NE;
+        }
+    }
+    switch (e->op) {
+        case LE_OP: return CC_LE;
+        case LT_OP: return CC_L;
+        case GT_OP: return CC_G;
+        case GE_OP: return CC_GE;
+        case EQ_OP: return CC_E;
+        default:    return CC_NE;
+    }
+}
+
+void GenCodeVisitor::saltarSi(Exp* cond, bool valor, const Operando& destino) {
+    if (cond->kind == NODE_BINARY && !cond->isnumber) {
+        BinaryExp* b = static_cast<BinaryExp*>(cond);
+        if (b->op >= LE_OP && b->op <= NE_OP) {
+            Cond cc = comparar(b);
+            out.jcc(valor ? cc : invertir(cc), destino);
+            return;
+        }
+        if (b->op == AND_OP || b->op == OR_OP) {
+            bool decide = b->op == OR_OP; // Valor del izquierdo que ya fija el resultado
+            if (valor == decide) {
+                saltarSi(b->left, valor, destino);
+                saltarSi(b->right, valor, destino);
+            } else {
+                Operando sigue = out.etiq("cond_", labelcont++);
+                saltarSi(b->left, decide, sigue);
+                saltarSi(b->right, valor, destino);
+                out.etiqueta(sigue);
+            }
+            return;
+        }
+    }
+
+    // Cualquier otro valor: se prueban los 64 bits de RAX
+    dispatch(cond);
+    out.emit(CMP, Inm(0), R(RAX));
+    out.jcc(valor ? CC_NE : CC_E, destino);
+}
+
+// ===========================================================
+//   Potencia
+// ===========================================================
+//
+// Enteros: por cuadrados, con el exponente ajustado al tipo del resultado
+// como en constfold (negativo: solo 1 y -1 dan algo distinto de 0). Con
+// exponente constante la cadena de productos se desarrolla en compilación.
+// Reales: `pow` de la libm, salvo los exponentes constantes 0, 1 y 2.
+
+// Exponentes constantes que se desarrollan: a lo sumo 14 productos
+static const long long MAX_EXPONENTE_DESARROLLADO = 255;
+
+void GenCodeVisitor::potencia(BinaryExp* e) {
+    Type* tipo = e->inferredType;
+    bool real = tipo && (tipo->ttype == Type::DOUBLE || tipo->ttype == Type::FLOAT);
+
+    if (real) {
+        int k = exponenteRealSimple(e);
+        if (k >= 0) {
+            cargarOperando(e->left, true, 8);
+            if (k == 0) {
+                out.emit(MOV, Inm(0x3FF0000000000000LL), R(RAX)); // 1.0
+            } else if (k == 2) {
+                out.emit(MOV, R(RAX), R(XMM0));
+                out.emit(MULSD, R(XMM0), R(XMM0));
+                out.emit(MOV, R(XMM0), R(RAX));
+            }
+        } else {
+            evaluarOperandos(e, true);
+            out.emit(MOV, R(RAX), R(XMM0));
+            out.emit(MOV, R(RCX), R(XMM1));
+            // La libm puede exigir %rsp alineado a 16 en el call
+            bool alinear = enPila % 2 != 0;
+            if (alinear) out.emit(SUB, Inm(8), R(RSP));
+            out.emit(CALL, out.etiq("pow@PLT"));
+            if (alinear) out.emit(ADD, Inm(8), R(RSP));
+            out.emit(MOV, R(XMM0), R(RAX));
+        }
+        if (tipo->ttype == Type::FLOAT) {
+            out.emit(MOV, R(RAX), R(XMM0));
+            out.emit(CVTSD2SS, R(XMM0), R(XMM0));
+            out.emit(MOV, R(XMM0, 4), R(RAX, 4));
+        }
         return;
     }
-    if (auto b = dynamic_cast<Block*>(s)) {
-        for (auto st : b->stmts) collectCallsFromStm(st, calls);
+
+    int size = getTypeSize(tipo);
+    bool sinSigno = esSinSigno(tipo);
+    long long n = 0;
+    if (constantBits(e->right, tipo, n) && n >= 0 && n <= MAX_EXPONENTE_DESARROLLADO) {
+        dispatch(e->left);
+        ensancharOperando(e->left, size, RAX, out);
+        if (n == 0) {
+            out.emit(MOV, Inm(1), R(RAX, 4));
+        } else {
+            // De izquierda a derecha: se eleva al cuadrado por cada bit y se
+            // multiplica por la base (en RCX) por cada 1
+            int alto = 63 - __builtin_clzll(static_cast<unsigned long long>(n));
+            if (__builtin_popcountll(static_cast<unsigned long long>(n)) > 1) out.emit(MOV, R(RAX), R(RCX));
+            for (int bit = alto - 1; bit >= 0; --bit) {
+                out.emit(IMUL, R(RAX), R(RAX));
+                if ((n >> bit) & 1) out.emit(IMUL, R(RCX), R(RAX));
+            }
+        }
+        extenderRax(size, sinSigno, out);
         return;
     }
-    if (auto i = dynamic_cast<IfStmt*>(s)) {
-        collectCallsFromExp(i->condition, calls);
-        collectCallsFromStm(i->thenBlock, calls);
-        collectCallsFromStm(i->elseBlock, calls);
+
+    // Base en RAX, exponente en RCX; el resultado se acumula en RDX
+    evaluarOperandos(e, false);
+    int label = labelcont++;
+    Operando fin = out.etiq("potfin_", label);
+    Operando paso = out.etiq("potpaso_", label);
+    Operando sinProducto = out.etiq("potsig_", label);
+    if (size == 4 && sinSigno) out.emit(MOV, R(RCX, 4), R(RCX, 4));
+    else if (size < 8) out.emit(sinSigno ? MOVZX : MOVSX, R(RCX, size), R(RCX));
+    out.emit(MOV, Inm(1), R(RDX, 4));
+    if (!sinSigno) {
+        Operando noNegativo = out.etiq("potpos_", label);
+        out.emit(TEST, R(RCX), R(RCX));
+        out.jcc(CC_NS, noNegativo);
+        out.emit(CMP, Inm(1), R(RAX, size));
+        out.jcc(CC_E, fin); // 1 ** n = 1
+        out.emit(MOV, Inm(0), R(RDX, 4));
+        out.emit(CMP, Inm(-1), R(RAX, size));
+        out.jcc(CC_NE, fin); // |x| > 1: 0
+        out.emit(MOV, Inm(1), R(RDX, 4));
+        out.emit(TEST, Inm(1), R(RCX, 1));
+        out.jcc(CC_E, fin); // (-1) ** par = 1
+        out.emit(MOV, Inm(-1), R(RDX));
+        out.emit(JMP, fin);
+        out.etiqueta(noNegativo);
+    }
+    out.emit(TEST, R(RCX), R(RCX));
+    out.jcc(CC_E, fin);
+    out.etiqueta(paso);
+    out.emit(TEST, Inm(1), R(RCX, 1));
+    out.jcc(CC_E, sinProducto);
+    out.emit(IMUL, R(RAX), R(RDX));
+    out.etiqueta(sinProducto);
+    out.emit(IMUL, R(RAX), R(RAX));
+    out.emit(SHR, Inm(1), R(RCX));
+    out.jcc(CC_NE, paso);
+    out.etiqueta(fin);
+    out.emit(MOV, R(RDX), R(RAX));
+    extenderRax(size, sinSigno, out);
+}
+
+// ===========================================================
+//   Productos y cocientes por constantes
+// ===========================================================
+//
+// Sin `imul` por registro ni `idiv`: potencias de dos con desplazamientos
+// y máscaras; los demás divisores con el producto por un inverso de 64 bits
+// (la parte alta de `imul`/`mul` en RDX). El dividendo se extiende a 64
+// bits y el cociente o el resto ya quedan extendidos según su tipo.
+
+// q = (x * m) >> (64 + desplazamiento); con `suma`, m tiene un bit 64 implícito
+struct Inverso {
+    uint64_t m;
+    int desplazamiento;
+    bool suma;
+};
+
+// Inverso de `d` (> 1, no potencia de dos) para dividendos de `bits` bits. El
+// error de redondear 2^l / d hacia arriba no debe alcanzar al cociente: con
+// e = m * d - 2^l hace falta |x| * e < 2^l.
+static Inverso inverso(uint64_t d, int bits, bool conSigno) {
+    typedef unsigned __int128 u128;
+    int c = 64 - __builtin_clzll(d - 1); // ceil(log2 d)
+    u128 maxX = conSigno ? u128(1) << (bits - 1) : (u128(1) << bits) - 1;
+    for (int l = 64; l <= 63 + c; ++l) {
+        u128 p = u128(1) << l;
+        u128 m = (p + d - 1) / d;
+        if ((m >> 64) == 0 && (m * d - p) * maxX < p) return {static_cast<uint64_t>(m), l - 64, false};
+    }
+    // Solo sin signo de 64 bits: m de 65 bits, q = (((x - t) >> 1) + t) >> (c - 1)
+    return {static_cast<uint64_t>(((u128(1) << (64 + c)) + d - 1) / d), c - 1, true};
+}
+
+void GenCodeVisitor::reducir(BinaryExp* e, Exp* constante, long long k) {
+    Type* tipo = e->inferredType;
+    int size = getTypeSize(tipo);
+    bool sinSigno = esSinSigno(tipo);
+    dispatch(constante == e->right ? e->left : e->right);
+    ensancharOperando(constante == e->right ? e->left : e->right, size, RAX, out);
+
+    if (e->op == MUL_OP) {
+        // Solo importan los bits bajos: k con el signo de su ancho
+        int corrimiento = 64 - 8 * size;
+        int64_t f = static_cast<int64_t>(static_cast<uint64_t>(k) << corrimiento) >> corrimiento;
+        uint64_t a = f < 0 ? 0 - static_cast<uint64_t>(f) : static_cast<uint64_t>(f);
+        if (f == 0) {
+            out.emit(MOV, Inm(0), R(RAX, 4));
+        } else if ((a & (a - 1)) == 0) {
+            if (a > 1) out.emit(SHL, Inm(__builtin_ctzll(a)), R(RAX));
+            if (f < 0) out.emit(NEG, R(RAX));
+        } else if (f >= INT32_MIN && f <= INT32_MAX) {
+            out.emit(IMUL, Inm(f), R(RAX));
+        } else {
+            out.emit(MOV, Inm(f), R(RCX));
+            out.emit(IMUL, R(RCX), R(RAX));
+        }
+        extenderRax(size, sinSigno, out);
         return;
     }
-    if (auto w = dynamic_cast<WhileStmt*>(s)) {
-        collectCallsFromExp(w->condition, calls);
-        collectCallsFromStm(w->block, calls);
+
+    extenderRax(size, sinSigno, out);
+    bool resto = e->op == MOD_OP;
+    uint64_t a = sinSigno || k > 0 ? static_cast<uint64_t>(k) : 0 - static_cast<uint64_t>(k);
+    if (a == 1) {
+        if (resto) out.emit(MOV, Inm(0), R(RAX, 4));
         return;
     }
-    if (auto f = dynamic_cast<ForStmt*>(s)) {
-        collectCallsFromExp(f->rangeExp, calls);
-        collectCallsFromStm(f->block, calls);
+
+    if ((a & (a - 1)) == 0) {
+        int n = __builtin_ctzll(a);
+        if (sinSigno) {
+            if (!resto) out.emit(SHR, Inm(n), R(RAX));
+            else if (n < 32) out.emit(AND, Inm(static_cast<int64_t>(a - 1)), R(RAX));
+            else if (n == 32) out.emit(MOV, R(RAX, 4), R(RAX, 4));
+            else {
+                out.emit(SHL, Inm(64 - n), R(RAX));
+                out.emit(SHR, Inm(64 - n), R(RAX));
+            }
+            return;
+        }
+        // Con signo se redondea hacia cero: a un negativo se le suma a - 1
+        out.emit(MOV, R(RAX), R(RCX));
+        if (n > 1) out.emit(SAR, Inm(63), R(RCX));
+        out.emit(SHR, Inm(64 - n), R(RCX));
+        if (!resto) {
+            out.emit(ADD, R(RCX), R(RAX));
+            out.emit(SAR, Inm(n), R(RAX));
+            if (k < 0) out.emit(NEG, R(RAX));
+            return;
+        }
+        // x - ((x + sesgo) & -a): el resto conserva el signo del dividendo
+        out.emit(ADD, R(RAX), R(RCX));
+        if (n < 32) {
+            out.emit(AND, Inm(-static_cast<int64_t>(a)), R(RCX));
+        } else {
+            out.emit(SAR, Inm(n), R(RCX));
+            out.emit(SHL, Inm(n), R(RCX));
+        }
+        out.emit(SUB, R(RCX), R(RAX));
         return;
     }
+
+    // x queda en RCX; m * x deja la parte alta en RDX
+    Inverso inv = inverso(a, 8 * size, !sinSigno);
+    out.emit(MOV, R(RAX), R(RCX));
+    out.emit(MOV, Inm(static_cast<int64_t>(inv.m)), R(RAX));
+    if (sinSigno) {
+        out.emit(MUL, R(RCX));
+        if (inv.suma) {
+            out.emit(MOV, R(RCX), R(RAX));
+            out.emit(SUB, R(RDX), R(RAX));
+            out.emit(SHR, Inm(1), R(RAX));
+            out.emit(ADD, R(RDX), R(RAX));
+            if (inv.desplazamiento > 0) out.emit(SHR, Inm(inv.desplazamiento), R(RAX));
+        } else {
+            if (inv.desplazamiento > 0) out.emit(SHR, Inm(inv.desplazamiento), R(RDX));
+            out.emit(MOV, R(RDX), R(RAX));
+        }
+    } else {
+        // imul toma m con signo: si pasa de 2^63 falta sumar x una vez
+        out.emit(IMUL, R(RCX));
+        if (inv.m >> 63) out.emit(ADD, R(RCX), R(RDX));
+        if (inv.desplazamiento > 0) out.emit(SAR, Inm(inv.desplazamiento), R(RDX));
+        // Redondeo hacia cero: +1 si el cociente quedó negativo
+        out.emit(MOV, R(RDX), R(RAX));
+        out.emit(SHR, Inm(63), R(RDX));
+        out.emit(ADD, R(RDX), R(RAX));
+        if (!resto && k < 0) out.emit(NEG, R(RAX));
+    }
+    if (resto) {
+        // x - q * |k|
+        if (a <= static_cast<uint64_t>(INT32_MAX)) {
+            out.emit(IMUL, Inm(static_cast<int64_t>(a)), R(RAX));
+        } else {
+            out.emit(MOV, Inm(static_cast<int64_t>(a)), R(RDX));
+            out.emit(IMUL, R(RDX), R(RAX));
+        }
+        out.emit(SUB, R(RAX), R(RCX));
+        out.emit(MOV, R(RCX), R(RAX));
+    }
 }
 
 int BinaryExp::accept(Visitor* visitor) {
@@ -269,32 +719,20 @@ int ReturnStm::accept(Visitor* visitor){
 // Implementación de GenCodeVisitor
 
 int GenCodeVisitor::generar(Program* program) {
-    // Inicializar offset y estado de función antes de comenzar
-    offset = -8; 
-    entornoFuncion = false; 
-    program->accept(this);
+    visit(program);
     return 0;
 }
 
 int GenCodeVisitor::visit(Program* program) {
     // 1. Sección de datos
-    out << ".data\n";
-    out << "print_fmt_num: .string \"%ld \\n\""<<endl;
-    out << "print_fmt_float: .string \"%f\\n\""<<endl; // Formato para flotantes
-    out << "print_fmt_str: .string \"%s\\n\""<<endl;
+    out.seccion(".data");
+    out.asciz("print_fmt_num", "%ld \\n");
+    out.asciz("print_fmt_float", "%f\\n"); // Formato para flotantes
+    out.asciz("print_fmt_str", "%s\\n");
 
     // A. Recorrer VarDecs Globales para registrarlas y definirlas estáticamente.
     for (auto dec : program->vdlist){
-        memoriaGlobal[dec->name] = true; // Registrar la variable como global
-        // Registrar tipo global
-        Type* gtype = nullptr;
-        if (!dec->type.empty()) {
-            gtype = new Type();
-            gtype->set_basic_type(dec->type);
-        } else if (dec->init && dec->init->inferredType) {
-            gtype = dec->init->inferredType;
-        }
-        tiposGlobales[dec->name] = gtype;
+        Type* gtype = dec->sym->tipo;
 
         // 1. Manejar StringExp para recolectar la literal (si es StringExp).
         if (dec->init) {
@@ -306,172 +744,81 @@ int GenCodeVisitor::visit(Program* program) {
                 }
             }
         }
-        
-        // 2. Generar la DEFINICIÓN ESTÁTICA (.quad).
-        out << dec->name << ": .quad ";
-        
-        NumberExp* numExp = dynamic_cast<NumberExp*>(dec->init);
-        BoolExp* boolExp = dynamic_cast<BoolExp*>(dec->init);
-        
-        if (numExp) {
-            out << numExp->value << endl;
-        } else if (boolExp) {
-            out << (boolExp->value ? 1 : 0) << endl;
-        } else {
-            out << "0" << endl; 
-        }
+
+        // 2. Generar la DEFINICIÓN ESTÁTICA (.quad) con el inicializador
+        //    plegado y convertido al tipo de la variable.
+        long long bits = 0;
+        if (!dec->init || !constantBits(dec->init, gtype, bits)) bits = 0;
+        out.quad(dec->name, bits);
     }
-    
+
     // 2. Sección de código
-    out << ".text\n";
-    out << ".global main\n";
-    
+    out.seccion(".text");
+    out.globl("main");
+
     // Punto de entrada `main` por defecto (mantenemos su lógica)
     if (program->fdlist.empty()) {
-        out << "main:\n";
-        out << " pushq %rbp\n";
-        out << " movq %rsp, %rbp\n";
-        out << " movl $0, %eax\n";
-        out << " popq %rbp\n";
-        out << " ret\n";
-    }
-
-    // Determinar qué funciones están realmente usadas (alcanzables desde main)
-    unordered_map<string, FunDec*> funcMap;
-    for (auto dec : program->fdlist) funcMap[dec->nombre] = dec;
-
-    unordered_set<string> used;
-    if (funcMap.count("main")) {
-        vector<string> stack = {"main"};
-        while (!stack.empty()) {
-            string fname = stack.back();
-            stack.pop_back();
-            if (!used.insert(fname).second) continue; // ya visitada
-            auto it = funcMap.find(fname);
-            if (it == funcMap.end()) continue;
-            unordered_set<string> directCalls;
-            collectCallsFromStm(it->second->cuerpo, directCalls);
-            for (auto& c : directCalls) {
-                if (funcMap.count(c) && !used.count(c)) stack.push_back(c);
-            }
-        }
-    } else {
-        // Sin main definido: no eliminamos nada por seguridad
-        for (auto dec : program->fdlist) used.insert(dec->nombre);
+        out.etiqueta(out.etiq("main"));
+        out.emit(PUSH, R(RBP));
+        out.emit(MOV, R(RSP), R(RBP));
+        out.emit(MOV, Inm(0), R(RAX, 4));
+        out.emit(POP, R(RBP));
+        out.emit(RET);
     }
 
-    // Funciones (solo las usadas)
+    // Funciones (las no alcanzables ya fueron eliminadas por DeadFunctionPass)
     for (auto dec : program->fdlist){
-        if (!used.count(dec->nombre)) continue; // función no utilizada
-        dec->accept(this);
+        visit(dec);
     }
 
     // B. Imprimir las literales de cadena recolectadas (al final para incluir las de funciones)
     if (!stringLiterals.empty()) {
-        out << ".data\n";
+        out.seccion(".data");
         for (auto& pair : stringLiterals) {
-            out << pair.second << ": .string \"" << pair.first << "\""<<endl;
+            out.asciz(pair.second, pair.first);
         }
     }
 
-    out << ".section .note.GNU-stack,\"\",@progbits"<<endl;
+    out.seccion(".section .note.GNU-stack,\"\",@progbits");
     return 0;
 }
 
 int GenCodeVisitor::visit(VarDec* stm) {
-    string var = stm->name;
-    
-    if (!entornoFuncion) {
-        memoriaGlobal[var] = true;
-        Type* destType = nullptr;
-        if (!stm->type.empty()) {
-            destType = new Type();
-            destType->set_basic_type(stm->type);
-        } else if (stm->init && stm->init->inferredType) {
-            destType = stm->init->inferredType;
-        }
-        tiposGlobales[var] = destType;
-        if (stm->init) {
-            StringExp* stringExp = dynamic_cast<StringExp*>(stm->init);
-            if (stringExp) {
-                if (!stringLiterals.count(stringExp->value)) {
-                    string label = "str_" + to_string(stringCont++);
-                    stringLiterals[stringExp->value] = label;
-                }
-            }
-        }
-        return 0; 
-    } else { 
-        // Usa el entorno para variables locales
-        env.add_var(var, offset);
-        Type* destType = nullptr;
-        if (!stm->type.empty()) {
-            destType = new Type();
-            destType->set_basic_type(stm->type);
-        } else if (stm->init && stm->init->inferredType) {
-            destType = stm->init->inferredType;
-        }
-        typeEnv.add_var(var, destType);
-        int varOffset = offset;
-        offset -= 8;
-        
-        if (stm->init) {
-            stm->init->accept(this); 
-            // Determinar tipo destino
-            convertValueTo(stm->init->inferredType, destType, out);
-            int size = getTypeSize(destType ? destType : stm->init->inferredType);
-            string reg = getReg("rax", size);
-            out << " mov" << getSuffix(size) << " " << reg << ", " << varOffset << "(%rbp)"<<endl;
-        }
+    // Las globales se definen en visit(Program) con su .quad
+    if (stm->sym->global) return 0;
+
+    Type* destType = stm->sym->tipo;
+    if (stm->init) {
+        dispatch(stm->init);
+        // Determinar tipo destino
+        convertValueTo(stm->init->inferredType, destType, out);
+        int size = getTypeSize(destType ? destType : stm->init->inferredType);
+        out.emit(MOV, R(RAX, size), direccion(stm->sym, size, out));
     }
     return 0;
 }
 
 int GenCodeVisitor::visit(NumberExp* exp) {
     int size = getTypeSize(exp->inferredType);
-    string reg = getReg("rax", size);
-    out << " mov" << getSuffix(size) << " $" << exp->value << ", " << reg << endl;
+    out.emit(MOV, Inm(exp->value), R(RAX, size));
     return 0;
 }
 
-// En visitor.cpp
-#include <cstring> // Necesario para memcpy
-
-// En visitor.cpp
 int GenCodeVisitor::visit(DoubleExp* exp) {
-    std::cerr << "DEBUG: Visitando DoubleExp con valor: " << exp->value << std::endl;
-    long long bits;
-    double d = exp->value; 
-    
-    cout << d << endl;
-
-    // 1. Obtener la representación binaria (patrón de bits) de 64 bits
-    // Esto es crucial para un literal flotante.
-    memcpy(&bits, &d, sizeof(bits));
-    
-    // 2. Cargar el patrón de bits en RAX usando movabsq (la única forma robusta)
-    out << " movabsq $" << bits << ", %rax\n"; 
-    
-    // 3. Mover el patrón de bits de RAX al registro de coma flotante XMM0
-    out << " movq %rax, %xmm0\n"; 
-    
-    // El resultado queda en %xmm0 (64 bits).
-    return 8; 
-}
-
-// En visitor.cpp
+    // El patrón de bits del double queda en RAX, como el resto de valores
+    emitConstant(exp, out);
+    return 8;
+}
 
 int GenCodeVisitor::visit(LongExp* exp) {
-    // CORRECCIÓN: Usar "\n" en lugar de "\\n" y eliminar el espacio extra
-    out << " movq $" << exp->valor << ", %rax\n"; 
-    
-    return 8; 
+    // movq o movabsq según quepa en 32 bits con signo
+    emitConstant(exp, out);
+    return 8;
 }
 
 int GenCodeVisitor::visit(BoolExp* exp) {
-    int size = getTypeSize(exp->inferredType);
-    string reg = getReg("rax", size);
-    out << " mov" << getSuffix(size) << " $" << (exp->value ? 1 : 0) << ", " << reg << endl;
+    // movl limpia la parte alta de RAX: las condiciones se prueban con cmpq
+    out.emit(MOV, Inm(exp->value ? 1 : 0), R(RAX, 4));
     return 0;
 }
 
@@ -483,633 +830,462 @@ int GenCodeVisitor::visit(StringExp* exp) {
         label = "str_" + to_string(stringCont++);
         stringLiterals[exp->value] = label;
     }
-    out << " leaq " << label << "(%rip), %rax\n"; 
+    out.emit(LEA, out.global(label, 8), R(RAX));
     return 0;
 }
 
 int GenCodeVisitor::visit(IdExp* exp) {
     int size = getTypeSize(exp->inferredType);
     if (exp->inferredType && exp->inferredType->ttype == Type::FLOAT) {
-        auto load = [&](const string& addr) {
-            out << " movl " << addr << ", %eax\n";
-        };
-        if (memoriaGlobal.count(exp->value))
-            load(exp->value + "(%rip)");
-        else {
-            int varOffset = env.lookup(exp->value);
-            load(to_string(varOffset) + "(%rbp)");
-        }
+        out.emit(MOV, direccion(exp->sym, 4, out), R(RAX, 4));
         return 0;
     }
     if (exp->inferredType && exp->inferredType->ttype == Type::DOUBLE) {
-        auto load = [&](const string& addr) { out << " movq " << addr << ", %rax\n"; };
-        if (memoriaGlobal.count(exp->value))
-            load(exp->value + "(%rip)");
-        else {
-            int varOffset = env.lookup(exp->value);
-            load(to_string(varOffset) + "(%rbp)");
-        }
+        out.emit(MOV, direccion(exp->sym, 8, out), R(RAX));
         return 0;
     }
 
-    bool isUnsigned = exp->inferredType && (
-        exp->inferredType->ttype == Type::UBYTE ||
-        exp->inferredType->ttype == Type::USHORT ||
-        exp->inferredType->ttype == Type::UINT ||
-        exp->inferredType->ttype == Type::ULONG
-    );
-
-    auto emitLoad = [&](const string& addr) {
-        if (size == 1) out << (isUnsigned ? " movzbq " : " movsbq ") << addr << ", %rax\n";
-        else if (size == 2) out << (isUnsigned ? " movzwq " : " movswq ") << addr << ", %rax\n";
-        else if (size == 4) out << " movslq " << addr << ", %rax\n";
-        else out << " movq " << addr << ", %rax\n";
-    };
-
-    if (memoriaGlobal.count(exp->value))
-        emitLoad(exp->value + "(%rip)");
-    else {
-        int varOffset = env.lookup(exp->value);
-        emitLoad(to_string(varOffset) + "(%rbp)");
-    }
+    // UInt se extiende con signo como Int
+    bool isUnsigned = esSinSigno(exp->inferredType) && size < 4;
+    Operando addr = direccion(exp->sym, size, out);
+    if (size == 8) out.emit(MOV, addr, R(RAX));
+    else out.emit(isUnsigned ? MOVZX : MOVSX, addr, R(RAX));
     return 0;
 }
 
 int GenCodeVisitor::visit(BinaryExp* exp) {
     // Constant folding: si ya está evaluado, emite inmediato
     if (exp->isnumber) {
-        int size = getTypeSize(exp->inferredType);
-        string reg = getReg("rax", size);
-        out << " mov" << getSuffix(size) << " $" << exp->valor << ", " << reg << "\n";
+        emitConstant(exp, out);
         return 0;
     }
 
-    bool leftFirst = exp->left->etiqueta >= exp->right->etiqueta;
-    bool operandsAreDouble = (exp->left->inferredType && (exp->left->inferredType->ttype == Type::DOUBLE || exp->left->inferredType->ttype == Type::FLOAT)) ||
-                             (exp->right->inferredType && (exp->right->inferredType->ttype == Type::DOUBLE || exp->right->inferredType->ttype == Type::FLOAT));
-
-    if (operandsAreDouble) {
-        auto loadToXmm = [&](Exp* e, const string& xmm) {
-            e->accept(this);
-            Type* t = e->inferredType;
-            if (t->ttype == Type::DOUBLE) {
-                out << " movq %rax, " << xmm << "\n";
-            } else if (t->ttype == Type::FLOAT) {
-                out << " movd %eax, " << xmm << "\n";
-                out << " cvtss2sd " << xmm << ", " << xmm << "\n";
-            } else { // entero
-                int sz = getTypeSize(t);
-                if (sz == 1) out << " movsbq %al, %rax\n";
-                else if (sz == 2) out << " movswq %ax, %rax\n";
-                else if (sz == 4) out << " movslq %eax, %rax\n";
-                out << " cvtsi2sdq %rax, " << xmm << "\n";
-            }
-        };
+    // && y || con un operando que no se puede evaluar de más (una llamada,
+    // una división...): saltos y 0/1 en RAX. Si ambos son baratos y sin
+    // efectos se evalúan los dos y se combinan con and/or, sin saltos.
+    if ((exp->op == AND_OP || exp->op == OR_OP) && !(esOmitible(exp->left) && esOmitible(exp->right))) {
+        int label = labelcont++;
+        saltarSi(exp, false, out.etiq("falso_", label));
+        out.emit(MOV, Inm(1), R(RAX, 4));
+        out.emit(JMP, out.etiq("finlogico_", label));
+        out.etiqueta(out.etiq("falso_", label));
+        out.emit(MOV, Inm(0), R(RAX, 4));
+        out.etiqueta(out.etiq("finlogico_", label));
+        return 0;
+    }
 
-        if (leftFirst) {
-            loadToXmm(exp->left, "%xmm0");
-            loadToXmm(exp->right, "%xmm1");
-        } else {
-            loadToXmm(exp->right, "%xmm1");
-            loadToXmm(exp->left, "%xmm0");
-        }
+    if (exp->op == POW_OP) {
+        potencia(exp);
+        return 0;
+    }
+
+    // Resultado Boolean de una comparación: 0/1 en RAX
+    if (exp->op >= LE_OP && exp->op <= NE_OP) {
+        Cond cc = comparar(exp);
+        out.emit(MOV, Inm(0), R(RAX, 4));
+        out.setcc(cc, R(RAX, 1));
+        out.emit(MOVZX, R(RAX, 1), R(RAX));
+        return 0;
+    }
+
+    if (operandosDouble(exp)) {
+        // Ambos llegan como bits de double: izq en RAX, der en RCX
+        evaluarOperandos(exp, true);
+        out.emit(MOV, R(RAX), R(XMM0));
+        out.emit(MOV, R(RCX), R(XMM1));
 
         switch (exp->op) {
-            case PLUS_OP:  out << " addsd %xmm1, %xmm0\n"; break;
-            case MINUS_OP: out << " subsd %xmm1, %xmm0\n"; break;
-            case MUL_OP:   out << " mulsd %xmm1, %xmm0\n"; break;
-            case DIV_OP:   out << " divsd %xmm1, %xmm0\n"; break;
-            // Comparisons
-            case LE_OP:
-                out << " ucomisd %xmm1, %xmm0\n"
-                    << " movl $0, %eax\n"
-                    << " setbe %al\n" // Below or Equal (unsigned check for floats)
-                    << " movzbq %al, %rax\n";
-                return 0;
-            case LT_OP:
-                out << " ucomisd %xmm1, %xmm0\n"
-                    << " movl $0, %eax\n"
-                    << " setb %al\n" // Below
-                    << " movzbq %al, %rax\n";
-                return 0;
-            case GT_OP:
-                out << " ucomisd %xmm1, %xmm0\n"
-                    << " movl $0, %eax\n"
-                    << " setja %al\n" // Above (unsigned check for floats)
-                    << " movzbq %al, %rax\n";
-                return 0;
-            case GE_OP:
-                out << " ucomisd %xmm1, %xmm0\n"
-                    << " movl $0, %eax\n"
-                    << " setae %al\n" // Above or Equal
-                    << " movzbq %al, %rax\n";
-                return 0;
-            case EQ_OP:
-                out << " ucomisd %xmm1, %xmm0\n"
-                    << " movl $0, %eax\n"
-                    << " sete %al\n" 
-                    << " movzbq %al, %rax\n";
-                if (exp->op == NE_OP) out << " xorq $1, %rax\n"; // Invert for NE
-                return 0;
-            case NE_OP:
-                out << " ucomisd %xmm1, %xmm0\n"
-                    << " movl $0, %eax\n"
-                    << " setne %al\n" 
-                    << " movzbq %al, %rax\n";
-                return 0;
-            default: out << " # Operador no soportado para doubles\n"; break;
+            case PLUS_OP:  out.emit(ADDSD, R(XMM1), R(XMM0)); break;
+            case MINUS_OP: out.emit(SUBSD, R(XMM1), R(XMM0)); break;
+            case MUL_OP:   out.emit(MULSD, R(XMM1), R(XMM0)); break;
+            case DIV_OP:   out.emit(DIVSD, R(XMM1), R(XMM0)); break;
+            default: out.directiva("# Operador no soportado para doubles"); break;
         }
-        
+
         // Result is in XMM0. Convert to float if needed.
         if (exp->inferredType && exp->inferredType->ttype == Type::FLOAT) {
-            out << " cvtsd2ss %xmm0, %xmm0\n";
-            out << " movd %xmm0, %eax\n";
+            out.emit(CVTSD2SS, R(XMM0), R(XMM0));
+            out.emit(MOV, R(XMM0, 4), R(RAX, 4));
         } else {
-            out << " movq %xmm0, %rax\n";
+            out.emit(MOV, R(XMM0), R(RAX));
         }
         return 0;
     }
 
-    if (leftFirst) {
-        exp->left->accept(this);
-        out << " pushq %rax\n";
-        exp->right->accept(this);
-        out << " movq %rax, %rcx\n popq %rax\n";
-    } else {
-        exp->right->accept(this);
-        out << " pushq %rax\n";
-        exp->left->accept(this);
-        out << " movq %rax, %rcx\n popq %rax\n";
-        out << " xchgq %rax, %rcx\n"; // asegurar rax=izq, rcx=der
+    long long k = 0;
+    if (Exp* constante = operandoReducible(exp, k)) {
+        reducir(exp, constante, k);
+        return 0;
     }
 
+    evaluarOperandos(exp, false);
+
     int size = getTypeSize(exp->inferredType); // Usar tamaño del tipo resultante
-    string suffix = getSuffix(size);
-    string regAx = getReg("rax", size);
-    string regCx = getReg("rcx", size);
+    Operando ax = R(RAX, size);
+    Operando cx = R(RCX, size);
 
     switch (exp->op) {
-        case PLUS_OP:  out << " add" << suffix << " " << regCx << ", " << regAx << "\n"; break;
-        case MINUS_OP: out << " sub" << suffix << " " << regCx << ", " << regAx << "\n"; break;
-        case MUL_OP:   out << " imul" << suffix << " " << regCx << ", " << regAx << "\n"; break;
-        case DIV_OP:   
-            if (size == 1) out << " cbw\n idivb " << regCx << "\n";
-            else if (size == 2) out << " cwd\n idivw " << regCx << "\n";
-            else if (size == 4) out << " cdq\n idivl " << regCx << "\n";
-            else out << " cqo\n idivq " << regCx << "\n";
-            break; 
-        case MOD_OP:   
-            if (size == 1) out << " cbw\n idivb " << regCx << "\n movzbq %ah, %rax\n"; // Remainder in AH
-            else if (size == 2) out << " cwd\n idivw " << regCx << "\n movzwq %dx, %rax\n"; // Remainder in DX
-            else if (size == 4) out << " cdq\n idivl " << regCx << "\n movslq %edx, %rax\n"; // Remainder in EDX
-            else out << " cqo\n idivq " << regCx << "\n movq %rdx, %rax\n"; // Remainder in RDX
-            break; 
-        case POW_OP:   out << " # WARNING: Operador POW (**) no implementado\n"; break;
-
-        // Operadores de Comparación
-        case LE_OP:
-            out << " cmp" << suffix << " " << regCx << ", " << regAx << "\n"
-                      << " movl $0, %eax\n"
-                      << " setle %al\n"
-                      << " movzbq %al, %rax\n";
-            break;
-        case LT_OP:
-            out << " cmp" << suffix << " " << regCx << ", " << regAx << "\n"
-                      << " movl $0, %eax\n"
-                      << " setl %al\n"
-                      << " movzbq %al, %rax\n";
-            break;
-        case GT_OP:
-            out << " cmp" << suffix << " " << regCx << ", " << regAx << "\n"
-                      << " movl $0, %eax\n"
-                      << " setg %al\n"
-                      << " movzbq %al, %rax\n";
-            break;
-        case GE_OP:
-            out << " cmp" << suffix << " " << regCx << ", " << regAx << "\n"
-                      << " movl $0, %eax\n"
-                      << " setge %al\n"
-                      << " movzbq %al, %rax\n";
-            break;
-        case EQ_OP:
-            out << " cmp" << suffix << " " << regCx << ", " << regAx << "\n"
-                      << " movl $0, %eax\n"
-                      << " sete %al\n"
-                      << " movzbq %al, %rax\n";
-            break;
-        case NE_OP:
-            out << " cmp" << suffix << " " << regCx << ", " << regAx << "\n"
-                      << " movl $0, %eax\n"
-                      << " setne %al\n"
-                      << " movzbq %al, %rax\n";
+        case PLUS_OP:  out.emit(ADD, cx, ax); break;
+        case MINUS_OP: out.emit(SUB, cx, ax); break;
+        // imul no tiene forma de dos operandos de 8 bits: el byte bajo es el mismo con 32
+        case MUL_OP:   out.emit(IMUL, size == 1 ? R(RCX, 4) : cx, size == 1 ? R(RAX, 4) : ax); break;
+        case DIV_OP:
+        case MOD_OP:
+            if (esSinSigno(exp->inferredType)) {
+                // La parte alta del dividendo en cero (con 1 byte es AH)
+                if (size == 1) out.emit(MOVZX, R(RAX, 1), R(RAX, 4));
+                else out.emit(XOR, R(RDX, 4), R(RDX, 4));
+                out.emit(DIV, cx);
+            } else {
+                out.emit(EXTSIGNO, ax); // cbw/cwd/cdq/cqo
+                out.emit(IDIV, cx);
+            }
+            if (exp->op == DIV_OP) break;
+            if (size == 1) out.emit(MOVZX, R(AH, 1), R(RAX, 4)); // Resto en AH (sin REX: movzbl)
+            else if (size == 2) out.emit(MOVZX, R(RDX, 2), R(RAX)); // Resto en DX
+            else if (size == 4 && esSinSigno(exp->inferredType)) out.emit(MOV, R(RDX, 4), R(RAX, 4)); // Resto en EDX
+            else if (size == 4) out.emit(MOVSX, R(RDX, 4), R(RAX));
+            else out.emit(MOV, R(RDX), R(RAX)); // Resto en RDX
             break;
-        // Operadores Lógicos (simplificados)
-        case AND_OP: out << " and" << suffix << " " << regCx << ", " << regAx << "\n"; break;
-        case OR_OP:  out << " or" << suffix << " " << regCx << ", " << regAx << "\n"; break;
+        // Lógicos sin saltos: ambos operandos ya son 0/1
+        case AND_OP: out.emit(AND, cx, ax); break;
+        case OR_OP:  out.emit(OR, cx, ax); break;
         default: break;
     }
     return 0;
 }
 
 int GenCodeVisitor::visit(AssignExp* stm) {
-    stm->e->accept(this);
-    Type* destType = nullptr;
-    if (memoriaGlobal.count(stm->id)) {
-        if (tiposGlobales.count(stm->id)) destType = tiposGlobales[stm->id];
-    } else {
-        destType = typeEnv.lookup(stm->id);
-    }
+    dispatch(stm->e);
+    Type* destType = stm->sym->tipo;
     convertValueTo(stm->e->inferredType, destType, out);
     int size = getTypeSize(destType ? destType : stm->e->inferredType);
-    string reg = getReg("rax", size);
-
-    if (memoriaGlobal.count(stm->id))
-        out << " mov" << getSuffix(size) << " " << reg << ", " << stm->id << "(%rip)"<<endl;
-    else {
-        int varOffset = env.lookup(stm->id);
-        out << " mov" << getSuffix(size) << " " << reg << ", " << varOffset << "(%rbp)"<<endl;
-    }
+    out.emit(MOV, R(RAX, size), direccion(stm->sym, size, out));
     return 0;
 }
 
 int GenCodeVisitor::visit(PrintStm* stm) {
-    stm->e->accept(this); 
+    dispatch(stm->e);
 
-    StringExp* stringExp = dynamic_cast<StringExp*>(stm->e); 
+    StringExp* stringExp = dynamic_cast<StringExp*>(stm->e);
 
     if (stringExp) {
-        out << " movq %rax, %rsi\n"; 
-        out << " leaq print_fmt_str(%rip), %rdi\n"; 
-        out << " movl $0, %eax\n";
+        out.emit(MOV, R(RAX), R(RSI));
+        out.emit(LEA, out.global("print_fmt_str", 8), R(RDI));
+        out.emit(MOV, Inm(0), R(RAX, 4));
     } else if (stm->e->inferredType && (stm->e->inferredType->ttype == Type::DOUBLE || stm->e->inferredType->ttype == Type::FLOAT)) {
         if (stm->e->inferredType->ttype == Type::FLOAT) {
-            out << " movd %eax, %xmm0\n";
-            out << " cvtss2sd %xmm0, %xmm0\n";
+            out.emit(MOV, R(RAX, 4), R(XMM0, 4));
+            out.emit(CVTSS2SD, R(XMM0), R(XMM0));
         } else {
-            out << " movq %rax, %xmm0\n"; 
+            out.emit(MOV, R(RAX), R(XMM0));
         }
-        out << " leaq print_fmt_float(%rip), %rdi\n"; 
-        out << " movl $1, %eax\n";
+        out.emit(LEA, out.global("print_fmt_float", 8), R(RDI));
+        out.emit(MOV, Inm(1), R(RAX, 4));
     } else {
-        // Asegurar extensión de signo a 64 bits para printf
+        // Asegurar extensión (de signo o de ceros) a 64 bits para printf
         int size = getTypeSize(stm->e->inferredType);
-        if (size == 1) out << " movsbq %al, %rsi\n";
-        else if (size == 2) out << " movswq %ax, %rsi\n";
-        else if (size == 4) out << " movslq %eax, %rsi\n";
-        else out << " movq %rax, %rsi\n"; 
-        
-        out << " leaq print_fmt_num(%rip), %rdi\n"; 
-        out << " movl $0, %eax\n";
+        bool isUnsigned = esSinSigno(stm->e->inferredType);
+        if (size == 8) out.emit(MOV, R(RAX), R(RSI));
+        else if (size == 4 && isUnsigned) out.emit(MOV, R(RAX, 4), R(RSI, 4));
+        else out.emit(isUnsigned ? MOVZX : MOVSX, R(RAX, size), R(RSI));
+
+        out.emit(LEA, out.global("print_fmt_num", 8), R(RDI));
+        out.emit(MOV, Inm(0), R(RAX, 4));
     }
-    
-    out << " call printf@PLT\n";
+
+    out.emit(CALL, out.etiq("printf@PLT"));
     return 0;
 }
 
+static bool esEnteroNoReal(Type* t) {
+    return t && t->isNumeric() && t->ttype != Type::DOUBLE && t->ttype != Type::FLOAT;
+}
+
+static bool leeA(Exp* e, Symbol* sym) {
+    return e->kind == NODE_ID && static_cast<IdExp*>(e)->sym == sym;
+}
+
+// `x = x + k`, `x = k + x` o `x = x - k` como sentencia (el valor no se usa):
+// un add/sub directo sobre la variable. `k` es una constante o una variable
+// entera al menos tan ancha como `x`; los bits bajos de la suma no dependen
+// del ancho en que se haga, así que truncar al final da lo mismo
+static bool acumularEnSitio(AssignExp* a, CodigoX86& out) {
+    Type* tipo = a->sym->tipo;
+    if (!esEnteroNoReal(tipo) || a->e->kind != NODE_BINARY || a->e->isnumber) return false;
+    BinaryExp* b = static_cast<BinaryExp*>(a->e);
+    if ((b->op != PLUS_OP && b->op != MINUS_OP) || !esEnteroNoReal(b->inferredType)) return false;
+    Exp* otro;
+    if (leeA(b->left, a->sym)) otro = b->right;
+    else if (b->op == PLUS_OP && leeA(b->right, a->sym)) otro = b->left;
+    else return false;
+
+    int size = getTypeSize(tipo);
+    Operando fuente;
+    long long k;
+    if (inmediatoDeBucle(otro, tipo, k)) {
+        fuente = Inm(k);
+    } else if (otro->kind == NODE_ID) {
+        Symbol* y = static_cast<IdExp*>(otro)->sym;
+        if (!y || !esEnteroNoReal(y->tipo) || getTypeSize(y->tipo) < size) return false;
+        fuente = direccion(y, size, out);
+    } else {
+        return false;
+    }
+    Operando destino = direccion(a->sym, size, out);
+    if (fuente.tipo == Operando::MEM && destino.tipo == Operando::MEM) {
+        out.emit(MOV, fuente, R(RCX, size));
+        fuente = R(RCX, size);
+    }
+    out.emit(b->op == PLUS_OP ? ADD : SUB, fuente, destino);
+    return true;
+}
+
 int GenCodeVisitor::visit(Block* b) {
-    env.add_level(); // Nuevo alcance
-    typeEnv.add_level();
     for (auto s : b->stmts){
-        s->accept(this);
+        if (s->kind == NODE_ASSIGN && acumularEnSitio(static_cast<AssignExp*>(s), out)) continue;
+        dispatch(s);
     }
-    env.remove_level(); // Fin de alcance
-    typeEnv.remove_level();
     return 0;
 }
 
 int GenCodeVisitor::visit(IfStmt* stm) {
-    // Dead code elimination cuando la condición es constante
-    if (stm->condition->isnumber) {
-        if (stm->condition->valor != 0) {
-            stm->thenBlock->accept(this);
-        } else if (stm->elseBlock) {
-            stm->elseBlock->accept(this);
-        }
-        return 0;
-    }
-
     int label = labelcont++;
-    stm->condition->accept(this);
-    out << " cmpq $0, %rax"<<endl;
-    out << " je else_" << label << endl;
-    stm->thenBlock->accept(this);
-    out << " jmp endif_" << label << endl;
-    out << "else_" << label << ":"<< endl;
-    if (stm->elseBlock) stm->elseBlock->accept(this);
-    out << "endif_" << label << ":"<< endl;
+    saltarSi(stm->condition, false, out.etiq("else_", label));
+    dispatch(stm->thenBlock);
+    if (stm->elseBlock) {
+        out.emit(JMP, out.etiq("endif_", label));
+        out.etiqueta(out.etiq("else_", label));
+        dispatch(stm->elseBlock);
+        out.etiqueta(out.etiq("endif_", label));
+    } else {
+        out.etiqueta(out.etiq("else_", label));
+    }
     return 0;
 }
 
+// La condición va al final del cuerpo: cada vuelta es el cuerpo, un
+// `cmp` y un `jcc` hacia atrás, sin el `jmp` de regreso
 int GenCodeVisitor::visit(WhileStmt* stm) {
     int label = labelcont++;
-    out << "while_" << label << ":"<<endl;
-    stm->condition->accept(this);
-    out << " cmpq $0, %rax" << endl;
-    out << " je endwhile_" << label << endl;
-    stm->block->accept(this);
-    out << " jmp while_" << label << endl;
-    out << "endwhile_" << label << ":"<< endl;
+    out.emit(JMP, out.etiq("whilecond_", label));
+    out.etiqueta(out.etiq("while_", label));
+    dispatch(stm->block);
+    out.etiqueta(out.etiq("whilecond_", label));
+    saltarSi(stm->condition, true, out.etiq("while_", label));
     return 0;
 }
 
 int GenCodeVisitor::visit(ForStmt* stm) {
     int label = labelcont++;
-    int saved_offset = offset;
-    
-    env.add_level(); // Scope for loop variable
-    typeEnv.add_level();
-
-    Exp* range = stm->rangeExp;
-    Exp* start = nullptr;
-    Exp* end = nullptr;
-    Exp* step = nullptr;
-    bool isDownTo = false;
-    
-    BinaryExp* stepExp = dynamic_cast<BinaryExp*>(range);
-    if (stepExp && stepExp->op == STEP_OP) {
-        step = stepExp->right;
-        range = stepExp->left; 
-    }
-    
-    BinaryExp* rangeBin = dynamic_cast<BinaryExp*>(range);
-    if (rangeBin) {
-        if (rangeBin->op == RANGE_OP) {
-            start = rangeBin->left;
-            end = rangeBin->right;
-            isDownTo = false;
-        } else if (rangeBin->op == DOWNTO_OP) {
-            start = rangeBin->left;
-            end = rangeBin->right;
-            isDownTo = true;
-        }
+    RangoFor r = rangoDe(stm);
+
+    // El contador, el límite y el paso tienen el tipo que fijó el TypeChecker
+    Type* tipo = stm->varSym->tipo;
+    int size = getTypeSize(tipo);
+    Operando ax = R(RAX, size);
+    Operando cx = R(RCX, size);
+
+    // El inicio va directo a la variable; límite y paso a sus slots ocultos,
+    // salvo que sean constantes: entonces van como inmediatos del cmp/add
+    Operando varAddr = direccion(stm->varSym, size, out);
+    long long limite = 0, paso = 0;
+    bool limiteInm = inmediatoDeBucle(r.limite, tipo, limite);
+    bool pasoInm = inmediatoDeBucle(r.paso, tipo, paso);
+    Operando endAddr = limiteInm ? Inm(limite) : direccion(stm->endSym, size, out);
+    Operando stepAddr = pasoInm ? Inm(paso) : direccion(stm->stepSym, size, out);
+
+    dispatch(r.inicio);
+    convertValueTo(r.inicio->inferredType, tipo, out);
+    out.emit(MOV, ax, varAddr);
+
+    if (!limiteInm) {
+        dispatch(r.limite);
+        convertValueTo(r.limite->inferredType, tipo, out);
+        out.emit(MOV, ax, endAddr);
     }
-    
-    if (!start || !end) {
-        start = new NumberExp(0); 
+    if (!pasoInm) {
+        dispatch(r.paso);
+        convertValueTo(r.paso->inferredType, tipo, out);
+        out.emit(MOV, ax, stepAddr);
     }
 
-    // Determine type size for loop variable (assume Int or based on range start)
-    // Ideally we should check inferredType of start/end.
-    // For now, let's assume Int (4 bytes) as standard for loops unless specified otherwise.
-    // Or better, check start->inferredType.
-    int size = 4; 
-    if (start->inferredType) size = getTypeSize(start->inferredType);
-
-    string suffix = getSuffix(size);
-    string regAx = getReg("rax", size);
-    string regCx = getReg("rcx", size);
-
-    start->accept(this);
-    int start_offset = offset;
-    offset -= 8;
-    out << " mov" << suffix << " " << regAx << ", " << start_offset << "(%rbp)\n";
-    
-    end->accept(this);
-    int end_offset = offset;
-    offset -= 8;
-    out << " mov" << suffix << " " << regAx << ", " << end_offset << "(%rbp)\n";
-    
-    int step_offset = offset;
-    offset -= 8;
-    if (step) {
-        step->accept(this);
-    } else {
-        out << " mov" << suffix << " $1, " << regAx << "\n";
-    }
-    out << " mov" << suffix << " " << regAx << ", " << step_offset << "(%rbp)\n";
-
-    string var = stm->varName;
-    // Add loop variable to environment
-    env.add_var(var, offset);
-    static Type loopInt(Type::INT);
-    typeEnv.add_var(var, &loopInt);
-    int varOffset = offset;
-    offset -= 8;
-    
-    out << " mov" << suffix << " " << start_offset << "(%rbp), " << regAx << "\n";
-    out << " mov" << suffix << " " << regAx << ", " << varOffset << "(%rbp)\n";
-    
-    out << "loop_" << label << ":\n";
-    
-    out << " mov" << suffix << " " << varOffset << "(%rbp), " << regAx << "\n"; 
-    out << " mov" << suffix << " " << end_offset << "(%rbp), " << regCx << "\n";   
-    out << " cmp" << suffix << " " << regCx << ", " << regAx << "\n"; 
-    
-    if (isDownTo) {
-        out << " jl endloop_" << label << "\n"; 
+    // Como el while: la comparación con el límite cierra cada vuelta
+    out.emit(JMP, out.etiq("loopcond_", label));
+    out.etiqueta(out.etiq("loop_", label));
+
+    dispatch(stm->block);
+
+    // add/sub y cmp operan directo sobre el contador; RCX/RAX solo hacen
+    // falta si los dos operandos quedaron en memoria
+    Op incremento = r.descendente ? SUB : ADD;
+    if (stepAddr.tipo == Operando::MEM && varAddr.tipo == Operando::MEM) {
+        out.emit(MOV, stepAddr, cx);
+        out.emit(incremento, cx, varAddr);
     } else {
-        out << " jg endloop_" << label << "\n";
+        out.emit(incremento, stepAddr, varAddr);
     }
-    
-    stm->block->accept(this);
-    
-    out << " mov" << suffix << " " << varOffset << "(%rbp), " << regAx << "\n";
-    out << " mov" << suffix << " " << step_offset << "(%rbp), " << regCx << "\n";
-    if (isDownTo) {
-        out << " sub" << suffix << " " << regCx << ", " << regAx << "\n"; 
+
+    out.etiqueta(out.etiq("loopcond_", label));
+    if (endAddr.tipo == Operando::MEM && varAddr.tipo == Operando::MEM) {
+        out.emit(MOV, varAddr, ax);
+        out.emit(CMP, endAddr, ax);
     } else {
-        out << " add" << suffix << " " << regCx << ", " << regAx << "\n"; 
+        out.emit(CMP, endAddr, varAddr);
     }
-    out << " mov" << suffix << " " << regAx << ", " << varOffset << "(%rbp)\n";
-    
-    out << " jmp loop_" << label << "\n";
-    
-    out << "endloop_" << label << ":\n";
-    
-    env.remove_level(); // End loop scope
-    typeEnv.remove_level();
-    offset = saved_offset;
+    out.jcc(r.descendente ? CC_GE : CC_LE, out.etiq("loop_", label));
     return 0;
 }
 
+static const Reg argRegs[] = {RDI, RSI, RDX, RCX, R8, R9}; // Registros de argumento (System V)
+static const int NUM_ARG_REGS = 6;
+
 int GenCodeVisitor::visit(FunDec* f) {
-    entornoFuncion = true; // Set function context
-    offset = -8;
     nombreFuncion = f->nombre;
-    vector<std::string> argRegs = {"rdi", "rsi", "rdx", "rcx", "r8", "r9"}; // Registros base
-    out << ".globl " << f->nombre << endl;
-    out <<f->nombre<<":" << endl;
-    out << " pushq %rbp" << endl;
-    out << " movq %rsp, %rbp" << endl;
-    
-    env.add_level(); // Scope for function arguments and local variables
-    typeEnv.add_level();
-    
+    funcionActual = f;
+    out.globl(f->nombre);
+    out.etiqueta(out.etiq(f->nombre));
+    out.emit(PUSH, R(RBP));
+    out.emit(MOV, R(RSP), R(RBP));
+    // Reserva exacta calculada por FrameLayout, antes de guardar los
+    // parámetros: nada se escribe por debajo de %rsp
+    out.emit(SUB, Inm(f->tamMarco), R(RSP));
+    for (size_t i = 0; i < f->salvados.size(); ++i)
+        out.emit(MOV, R(static_cast<Reg>(f->salvados[i])), Mem(RBP, offsetSalvado(i), 8));
+
     int size = f->Pnombres.size();
     for (int i = 0; i < size; i++) {
-        Type* t = new Type();
-        t->set_basic_type(f->Ptipos[i]);
-        env.add_var(f->Pnombres[i], offset);
-        typeEnv.add_var(f->Pnombres[i], t);
-        
+        Type* t = f->params[i]->tipo;
         int argSize = getTypeSize(t);
-        string reg = getReg(argRegs[i], argSize);
-        string suffix = getSuffix(argSize);
+        Operando addr = direccion(f->params[i], argSize, out);
 
-        if (i < argRegs.size()) {
-            out << " mov" << suffix << " " << reg << "," << offset << "(%rbp)" << endl;
+        if (i < NUM_ARG_REGS) {
+            out.emit(MOV, R(argRegs[i], argSize), addr);
         } else {
             // Los argumentos en la pila son de 8 bytes en x86-64
-            int arg_stack_pos = 16 + (i - (int)argRegs.size()) * 8; 
-            out << " movq " << arg_stack_pos << "(%rbp), %rax\n"; // Leer 8 bytes de la pila
+            int arg_stack_pos = 16 + (i - NUM_ARG_REGS) * 8;
+            out.emit(MOV, Mem(RBP, arg_stack_pos, 8), R(RAX)); // Leer 8 bytes de la pila
             // Guardar en variable local, posiblemente de menor tamaño
-            string regAx = getReg("rax", argSize);
-            out << " mov" << suffix << " " << regAx << ", " << offset << "(%rbp)" << endl;
+            out.emit(MOV, R(RAX, argSize), addr);
         }
-        offset -= 8;
-    }
-    
-    // Calcular la reserva según la cantidad de variables
-    int numVars = 0;
-    if (functionVarCounts.count(f->nombre)) {
-        numVars = functionVarCounts[f->nombre];
-    } else {
-        numVars = 16; // Valor por defecto
     }
 
-    int reserva = (numVars * 8 + 15) / 16 * 16; // Redondear al múltiplo de 16
-    
-    out << " subq $" << reserva << ", %rsp" << endl;
-    
-    f->cuerpo->accept(this);
-    
-    out << ".end_"<< f->nombre << ":"<< endl;
-    out << "leave" << endl;
-    out << "ret" << endl;
-    env.remove_level(); // Remove argument scope
-    typeEnv.remove_level();
-    entornoFuncion = false;
+    dispatch(f->cuerpo);
+
+    out.etiqueta(out.etiq(".end_" + f->nombre));
+    emitRetorno(f, out);
     return 0;
 }
 
 int GenCodeVisitor::visit(ReturnStm* stm) {
     if (stm->e) {
-        stm->e->accept(this); 
+        dispatch(stm->e);
     }
-    out << " leave\n";
-    out << " ret\n";
+    emitRetorno(funcionActual, out);
     return 0;
 }
 
 int GenCodeVisitor::visit(FcallExp* exp) {
     if (exp->receiver) {
+        // Conversión de una constante: ya plegada en compilación
+        if (exp->isnumber) {
+            emitConstant(exp, out);
+            return 0;
+        }
+
         // Evaluate receiver first
-        exp->receiver->accept(this);
+        dispatch(exp->receiver);
 
         Type* targetType = exp->inferredType;
         Type* sourceType = exp->receiver->inferredType;
         int targetSize = getTypeSize(targetType);
         int sourceSize = getTypeSize(sourceType);
-        bool isUnsigned = targetType && (
-            targetType->ttype == Type::UBYTE ||
-            targetType->ttype == Type::USHORT ||
-            targetType->ttype == Type::UINT ||
-            targetType->ttype == Type::ULONG
-        );
-        bool isUnsignedSrc = sourceType && (
-            sourceType->ttype == Type::UBYTE ||
-            sourceType->ttype == Type::USHORT ||
-            sourceType->ttype == Type::UINT ||
-            sourceType->ttype == Type::ULONG
-        );
+        bool isUnsignedSrc = esSinSigno(sourceType);
 
         // Floating targets
         if (targetType && (targetType->ttype == Type::DOUBLE || targetType->ttype == Type::FLOAT)) {
             // Si la fuente ya es float/double, usar conversion adecuada
             if (sourceType && (sourceType->ttype == Type::DOUBLE || sourceType->ttype == Type::FLOAT)) {
-                out << " movq %rax, %xmm0\n";
+                out.emit(MOV, R(RAX), R(XMM0));
                 if (sourceType->ttype == Type::DOUBLE && targetType->ttype == Type::FLOAT) {
-                    out << " cvtsd2ss %xmm0, %xmm0\n";
+                    out.emit(CVTSD2SS, R(XMM0), R(XMM0));
                 } else if (sourceType->ttype == Type::FLOAT && targetType->ttype == Type::DOUBLE) {
-                    out << " cvtss2sd %xmm0, %xmm0\n";
+                    out.emit(CVTSS2SD, R(XMM0), R(XMM0));
                 }
-                out << " movq %xmm0, %rax\n";
+                out.emit(MOV, R(XMM0), R(RAX));
                 return 0;
             }
 
-            // Fuente entera -> float/double
-            if (isUnsignedSrc) {
-                if (sourceSize == 1) out << " movzbq %al, %rax\n";
-                else if (sourceSize == 2) out << " movzwq %ax, %rax\n";
-                else out << " movl %eax, %eax\n";
-            } else {
-                if (sourceSize == 1) out << " movsbq %al, %rax\n";
-                else if (sourceSize == 2) out << " movswq %ax, %rax\n";
-                else out << " movslq %eax, %rax\n";
-            }
-            if (targetType->ttype == Type::DOUBLE) {
-                out << " cvtsi2sdq %rax, %xmm0\n";
+            // Fuente entera -> float/double (un ULong a Float pasa por double)
+            if (sourceType->ttype == Type::ULONG) {
+                enteroADouble(sourceType, out);
+                if (targetType->ttype == Type::FLOAT) out.emit(CVTSD2SS, R(XMM0), R(XMM0));
             } else {
-                out << " cvtsi2ssq %rax, %xmm0\n";
+                extenderRax(sourceSize, isUnsignedSrc, out);
+                out.emit(targetType->ttype == Type::DOUBLE ? CVTSI2SD : CVTSI2SS, R(RAX), R(XMM0));
             }
-            out << " movq %xmm0, %rax\n";
+            out.emit(MOV, R(XMM0), R(RAX));
             return 0;
         }
 
         // Fuente float/double -> entero
-        if (sourceType && (sourceType->ttype == Type::DOUBLE || sourceType->ttype == Type::FLOAT) && !(targetType && (targetType->ttype == Type::DOUBLE || targetType->ttype == Type::FLOAT))) {
-            out << " movq %rax, %xmm0\n";
-            if (targetSize == 8) {
-                out << (sourceType->ttype == Type::DOUBLE ? " cvttsd2siq %xmm0, %rax\n" : " cvttss2siq %xmm0, %rax\n");
-            } else {
-                out << (sourceType->ttype == Type::DOUBLE ? " cvttsd2si %xmm0, %eax\n" : " cvttss2si %xmm0, %eax\n");
-            }
-            // Ajustar tamaño destino
-            if (targetSize == 1) out << " movsbq %al, %rax\n";
-            else if (targetSize == 2) out << " movswq %ax, %rax\n";
-            else if (targetSize == 4) out << " movslq %eax, %rax\n";
+        if (sourceType && (sourceType->ttype == Type::DOUBLE || sourceType->ttype == Type::FLOAT)) {
+            out.emit(MOV, R(RAX), R(XMM0));
+            // Siempre en 64 bits, como constfold; luego se recorta al destino
+            out.emit(sourceType->ttype == Type::DOUBLE ? CVTTSD2SI : CVTTSS2SI, R(XMM0), R(RAX));
+            extenderRax(targetSize, false, out);
             return 0;
         }
 
         // Normalize value in RAX according to the destination type
-        if (targetSize == 1) {
-            out << (isUnsigned ? " movzbq %al, %rax\n" : " movsbq %al, %rax\n");
-        } else if (targetSize == 2) {
-            out << (isUnsigned ? " movzwq %ax, %rax\n" : " movswq %ax, %rax\n");
-        } else if (targetSize == 4) {
-            out << (isUnsigned ? " movl %eax, %eax\n" : " movslq %eax, %rax\n");
-        } else { // targetSize == 8
-            if (isUnsigned) {
-                if (sourceSize == 1) out << " movzbq %al, %rax\n";
-                else if (sourceSize == 2) out << " movzwq %ax, %rax\n";
-                else out << " movl %eax, %eax\n";
-            } else {
-                if (sourceSize == 1) out << " movsbq %al, %rax\n";
-                else if (sourceSize == 2) out << " movswq %ax, %rax\n";
-                else out << " movslq %eax, %rax\n";
-            }
-        }
+        enteroAEntero(sourceType, targetType, out);
         return 0;
     }
 
-    vector<std::string> argRegs = {"rdi", "rsi", "rdx", "rcx", "r8", "r9"}; // Registros base
     int size = exp->argumentos.size();
-    
-    int num_stack_args = max(0, size - (int)argRegs.size());
-    for (int i = size - 1; i >= (int)argRegs.size(); i--) {
-        exp->argumentos[i]->accept(this);
+
+    int num_stack_args = max(0, size - NUM_ARG_REGS);
+    for (int i = size - 1; i >= NUM_ARG_REGS; i--) {
+        dispatch(exp->argumentos[i]);
         // Push is always 64-bit, so we must ensure RAX has the value.
         // If accept returned a byte in AL, we should probably zero-extend it if we want to be safe,
         // but pushq %rax pushes whatever is in RAX.
         // For stack arguments, the callee expects them at specific offsets.
         // If callee expects Byte, it reads 1 byte.
-        out << " pushq %rax\n";
+        out.emit(PUSH, R(RAX));
+        ++enPila;
     }
 
-    for (int i = 0; i < min(size, (int)argRegs.size()); i++) {
-        exp->argumentos[i]->accept(this);
+    // Si un argumento posterior al primero usa temporales, pisaría los
+    // registros de argumento ya cargados: todos pasan antes por la pila
+    int enRegistros = min(size, NUM_ARG_REGS);
+    bool porPila = false;
+    for (int i = 1; i < enRegistros; i++)
+        if (usaTemporales(exp->argumentos[i])) porPila = true;
+
+    for (int i = 0; i < enRegistros; i++) {
+        dispatch(exp->argumentos[i]);
+        if (porPila) {
+            out.emit(PUSH, R(RAX));
+            ++enPila;
+            continue;
+        }
         int argSize = getTypeSize(exp->argumentos[i]->inferredType);
-        string reg = getReg(argRegs[i], argSize);
-        string regAx = getReg("rax", argSize);
-        out << " mov" << getSuffix(argSize) << " " << regAx << ", " << reg <<endl;
+        out.emit(MOV, R(RAX, argSize), R(argRegs[i], argSize));
+    }
+    if (porPila) {
+        for (int i = enRegistros - 1; i >= 0; i--)
+            out.emit(POP, R(argRegs[i]));
+        enPila -= enRegistros;
     }
 
-    out << " movl $0, %eax\n"; 
-    out << "call " << exp->nombre << endl;
+    out.emit(MOV, Inm(0), R(RAX, 4));
+    out.emit(CALL, out.etiq(exp->nombre));
 
     if (num_stack_args > 0) {
-        out << " addq $" << num_stack_args * 8 << ", %rsp\n";
+        out.emit(ADD, Inm(num_stack_args * 8), R(RSP));
+        enPila -= num_stack_args;
     }
-    
+
     return 0;
 }
@@ -1,12 +1,12 @@
 #ifndef VISITOR_H
 #define VISITOR_H
 #include "ast.h"
-#include "environment.h" // Agregado
+#include "static_visitor.h"
+#include "x86.h"
 #include <list>
 #include <vector>
 #include <unordered_map>
 #include <string>
-#include <ostream> // Incluir para std::ostream
 using namespace std;
 
 class BinaryExp;
@@ -50,26 +50,47 @@ public:
 };
 
 
-class GenCodeVisitor : public Visitor {
+// ¿El codegen usa algo más que RAX para evaluar `e`? (temporales, rcx/rdx
+// de una operación o una llamada)
+bool usaTemporales(Exp* e);
+// ¿Se puede omitir (o adelantar) su evaluación sin que se note? Sin
+// llamadas, asignaciones ni divisiones, que pueden fallar
+bool esOmitible(Exp* e);
+
+// `final` + StaticVisitor: los visit internos se despachan con un switch
+// sobre Stm::kind y pueden incluirse en línea (ver static_visitor.h)
+class GenCodeVisitor final : public Visitor, public StaticVisitor<GenCodeVisitor, int> {
 private:
-    std::ostream& out;
-    unordered_map<string, int> functionVarCounts; // Agregado
+    CodigoX86& out; // Instrucciones generadas, en orden
+    int temporalesEnUso = 0; // Registros del pool ocupados por operandos en espera
+    int enPila = 0; // Valores apilados sobre el marco: una llamada a la libm alinea %rsp a 16
+
+    // Evalúa `e` en RAX: como bits de double si `aDouble`; si no, extendido
+    // a `ancho` bytes cuando es más angosto
+    void cargarOperando(Exp* e, bool aDouble, int ancho);
+    // Deja el operando izquierdo de `e` en RAX y el derecho en RCX
+    // (como bits de double si `aDouble`)
+    void evaluarOperandos(BinaryExp* e, bool aDouble);
+    // Compara los operandos de `e` (LE_OP..NE_OP) y devuelve la condición
+    // que vale cuando la comparación es verdadera
+    Cond comparar(BinaryExp* e);
+    // Salta a `destino` si `cond` vale `valor`; si no, sigue de largo
+    void saltarSi(Exp* cond, bool valor, const Operando& destino);
+    // `x ** y`, resultado en RAX
+    void potencia(BinaryExp* e);
+    // `x * k`, `x / k` o `x % k` con `k` constante, resultado en RAX
+    void reducir(BinaryExp* e, Exp* constante, long long k);
 
 public:
-    GenCodeVisitor(std::ostream& out, unordered_map<string, int> counts) : out(out), functionVarCounts(counts) {}
+    GenCodeVisitor(CodigoX86& out) : out(out) {}
     int generar(Program* program);
 
-    // Contexto de generación de código
-    Environment<int> env; // Memoria de offsets
-    unordered_map<string, bool> memoriaGlobal;
-    unordered_map<string, Type*> tiposGlobales;
-    Environment<Type*> typeEnv; // Tipos locales
+    // Contexto de generación de código (las variables llegan resueltas a su Symbol)
     unordered_map<string, string> stringLiterals; // Pool de strings y etiquetas
     int stringCont = 0; // Contador de etiquetas de strings
-    int offset = -8;
     int labelcont = 0;
-    bool entornoFuncion = false;
     string nombreFuncion;
+    FunDec* funcionActual = nullptr; // Para el epílogo de cada return
 
     // Métodos de visita
     int visit(BinaryExp* exp) override;
@@ -0,0 +1,227 @@
+#include "x86.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace std;
+
+static const char* nombreReg(int reg, int tam) {
+    static const char* nombres[16][4] = {
+        {"%al", "%ax", "%eax", "%rax"},
+        {"%cl", "%cx", "%ecx", "%rcx"},
+        {"%dl", "%dx", "%edx", "%rdx"},
+        {"%bl", "%bx", "%ebx", "%rbx"},
+        {"%spl", "%sp", "%esp", "%rsp"},
+        {"%bpl", "%bp", "%ebp", "%rbp"},
+        {"%sil", "%si", "%esi", "%rsi"},
+        {"%dil", "%di", "%edi", "%rdi"},
+        {"%r8b", "%r8w", "%r8d", "%r8"},
+        {"%r9b", "%r9w", "%r9d", "%r9"},
+        {"%r10b", "%r10w", "%r10d", "%r10"},
+        {"%r11b", "%r11w", "%r11d", "%r11"},
+        {"%r12b", "%r12w", "%r12d", "%r12"},
+        {"%r13b", "%r13w", "%r13d", "%r13"},
+        {"%r14b", "%r14w", "%r14d", "%r14"},
+        {"%r15b", "%r15w", "%r15d", "%r15"},
+    };
+    if (reg == XMM0) return "%xmm0";
+    if (reg == XMM1) return "%xmm1";
+    if (reg == AH) return "%ah";
+    int i = tam == 1 ? 0 : tam == 2 ? 1 : tam == 4 ? 2 : 3;
+    return nombres[reg][i];
+}
+
+static char sufijo(int tam) {
+    return tam == 1 ? 'b' : tam == 2 ? 'w' : tam == 4 ? 'l' : 'q';
+}
+
+static const char* nombreCond(Cond cc) {
+    static const char* nombres[16] = {"o", "no", "b", "ae", "e", "ne", "be", "a",
+                                      "s", "ns", "p", "np", "l", "ge", "le", "g"};
+    return nombres[cc];
+}
+
+static bool esXmm(const Operando& o) {
+    return o.tipo == Operando::REG && (o.reg == XMM0 || o.reg == XMM1);
+}
+
+// ===========================================================
+//   Escritor
+// ===========================================================
+//
+// Escribe directo sobre un buffer de bytes. Antes de cada instrucción se
+// asegura espacio para la más larga posible, así las funciones de abajo
+// no comprueban límites.
+
+namespace {
+
+class Escritor {
+private:
+    const CodigoX86& codigo;
+    string buffer;
+    size_t pos = 0;
+
+public:
+    explicit Escritor(const CodigoX86& codigo) : codigo(codigo) {
+        // Unos 24 bytes por instrucción alcanzan para casi todos los programas
+        buffer.resize(codigo.instrs.size() * 24 + 4096);
+    }
+
+    void reservar(size_t n) {
+        if (pos + n > buffer.size()) buffer.resize(max(buffer.size() * 2, pos + n));
+    }
+
+    void c(char ch) { buffer[pos++] = ch; }
+
+    void s(const char* texto) {
+        size_t n = strlen(texto);
+        memcpy(&buffer[pos], texto, n);
+        pos += n;
+    }
+
+    void s(const string& texto) {
+        memcpy(&buffer[pos], texto.data(), texto.size());
+        pos += texto.size();
+    }
+
+    void entero(int64_t v) {
+        char tmp[24];
+        int n = 0;
+        uint64_t u = v < 0 ? 0 - static_cast<uint64_t>(v) : static_cast<uint64_t>(v);
+        do {
+            tmp[n++] = static_cast<char>('0' + u % 10);
+            u /= 10;
+        } while (u);
+        if (v < 0) c('-');
+        while (n) c(tmp[--n]);
+    }
+
+    void operando(const Operando& o) {
+        switch (o.tipo) {
+            case Operando::REG: s(nombreReg(o.reg, o.tam)); break;
+            case Operando::INM: c('$'); entero(o.valor); break;
+            case Operando::MEM:
+                if (o.reg == RIP) {
+                    s(codigo.simbolos[o.simbolo]);
+                    s("(%rip)");
+                } else {
+                    entero(o.valor);
+                    c('(');
+                    s(nombreReg(o.reg, 8));
+                    c(')');
+                }
+                break;
+            case Operando::ETIQ:
+                s(codigo.simbolos[o.simbolo]);
+                if (o.valor >= 0) entero(o.valor);
+                break;
+            default: break;
+        }
+    }
+
+    // " mnemonico" + sufijo opcional
+    void mnem(const char* m, char suf = 0) {
+        c(' ');
+        s(m);
+        if (suf) c(suf);
+    }
+
+    void uno(const Instr& i) {
+        c(' ');
+        operando(i.a);
+    }
+
+    void dos(const Instr& i) {
+        c(' ');
+        operando(i.a);
+        c(',');
+        c(' ');
+        operando(i.b);
+    }
+
+    void instr(const Instr& i) {
+        // Lo más largo: dos símbolos más mnemónico y operandos fijos
+        size_t largo = 64;
+        if (i.a.simbolo >= 0) largo += codigo.simbolos[i.a.simbolo].size();
+        if (i.b.simbolo >= 0) largo += codigo.simbolos[i.b.simbolo].size();
+        reservar(largo);
+
+        // Ancho de la operación: el del registro si hay uno, si no el de la memoria
+        int tam = i.b.tipo == Operando::REG && !esXmm(i.b) ? i.b.tam
+                : i.a.tipo == Operando::REG && !esXmm(i.a) ? i.a.tam
+                : i.b.tipo != Operando::NADA && i.b.tipo != Operando::INM ? i.b.tam : i.a.tam;
+        char suf = sufijo(tam);
+
+        switch (i.op) {
+            case ETIQUETA: operando(i.a); c(':'); break;
+            case DIRECTIVA:
+            case SECCION: s(codigo.simbolos[i.a.simbolo]); break;
+            case GLOBL: s(".globl "); operando(i.a); break;
+            case QUAD: operando(i.a); s(": .quad "); entero(i.b.valor); break;
+            case ASCIZ: operando(i.a); s(": .string \""); s(codigo.simbolos[i.b.simbolo]); c('"'); break;
+            case MOV:
+                if (esXmm(i.a) || esXmm(i.b)) mnem(tam == 4 ? "movd" : "movq");
+                // Inmediatos que no caben en 32 bits con signo
+                else if (i.a.tipo == Operando::INM && tam == 8 && (i.a.valor < INT32_MIN || i.a.valor > INT32_MAX)) mnem("movabsq");
+                else mnem("mov", suf);
+                dos(i);
+                break;
+            case MOVSX:
+                if (i.a.tam == 4) mnem("movslq");
+                else { mnem("movs", sufijo(i.a.tam)); c(sufijo(i.b.tam)); }
+                dos(i);
+                break;
+            case MOVZX: mnem("movz", sufijo(i.a.tam)); c(sufijo(i.b.tam)); dos(i); break;
+            case LEA: mnem("leaq"); dos(i); break;
+            case ADD: mnem("add", suf); dos(i); break;
+            case SUB: mnem("sub", suf); dos(i); break;
+            case IMUL: mnem("imul", suf); if (i.b.tipo == Operando::NADA) uno(i); else dos(i); break;
+            case AND: mnem("and", suf); dos(i); break;
+            case OR: mnem("or", suf); dos(i); break;
+            case XOR: mnem("xor", suf); dos(i); break;
+            case CMP: mnem("cmp", suf); dos(i); break;
+            case TEST: mnem("test", suf); dos(i); break;
+            case SHL: mnem("shl", suf); dos(i); break;
+            case SHR: mnem("shr", suf); dos(i); break;
+            case SAR: mnem("sar", suf); dos(i); break;
+            case NEG: mnem("neg", suf); uno(i); break;
+            case MUL: mnem("mul", suf); uno(i); break;
+            case IDIV: mnem("idiv", suf); uno(i); break;
+            case DIV: mnem("div", suf); uno(i); break;
+            case EXTSIGNO: mnem(i.a.tam == 1 ? "cbw" : i.a.tam == 2 ? "cwd" : i.a.tam == 4 ? "cdq" : "cqo"); break;
+            case PUSH: mnem("pushq"); uno(i); break;
+            case POP: mnem("popq"); uno(i); break;
+            case XCHG: mnem("xchg", suf); dos(i); break;
+            case SETCC: mnem("set"); s(nombreCond(i.cc)); uno(i); break;
+            case JCC: mnem("j"); s(nombreCond(i.cc)); uno(i); break;
+            case JMP: mnem("jmp"); uno(i); break;
+            case CALL: mnem("call"); uno(i); break;
+            case LEAVE: mnem("leave"); break;
+            case RET: mnem("ret"); break;
+            case CVTSI2SD: mnem("cvtsi2sd", sufijo(i.a.tam)); dos(i); break;
+            case CVTSI2SS: mnem("cvtsi2ss", sufijo(i.a.tam)); dos(i); break;
+            case CVTTSD2SI: mnem(i.b.tam == 8 ? "cvttsd2siq" : "cvttsd2si"); dos(i); break;
+            case CVTTSS2SI: mnem(i.b.tam == 8 ? "cvttss2siq" : "cvttss2si"); dos(i); break;
+            case CVTSS2SD: mnem("cvtss2sd"); dos(i); break;
+            case CVTSD2SS: mnem("cvtsd2ss"); dos(i); break;
+            case ADDSD: mnem("addsd"); dos(i); break;
+            case SUBSD: mnem("subsd"); dos(i); break;
+            case MULSD: mnem("mulsd"); dos(i); break;
+            case DIVSD: mnem("divsd"); dos(i); break;
+            case UCOMISD: mnem("ucomisd"); dos(i); break;
+        }
+        c('\n');
+    }
+
+    string terminar() {
+        buffer.resize(pos);
+        return std::move(buffer);
+    }
+};
+
+} // namespace
+
+string escribirEnsamblador(const CodigoX86& codigo) {
+    Escritor e(codigo);
+    for (auto& i : codigo.instrs) e.instr(i);
+    return e.terminar();
+}
@@ -0,0 +1,162 @@
+#ifndef X86_H
+#define X86_H
+
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+// ===========================================================
+//  Instrucciones x86-64
+// ===========================================================
+//
+// El codegen no escribe texto: agrega instrucciones a un CodigoX86. Sobre
+// esa lista corre el Peephole y al final escribirEnsamblador la pasa a
+// sintaxis AT&T. Los operandos siguen el orden AT&T: `a` es la fuente y
+// `b` el destino.
+
+// En el orden de su codificación; XMM y AH aparte
+enum Reg : uint8_t {
+    RAX, RCX, RDX, RBX, RSP, RBP, RSI, RDI,
+    R8, R9, R10, R11, R12, R13, R14, R15,
+    XMM0, XMM1, AH, RIP
+};
+
+// Códigos de condición con su número de codificación: invertir es `cc ^ 1`
+enum Cond : uint8_t {
+    CC_O, CC_NO, CC_B, CC_AE, CC_E, CC_NE, CC_BE, CC_A,
+    CC_S, CC_NS, CC_P, CC_NP, CC_L, CC_GE, CC_LE, CC_G
+};
+inline Cond invertir(Cond c) { return static_cast<Cond>(c ^ 1); }
+
+enum Op : uint8_t {
+    ETIQUETA,  // Definición de `a.simbolo`
+    DIRECTIVA, // Línea literal en `a.simbolo` (comentarios)
+    SECCION,   // `.data`, `.text` u otra sección, nombrada en `a.simbolo`
+    GLOBL,     // `.globl a`
+    QUAD,      // `a: .quad b.valor`
+    ASCIZ,     // `a: .string "b"` (el texto va tal cual, con sus escapes)
+    MOV, MOVSX, MOVZX, LEA,
+    ADD, SUB, IMUL, AND, OR, XOR, CMP, TEST,
+    SHL, SHR, SAR, // Desplazamientos de `b` en `a.valor` bits (SHR lógico, SAR aritmético)
+    NEG,       // a = -a
+    MUL,       // RDX:RAX = RAX * a sin signo (IMUL sin `b`: lo mismo con signo)
+    IDIV, DIV, // RAX, RDX = RDX:RAX / a con y sin signo
+    EXTSIGNO,  // cbw/cwd/cdq/cqo según `a.tam`
+    PUSH, POP, XCHG,
+    SETCC, JCC, JMP, CALL, LEAVE, RET,
+    CVTSI2SD, CVTSI2SS, CVTTSD2SI, CVTTSS2SI, CVTSS2SD, CVTSD2SS,
+    ADDSD, SUBSD, MULSD, DIVSD, UCOMISD,
+};
+
+// Etiquetas, directivas y datos: no son instrucciones que se ejecuten
+inline bool esPseudo(Op op) { return op <= ASCIZ; }
+
+// Registro compacto (16 bytes): los nombres viven una sola vez en la tabla
+// de símbolos de CodigoX86 y el operando guarda su índice
+struct Operando {
+    enum Tipo : uint8_t { NADA, REG, INM, MEM, ETIQ };
+    Tipo tipo = NADA;
+    uint8_t reg = 0;      // REG: registro; MEM: base (RBP, RSP o RIP)
+    uint8_t tam = 8;      // Ancho del acceso en bytes
+    int32_t simbolo = -1; // MEM relativa a RIP y ETIQ: índice en la tabla
+    int64_t valor = 0;    // INM: valor; MEM: desplazamiento; ETIQ: número (-1: sin número)
+
+    bool operator==(const Operando& o) const {
+        return tipo == o.tipo && reg == o.reg && tam == o.tam && valor == o.valor && simbolo == o.simbolo;
+    }
+    bool operator!=(const Operando& o) const { return !(*this == o); }
+    bool esReg() const { return tipo == REG; }
+    bool esReg(Reg r) const { return tipo == REG && reg == r; }
+};
+static_assert(sizeof(Operando) == 16, "Operando debe seguir siendo compacto");
+
+inline Operando R(Reg r, int tam = 8) {
+    Operando o;
+    o.tipo = Operando::REG;
+    o.reg = r;
+    o.tam = static_cast<uint8_t>(tam);
+    return o;
+}
+
+inline Operando Inm(int64_t v) {
+    Operando o;
+    o.tipo = Operando::INM;
+    o.valor = v;
+    return o;
+}
+
+inline Operando Mem(Reg base, int64_t desplazamiento, int tam) {
+    Operando o;
+    o.tipo = Operando::MEM;
+    o.reg = base;
+    o.valor = desplazamiento;
+    o.tam = static_cast<uint8_t>(tam);
+    return o;
+}
+
+// Mismo registro con otro ancho
+inline Operando conTam(Operando o, int tam) {
+    o.tam = static_cast<uint8_t>(tam);
+    return o;
+}
+
+struct Instr {
+    Op op;
+    Cond cc = CC_O; // SETCC y JCC
+    Operando a, b;
+};
+
+class CodigoX86 {
+private:
+    unordered_map<string, int> indices;
+
+public:
+    vector<Instr> instrs;
+    vector<string> simbolos; // Etiquetas, funciones, globales, directivas y textos
+
+    // Índice del nombre en la tabla (lo agrega la primera vez)
+    int simbolo(const string& nombre) {
+        auto it = indices.find(nombre);
+        if (it != indices.end()) return it->second;
+        int i = static_cast<int>(simbolos.size());
+        simbolos.push_back(nombre);
+        indices.emplace(nombre, i);
+        return i;
+    }
+
+    // `nombre(%rip)`
+    Operando global(const string& nombre, int tam) {
+        Operando o = Mem(RIP, 0, tam);
+        o.simbolo = simbolo(nombre);
+        return o;
+    }
+    // `nombre`, o `prefijo` seguido de `numero` (else_3, loop_7...)
+    Operando etiq(const string& nombre, int64_t numero = -1) {
+        Operando o;
+        o.tipo = Operando::ETIQ;
+        o.simbolo = simbolo(nombre);
+        o.valor = numero;
+        return o;
+    }
+
+    void emit(Op op, const Operando& a = Operando(), const Operando& b = Operando()) {
+        instrs.push_back({op, CC_O, a, b});
+    }
+    void setcc(Cond cc, const Operando& destino) { instrs.push_back({SETCC, cc, destino, Operando()}); }
+    void jcc(Cond cc, const Operando& destino) { instrs.push_back({JCC, cc, destino, Operando()}); }
+    void etiqueta(const Operando& e) { emit(ETIQUETA, e); }
+    void directiva(const string& texto) { emit(DIRECTIVA, etiq(texto)); }
+    void seccion(const string& nombre) { emit(SECCION, etiq(nombre)); }
+    void globl(const string& nombre) { emit(GLOBL, etiq(nombre)); }
+    void quad(const string& nombre, int64_t valor) { emit(QUAD, etiq(nombre), Inm(valor)); }
+    void asciz(const string& nombre, const string& texto) { emit(ASCIZ, etiq(nombre), etiq(texto)); }
+};
+
+// Texto AT&T del programa completo. Se arma en un único buffer reservado de
+// antemano, sin un string por instrucción, para escribirlo con un solo write.
+string escribirEnsamblador(const CodigoX86& codigo);
+
+#endif // X86_H
@@ -2,6 +2,7 @@ import { NextResponse } from "next/server"
 import { promises as fs } from "fs"
 import path from "path"
 import { spawn } from "child_process"
+import { randomUUID } from "crypto"
 
 function toWslPath(winPath: string) {
   const normalized = winPath.replace(/\\/g, "/")
@@ -12,79 +13,74 @@ function toWslPath(winPath: string) {
   return `/mnt/${drive}/${rest}`
 }
 
-async function runCompiler(source: string) {
+// Cada sesión del editor guarda su caché de tipos (-fcache-tipos): al volver a
+// ejecutar solo se revisan las funciones que cambiaron o cuyas dependencias sí
+const SESSION_COOKIE = "kc_sesion"
+
+function sessionId(request: Request) {
+  const cookie = request.headers.get("cookie") ?? ""
+  const match = cookie.match(/(?:^|;\s*)kc_sesion=([0-9a-f-]{36})(?:;|$)/)
+  return match ? match[1] : randomUUID()
+}
+
+// Compila y ejecuta en un solo proceso: con --jit el compilador corre el
+// programa en memoria y su stdout es la salida del programa; con --interp lo
+// corre el intérprete de bytecode (sin generar código ejecutable)
+async function runCompiler(source: string, optLevel: number, execMode: "jit" | "interp", session: string) {
   const projectRoot = path.resolve(process.cwd(), "Kotlin-Compiler")
   const tmpDir = await fs.mkdtemp(path.join(projectRoot, "tmp-"))
   const inputPath = path.join(tmpDir, "input.kt")
   const asmPath = path.join(tmpDir, "input.s")
+  const cacheDir = path.join(projectRoot, "cache-tipos")
+  const cachePath = path.join(cacheDir, `${session}.txt`)
+  await fs.mkdir(cacheDir, { recursive: true })
 
   await fs.writeFile(inputPath, source, "utf8")
 
   const isWin = process.platform === "win32"
   const compilerPath = path.join(projectRoot, "main.exe")
 
-  await new Promise<void>((resolve, reject) => {
-    let cmd: string
-    let args: string[]
-    let options = {}
-
-    if (isWin) {
-      const wslProject = toWslPath(projectRoot)
-      const wslInput = toWslPath(inputPath)
-      cmd = "wsl"
-      args = ["bash", "-lc", `cd "${wslProject}" && ./main.exe "${wslInput}"`]
-    } else {
-      cmd = compilerPath
-      args = [inputPath]
-      options = { cwd: projectRoot }
-    }
-
-    const proc = spawn(cmd, args, options)
-    let stderr = ""
-    proc.stderr.on("data", (d) => (stderr += d.toString()))
-    proc.on("error", reject)
-    proc.on("close", (code) => {
-      if (code !== 0) reject(new Error(stderr || `Compiler exited with code ${code}`))
-      else resolve()
-    })
-  })
-
-  const assembly = await fs.readFile(asmPath, "utf8").catch(() => "")
-
-  return { assembly, asmPath, projectRoot, tmpDir }
-}
+  const { code, stdout, stderr } = await new Promise<{ code: number | null; stdout: string; stderr: string }>(
+    (resolve, reject) => {
+      let cmd: string
+      let args: string[]
+      let options = {}
+
+      if (isWin) {
+        const wslProject = toWslPath(projectRoot)
+        const wslInput = toWslPath(inputPath)
+        const wslCache = toWslPath(cachePath)
+        cmd = "wsl"
+        args = [
+          "bash",
+          "-lc",
+          `cd "${wslProject}" && ./main.exe --${execMode} -O${optLevel} "-fcache-tipos=${wslCache}" "${wslInput}"`,
+        ]
+      } else {
+        cmd = compilerPath
+        args = [`--${execMode}`, `-O${optLevel}`, `-fcache-tipos=${cachePath}`, inputPath]
+        options = { cwd: projectRoot }
+      }
 
-async function runAssembly(asmPath: string, projectRoot: string) {
-  const isWin = process.platform === "win32"
-  const exePath = asmPath.replace(/\.s$/, ".out")
-
-  return await new Promise<{ stdout: string }>((resolve, reject) => {
-    let cmd: string
-    let args: string[]
-    let options = {}
-
-    if (isWin) {
-      const wslAsm = toWslPath(asmPath)
-      const wslExe = toWslPath(exePath)
-      cmd = "wsl"
-      args = ["bash", "-lc", `g++ "${wslAsm}" -no-pie -o "${wslExe}" && "${wslExe}"`]
-    } else {
-      cmd = "bash"
-      args = ["-lc", `g++ "${asmPath}" -no-pie -o "${exePath}" && "${exePath}"`]
-      options = { cwd: projectRoot }
-    }
+      const proc = spawn(cmd, args, options)
+      let stderr = ""
+      let stdout = ""
+      proc.stderr.on("data", (d) => (stderr += d.toString()))
+      proc.stdout.on("data", (d) => (stdout += d.toString()))
+      proc.on("error", reject)
+      proc.on("close", (code) => resolve({ code, stdout, stderr }))
+    },
+  )
+
+  // El .s se escribe antes de ejecutar: si no está, falló la compilación
+  const assembly = await fs.readFile(asmPath, "utf8").catch(() => null)
+  if (assembly === null) {
+    fs.rm(tmpDir, { recursive: true, force: true }).catch(() => {})
+    throw new Error(stderr || `Compiler exited with code ${code}`)
+  }
 
-    const proc = spawn(cmd, args, options)
-    let stderr = ""
-    let stdout = ""
-    proc.stderr.on("data", (d) => (stderr += d.toString()))
-    proc.stdout.on("data", (d) => (stdout += d.toString()))
-    proc.on("error", reject)
-    proc.on("close", (code) => {
-      if (code !== 0) reject(new Error(stderr || `Runner exited with code ${code}`))
-      else resolve({ stdout })
-    })
-  })
+  // Si el programa falló al ejecutarse no se muestra su salida
+  return { assembly, stdout: code === 0 ? stdout : "", tmpDir }
 }
 
 export async function POST(request: Request) {
@@ -95,17 +91,17 @@ export async function POST(request: Request) {
       return NextResponse.json({ error: "Código vacío" }, { status: 400 })
     }
 
-    const { assembly, asmPath, projectRoot, tmpDir } = await runCompiler(source)
-    let execution_output = ""
+    // Nivel de optimización por petición: -O0 compila más rápido, -O2 genera mejor código
+    const requested = Number(body.opt_level ?? 1)
+    const optLevel = [0, 1, 2].includes(requested) ? requested : 1
+
+    // Modo de ejecución: "jit" (por defecto) o "interp"
+    const execMode = body.exec_mode === "interp" ? "interp" : "jit"
+
+    const session = sessionId(request)
+    const { assembly, stdout: stdout_raw, tmpDir } = await runCompiler(source, optLevel, execMode, session)
+    const execution_output = stdout_raw.trim()
     let stack_frames: Array<Array<{ register: string; value: string; type: string }>> = []
-    let stdout_raw = ""
-    try {
-      const result = await runAssembly(asmPath, projectRoot)
-      stdout_raw = result.stdout
-      execution_output = result.stdout.trim()
-    } catch (e) {
-      execution_output = ""
-    }
 
     fs.rm(tmpDir, { recursive: true, force: true }).catch(() => {})
 
@@ -128,7 +124,7 @@ export async function POST(request: Request) {
     }
     const stack_state = stack_frames[stack_frames.length - 1]
 
-    return NextResponse.json({
+    const response = NextResponse.json({
       assembly,
       x86: assembly,
       stdout: execution_output,
@@ -141,6 +137,8 @@ export async function POST(request: Request) {
       steps: execution_output ? [{ instruction: "program output", registers: {}, output: execution_output }] : [],
       stackState: [],
     })
+    response.cookies.set(SESSION_COOKIE, session, { httpOnly: true, sameSite: "lax", path: "/" })
+    return response
   } catch (error: any) {
     return NextResponse.json({ error: error?.message || "Error de compilación" }, { status: 500 })
   }